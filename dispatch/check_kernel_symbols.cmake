@@ -0,0 +1,89 @@
+# MIT License
+#
+# Copyright (c) 2022-2024 Paul Bowen-Huggett
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Checks that the kernel object files do not contain shared code which uses instructions beyond the baseline.
+#
+# The weak symbols defined by a kernel object file (out-of-line copies of standard library templates, for example)
+# may be chosen by the linker in place of the copies from any other object file. The code for each weak symbol that
+# is not in one of the icubaby_<level> namespaces is disassembled and rejected if it uses SSSE3, SSE4, AVX, or
+# AVX-512 instructions.
+#
+# Usage: cmake -D NM=<nm> -D OBJDUMP=<objdump> -D OBJECTS=<object files> -P check_kernel_symbols.cmake
+
+foreach (var NM OBJDUMP OBJECTS)
+  if (NOT DEFINED ${var})
+    message (FATAL_ERROR "${var} must be defined")
+  endif ()
+endforeach ()
+
+# VEX and EVEX encoded instructions, their registers, and SSSE3 and SSE4 instructions.
+set (isa_regex "\t(v[a-z]|(pshufb|palignr|pabs[bwd]|ph(add|sub)|pmaddubsw|pmulhrsw|psign[bwd]|ptest|pblendvb|pblendw|")
+string (APPEND isa_regex "blendv?p[sd]|pcmp[ei]str|pcmp(eq|gt)q|pm(in|ax)[su][bwd]|pmov[sz]x|pextr[bdq]|pinsr[bdq]|")
+string (APPEND isa_regex "pmulld|packusdw|round[ps][sd]|dpp[sd]|(insert|extract)ps|mpsadbw|phminposuw|crc32|popcnt) )|")
+string (APPEND isa_regex "%[yz]mm|%k[0-7]")
+
+set (failed No)
+foreach (object IN LISTS OBJECTS)
+  execute_process (
+    COMMAND "${NM}" --defined-only "${object}"
+    OUTPUT_VARIABLE symbols
+    COMMAND_ERROR_IS_FATAL ANY
+  )
+  string (REGEX MATCHALL "[^\n]* W [^\n]*" weak_lines "${symbols}")
+  set (weak)
+  foreach (line IN LISTS weak_lines)
+    string (REGEX REPLACE "^.* W " "" name "${line}")
+    if (NOT name MATCHES "icubaby_")
+      list (APPEND weak "${name}")
+    endif ()
+  endforeach ()
+
+  execute_process (
+    COMMAND "${OBJDUMP}" -d --no-show-raw-insn "${object}"
+    OUTPUT_VARIABLE disassembly
+    COMMAND_ERROR_IS_FATAL ANY
+  )
+  # Semicolons and square brackets would upset the list operations.
+  string (REGEX REPLACE "[][;]" " " disassembly "${disassembly}")
+  string (REPLACE "\n" ";" disassembly "${disassembly}")
+  set (symbol "")
+  set (check No)
+  foreach (line IN LISTS disassembly)
+    if (line MATCHES "^[0-9a-f]+ <(.+)>:$")
+      set (symbol "${CMAKE_MATCH_1}")
+      list (FIND weak "${symbol}" index)
+      if (index EQUAL -1)
+        set (check No)
+      else ()
+        set (check Yes)
+      endif ()
+    elseif (check AND line MATCHES "${isa_regex}")
+      message (SEND_ERROR "${object}: shared symbol ${symbol} uses instructions beyond the baseline:\n${line}")
+      set (failed Yes)
+      set (check No)  # Report each symbol once.
+    endif ()
+  endforeach ()
+endforeach ()
+
+if (failed)
+  message (FATAL_ERROR "Kernel object files must not contain shared code compiled for a higher instruction set")
+endif ()
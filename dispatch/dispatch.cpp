@@ -0,0 +1,213 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "icubaby/dispatch.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <optional>
+
+#if ICUBABY_DISPATCH_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#include "kernels.hpp"
+
+namespace {
+
+using icubaby::dispatch::level;
+using icubaby::dispatch::details::kernel_table;
+
+constexpr std::array<std::string_view, 4> level_names{{"scalar", "sse42", "avx2", "avx512"}};
+
+#if ICUBABY_DISPATCH_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+/// \returns  The highest level supported by the host CPU and operating system.
+level cpu_level () noexcept {
+  constexpr auto eax = std::size_t{0};
+  constexpr auto ebx = std::size_t{1};
+  constexpr auto ecx = std::size_t{2};
+  std::array<int, 4> regs{};
+  __cpuid (regs.data (), 0);
+  auto const max_leaf = regs[eax];
+  __cpuid (regs.data (), 1);
+  auto const leaf1_ecx = static_cast<unsigned> (regs[ecx]);
+  auto const has_sse42 = (leaf1_ecx & (1U << 20U)) != 0U;
+  auto const has_osxsave = (leaf1_ecx & (1U << 27U)) != 0U;
+  if (!has_sse42) {
+    return level::scalar;
+  }
+  if (!has_osxsave || max_leaf < 7) {
+    return level::sse42;
+  }
+  // The OS must save the YMM registers (XCR0 bits 1 and 2) for AVX2 and the opmask and ZMM registers (bits 5-7) for
+  // AVX-512.
+  auto const xcr0 = _xgetbv (0);
+  __cpuidex (regs.data (), 7, 0);
+  auto const leaf7_ebx = static_cast<unsigned> (regs[ebx]);
+  auto const leaf7_ecx = static_cast<unsigned> (regs[ecx]);
+  auto const has_avx2 = (xcr0 & 0x6U) == 0x6U && (leaf7_ebx & (1U << 5U)) != 0U;
+  if (!has_avx2) {
+    return level::sse42;
+  }
+  auto const has_avx512 = (xcr0 & 0xE6U) == 0xE6U && (leaf7_ebx & (1U << 16U)) != 0U /*F*/ &&
+                          (leaf7_ebx & (1U << 30U)) != 0U /*BW*/ && (leaf7_ebx & (1U << 31U)) != 0U /*VL*/ &&
+                          (leaf7_ecx & (1U << 6U)) != 0U /*VBMI2*/;
+  return has_avx512 ? level::avx512 : level::avx2;
+}
+#else
+/// \returns  The highest level supported by the host CPU and operating system.
+level cpu_level () noexcept {
+  __builtin_cpu_init ();
+  if (!__builtin_cpu_supports ("sse4.2")) {
+    return level::scalar;
+  }
+  if (!__builtin_cpu_supports ("avx2")) {
+    return level::sse42;
+  }
+  if (__builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512bw") &&
+      __builtin_cpu_supports ("avx512vl") && __builtin_cpu_supports ("avx512vbmi2")) {
+    return level::avx512;
+  }
+  return level::avx2;
+}
+#endif  // defined(_MSC_VER) && !defined(__clang__)
+#else
+/// \returns  The highest level supported by the host CPU.
+constexpr level cpu_level () noexcept {
+  return level::scalar;
+}
+#endif  // ICUBABY_DISPATCH_X86
+
+/// \param lvl  An instruction set level.
+/// \returns  The kernels compiled for the given level.
+kernel_table const& kernels (level const lvl) noexcept {
+  switch (lvl) {
+#if ICUBABY_DISPATCH_X86
+  case level::avx512: return icubaby_avx512::kernels;
+  case level::avx2: return icubaby_avx2::kernels;
+  case level::sse42: return icubaby_sse42::kernels;
+#else
+  case level::avx512:
+  case level::avx2:
+  case level::sse42:
+#endif  // ICUBABY_DISPATCH_X86
+  case level::scalar: break;
+  }
+  return icubaby_scalar::kernels;
+}
+
+/// \param name  The name of an instruction set level.
+/// \returns  The level with the given name or std::nullopt if the name is not recognized.
+std::optional<level> parse_level (std::string_view const name) noexcept {
+  for (auto index = std::size_t{0}; index < level_names.size (); ++index) {
+    if (name == level_names[index]) {
+      return static_cast<level> (index);
+    }
+  }
+  return std::nullopt;
+}
+
+/// \returns  The level to be used before any call to select_level(). This is best_level() unless the
+///   ICUBABY_DISPATCH_LEVEL environment variable names a lower level.
+level initial_level () noexcept {
+  auto const best = icubaby::dispatch::best_level ();
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma warning(push)
+#pragma warning(disable : 4996)  // 'getenv': This function or variable may be unsafe.
+#endif
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  char const* const env = std::getenv ("ICUBABY_DISPATCH_LEVEL");
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma warning(pop)
+#endif
+  if (env == nullptr) {
+    return best;
+  }
+  auto const requested = parse_level (env);
+  return requested && *requested < best ? *requested : best;
+}
+
+/// The level in use. Initialized on first use.
+std::atomic<level> active{level::scalar};
+/// The kernels in use. A null pointer until the first call to table() or select_level().
+std::atomic<kernel_table const*> active_table{nullptr};
+
+/// \returns  The kernels in use.
+kernel_table const& table () noexcept {
+  if (auto const* const result = active_table.load (std::memory_order_acquire)) {
+    return *result;
+  }
+  (void)icubaby::dispatch::select_level (initial_level ());
+  return *active_table.load (std::memory_order_acquire);
+}
+
+}  // end anonymous namespace
+
+namespace icubaby::dispatch {
+
+std::string_view level_name (level const lvl) noexcept {
+  auto const index = static_cast<std::size_t> (lvl);
+  return index < level_names.size () ? level_names[index] : std::string_view{};
+}
+
+level best_level () noexcept {
+  static level const best = cpu_level ();
+  return best;
+}
+
+level active_level () noexcept {
+  (void)table ();
+  return active.load (std::memory_order_relaxed);
+}
+
+bool select_level (level const lvl) noexcept {
+  if (lvl > best_level ()) {
+    return false;
+  }
+  active.store (lvl, std::memory_order_relaxed);
+  active_table.store (&kernels (lvl), std::memory_order_release);
+  return true;
+}
+
+kernel_result utf8_to_utf32 (char8 const* const first, char8 const* const last, char32_t* const out_first,
+                             char32_t* const out_last) noexcept {
+  return table ().utf8_to_utf32 (first, last, out_first, out_last);
+}
+
+kernel_result utf8_to_utf16 (char8 const* const first, char8 const* const last, char16_t* const out_first,
+                             char16_t* const out_last) noexcept {
+  return table ().utf8_to_utf16 (first, last, out_first, out_last);
+}
+
+kernel_result utf16_to_utf8 (char16_t const* const first, char16_t const* const last, char8* const out_first,
+                             char8* const out_last) noexcept {
+  return table ().utf16_to_utf8 (first, last, out_first, out_last);
+}
+
+char8 const* validate_utf8 (char8 const* const first, char8 const* const last) noexcept {
+  return table ().validate_utf8 (first, last);
+}
+
+}  // end namespace icubaby::dispatch
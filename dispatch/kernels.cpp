@@ -0,0 +1,145 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This file is compiled once for each instruction set level. The build defines ICUBABY_INSIDE_NS as icubaby_<level>
+// so that the inline functions in each copy of icubaby.hpp are distinct from those compiled for other levels. It also
+// defines ICUBABY_KERNELS_xxx to say which instruction sets the level may use: these replace any ICUBABY_HAVE_xxx
+// settings from the command line.
+//
+// The file is compiled with the same options as the rest of the program. The instruction sets of the level are
+// enabled by a target pragma that covers only icubaby.hpp and the kernels. Standard library templates are declared
+// before the pragma, so any out-of-line copies of them that this file emits are compiled for the baseline instruction
+// set. Such copies are weak symbols which the linker may choose in place of those from any other object file.
+
+#ifndef ICUBABY_INSIDE_NS
+#error "ICUBABY_INSIDE_NS must be defined"
+#endif
+#if defined(ICUBABY_DISPATCH) && ICUBABY_DISPATCH
+#error "The kernels must not themselves be dispatched"
+#endif
+
+#undef ICUBABY_HAVE_SSE2
+#undef ICUBABY_HAVE_SSSE3
+#undef ICUBABY_HAVE_AVX2
+#undef ICUBABY_HAVE_AVX512VBMI2
+#define ICUBABY_HAVE_SSE2 ICUBABY_KERNELS_SSE2
+#define ICUBABY_HAVE_SSSE3 ICUBABY_KERNELS_SSSE3
+#define ICUBABY_HAVE_AVX2 ICUBABY_KERNELS_AVX2
+#define ICUBABY_HAVE_AVX512VBMI2 ICUBABY_KERNELS_AVX512VBMI2
+
+// The standard library headers used by icubaby.hpp.
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#if __has_include(<version>)
+#include <version>
+#endif
+#ifdef __cpp_lib_ranges
+#include <ranges>
+#endif
+#ifdef __cpp_lib_span
+#include <span>
+#endif
+#ifdef __cpp_lib_concepts
+#include <concepts>
+#endif
+#if ICUBABY_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+#include "kernels.hpp"
+
+// The instruction sets that may be used by the kernels for this level.
+#if ICUBABY_KERNELS_AVX512VBMI2
+#define ICUBABY_KERNELS_TARGET "avx2,avx512f,avx512bw,avx512vl,avx512vbmi2"
+#elif ICUBABY_KERNELS_AVX2
+#define ICUBABY_KERNELS_TARGET "avx2"
+#elif ICUBABY_KERNELS_SSSE3
+#define ICUBABY_KERNELS_TARGET "sse4.2"
+#endif
+
+#ifdef ICUBABY_KERNELS_TARGET
+// Expands the macros in its arguments before making them the text of a pragma.
+#define ICUBABY_KERNELS_STRINGIFY(...) #__VA_ARGS__
+#define ICUBABY_KERNELS_PRAGMA(...) _Pragma (ICUBABY_KERNELS_STRINGIFY (__VA_ARGS__))
+#if defined(__clang__)
+ICUBABY_KERNELS_PRAGMA (clang attribute push (__attribute__ ((target (ICUBABY_KERNELS_TARGET))), apply_to = function))
+#elif defined(__GNUC__)
+#pragma GCC push_options
+ICUBABY_KERNELS_PRAGMA (GCC target (ICUBABY_KERNELS_TARGET))
+#endif
+#endif  // ICUBABY_KERNELS_TARGET
+
+#include "icubaby/icubaby.hpp"
+
+namespace {
+
+namespace impl = ICUBABY_INSIDE_NS::icubaby::details;
+using icubaby::dispatch::char8;
+using icubaby::dispatch::kernel_result;
+
+kernel_result utf8_to_utf32 (char8 const* const first, char8 const* const last, char32_t* const out_first,
+                             char32_t* const out_last) noexcept {
+  auto const res = impl::bulk_utf8_to_utf32 (first, last, out_first, out_last);
+  return {res.consumed, res.produced};
+}
+kernel_result utf8_to_utf16 (char8 const* const first, char8 const* const last, char16_t* const out_first,
+                             char16_t* const out_last) noexcept {
+  auto const res = impl::bulk_utf8_to_utf16 (first, last, out_first, out_last);
+  return {res.consumed, res.produced};
+}
+kernel_result utf16_to_utf8 (char16_t const* const first, char16_t const* const last, char8* const out_first,
+                             char8* const out_last) noexcept {
+  auto const res = impl::bulk_utf16_to_utf8 (first, last, out_first, out_last);
+  return {res.consumed, res.produced};
+}
+char8 const* validate_utf8 (char8 const* const first, char8 const* const last) noexcept {
+  return impl::bulk_validate_utf8 (first, last);
+}
+
+}  // end anonymous namespace
+
+#ifdef ICUBABY_KERNELS_TARGET
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif  // ICUBABY_KERNELS_TARGET
+
+::icubaby::dispatch::details::kernel_table const ICUBABY_INSIDE_NS::kernels{&utf8_to_utf32, &utf8_to_utf16,
+                                                                            &utf16_to_utf8, &validate_utf8};
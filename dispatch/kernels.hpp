@@ -0,0 +1,57 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef ICUBABY_DISPATCH_KERNELS_HPP
+#define ICUBABY_DISPATCH_KERNELS_HPP
+
+#include "icubaby/dispatch.hpp"
+
+namespace icubaby::dispatch::details {
+
+/// The kernels compiled for one instruction set level.
+struct kernel_table {
+  kernel_result (*utf8_to_utf32) (char8 const*, char8 const*, char32_t*, char32_t*) noexcept;
+  kernel_result (*utf8_to_utf16) (char8 const*, char8 const*, char16_t*, char16_t*) noexcept;
+  kernel_result (*utf16_to_utf8) (char16_t const*, char16_t const*, char8*, char8*) noexcept;
+  char8 const* (*validate_utf8) (char8 const*, char8 const*) noexcept;
+};
+
+}  // end namespace icubaby::dispatch::details
+
+// kernels.cpp is compiled once for each level with ICUBABY_INSIDE_NS defined as icubaby_<level>. Each copy defines a
+// table named "kernels" in that namespace.
+namespace icubaby_scalar {
+extern ::icubaby::dispatch::details::kernel_table const kernels;
+}  // end namespace icubaby_scalar
+#if ICUBABY_DISPATCH_X86
+namespace icubaby_sse42 {
+extern ::icubaby::dispatch::details::kernel_table const kernels;
+}  // end namespace icubaby_sse42
+namespace icubaby_avx2 {
+extern ::icubaby::dispatch::details::kernel_table const kernels;
+}  // end namespace icubaby_avx2
+namespace icubaby_avx512 {
+extern ::icubaby::dispatch::details::kernel_table const kernels;
+}  // end namespace icubaby_avx512
+#endif  // ICUBABY_DISPATCH_X86
+
+#endif  // ICUBABY_DISPATCH_KERNELS_HPP
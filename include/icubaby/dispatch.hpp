@@ -0,0 +1,129 @@
+//*  _         _          _          *
+//* (_)__ _  _| |__  __ _| |__ _  _  *
+//* | / _| || | '_ \/ _` | '_ \ || | *
+//* |_\__|\_,_|_.__/\__,_|_.__/\_, | *
+//*                            |__/  *
+// Home page:
+// https://paulhuggett-icubaby.rtfd.io
+//
+// MIT License
+//
+// Copyright (c) 2022-2024 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file dispatch.hpp
+/// \brief The interface to the icubaby-dispatch library.
+///
+/// icubaby-dispatch contains copies of the bulk conversion and validation kernels compiled for several x86
+/// instruction set levels. The best level supported by the host CPU is chosen when a kernel is first used. Code which
+/// links with the library's CMake target has ICUBABY_DISPATCH defined as 1 so that icubaby.hpp calls these functions
+/// rather than the kernels selected by the compiler's target options.
+///
+/// The ICUBABY_DISPATCH_LEVEL environment variable may be set to one of "scalar", "sse42", "avx2", or "avx512" to
+/// limit the level that is chosen. This is intended for testing.
+
+#ifndef ICUBABY_DISPATCH_HPP
+#define ICUBABY_DISPATCH_HPP
+
+#include <cstddef>
+#include <string_view>
+
+/// \brief The run-time dispatch interface.
+namespace icubaby::dispatch {
+
+/// \brief The type of a UTF-8 code unit. This is the same type as icubaby::char8.
+/// \hideinitializer
+#if defined(__cpp_char8_t) && defined(__cpp_lib_char8_t)
+using char8 = char8_t;
+#else
+using char8 = char;
+#endif
+
+/// The instruction set levels for which the kernels are compiled.
+enum class level : unsigned {
+  scalar,  ///< Portable code with no vector instructions.
+  sse42,   ///< SSE4.2 (the kernels use instructions up to SSSE3).
+  avx2,    ///< AVX2.
+  avx512,  ///< AVX-512 F, BW, VL, and VBMI2.
+};
+
+/// \param lvl  An instruction set level.
+/// \returns  The name of the level. This is the same as the value used by the ICUBABY_DISPATCH_LEVEL environment
+///   variable.
+std::string_view level_name (level lvl) noexcept;
+
+/// \returns  The highest level that is both supported by the host CPU and included in the library.
+level best_level () noexcept;
+
+/// \returns  The level whose kernels are in use.
+level active_level () noexcept;
+
+/// Changes the level whose kernels are in use.
+///
+/// \param lvl  The level to be used.
+/// \returns  True if the level was selected, false if it is not supported by the host CPU or is not included in the
+///   library.
+bool select_level (level lvl) noexcept;
+
+/// The number of code units consumed and produced by a kernel.
+struct kernel_result {
+  /// The number of input code units consumed.
+  std::size_t consumed = 0;
+  /// The number of output code units produced.
+  std::size_t produced = 0;
+};
+
+/// Converts a prefix of a range of UTF-8 code units to UTF-32.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced. Conversion stops at a code point boundary.
+kernel_result utf8_to_utf32 (char8 const* first, char8 const* last, char32_t* out_first, char32_t* out_last) noexcept;
+
+/// Converts a prefix of a range of UTF-8 code units to UTF-16.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced. Conversion stops at a code point boundary.
+kernel_result utf8_to_utf16 (char8 const* first, char8 const* last, char16_t* out_first, char16_t* out_last) noexcept;
+
+/// Converts a prefix of a range of UTF-16 code units to UTF-8.
+///
+/// \param first  The start of the range of UTF-16 code units.
+/// \param last  The end of the range of UTF-16 code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced. Conversion stops at a code point boundary.
+kernel_result utf16_to_utf8 (char16_t const* first, char16_t const* last, char8* out_first, char8* out_last) noexcept;
+
+/// Checks a prefix of a range of UTF-8 code units.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \returns  nullptr if the input is ill-formed, otherwise the position of the first code unit that was not checked.
+char8 const* validate_utf8 (char8 const* first, char8 const* last) noexcept;
+
+}  // end namespace icubaby::dispatch
+
+#endif  // ICUBABY_DISPATCH_HPP
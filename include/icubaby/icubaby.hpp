@@ -90,13 +90,18 @@
 #include <climits>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
 /// \brief ICUBABY_CXX20 has value 1 when compiling with C++ 20 or later and 0
 ///   otherwise.
@@ -131,6 +136,22 @@
 #include <ranges>
 #endif
 
+#if ICUBABY_CXX20
+#include <span>
+#endif
+
+/// \brief Defined as 1 if the standard library's __cpp_lib_span macro is available and 0 otherwise.
+/// \hideinitializer
+#ifdef __cpp_lib_span
+#define ICUBABY_CPP_LIB_SPAN_DEFINED (1)
+#else
+#define ICUBABY_CPP_LIB_SPAN_DEFINED (0)
+#endif
+
+/// \brief Tests for the availability of library support for std::span.
+/// \hideinitializer
+#define ICUBABY_HAVE_SPAN (ICUBABY_CPP_LIB_SPAN_DEFINED && __cpp_lib_span >= 202002L)
+
 /// \brief Defined as true if compiler and library support for concepts are available.
 /// \hideinitializer
 #ifdef __cpp_concepts
@@ -185,6 +206,75 @@
 #define ICUBABY_NO_UNIQUE_ADDRESS
 #endif
 
+/// \brief Defined as 1 if the code may use the SSE2 instruction set and 0 otherwise.
+///
+/// The value is derived from the compiler's target options but may be defined before including icubaby.hpp to
+/// override the default.
+/// \hideinitializer
+#ifndef ICUBABY_HAVE_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ICUBABY_HAVE_SSE2 (1)
+#else
+#define ICUBABY_HAVE_SSE2 (0)
+#endif
+#endif  // ICUBABY_HAVE_SSE2
+
+/// \brief Defined as 1 if the code may use the AVX2 instruction set and 0 otherwise.
+///
+/// The value is derived from the compiler's target options but may be defined before including icubaby.hpp to
+/// override the default.
+/// \hideinitializer
+#ifndef ICUBABY_HAVE_AVX2
+#ifdef __AVX2__
+#define ICUBABY_HAVE_AVX2 (1)
+#else
+#define ICUBABY_HAVE_AVX2 (0)
+#endif
+#endif  // ICUBABY_HAVE_AVX2
+
+/// \brief Defined as 1 if the code may use the SSSE3 instruction set and 0 otherwise.
+///
+/// The value is derived from the compiler's target options but may be defined before including icubaby.hpp to
+/// override the default.
+/// \hideinitializer
+#ifndef ICUBABY_HAVE_SSSE3
+#if defined(__SSSE3__) || defined(__AVX__)
+#define ICUBABY_HAVE_SSSE3 (1)
+#else
+#define ICUBABY_HAVE_SSSE3 (0)
+#endif
+#endif  // ICUBABY_HAVE_SSSE3
+
+/// \brief Defined as 1 if the code may use the AVX-512 VBMI2 and VL instruction sets and 0 otherwise.
+///
+/// The value is derived from the compiler's target options but may be defined before including icubaby.hpp to
+/// override the default.
+/// \hideinitializer
+#ifndef ICUBABY_HAVE_AVX512VBMI2
+#if defined(__AVX512VBMI2__) && defined(__AVX512VL__) && defined(__AVX512BW__)
+#define ICUBABY_HAVE_AVX512VBMI2 (1)
+#else
+#define ICUBABY_HAVE_AVX512VBMI2 (0)
+#endif
+#endif  // ICUBABY_HAVE_AVX512VBMI2
+
+/// \brief Defined as 1 if the bulk conversion and validation kernels are selected at run time by the icubaby-dispatch
+///   library and 0 if they are chosen at compile time.
+///
+/// The icubaby-dispatch CMake target defines this macro as 1 for the code that links with it.
+/// \hideinitializer
+#ifndef ICUBABY_DISPATCH
+#define ICUBABY_DISPATCH (0)
+#endif  // ICUBABY_DISPATCH
+
+#if ICUBABY_DISPATCH
+#include "dispatch.hpp"
+#endif  // ICUBABY_DISPATCH
+
+#if ICUBABY_HAVE_SSE2 || ICUBABY_HAVE_SSSE3 || ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_AVX512VBMI2
+#include <immintrin.h>
+#endif
+
 #ifdef ICUBABY_INSIDE_NS
 namespace ICUBABY_INSIDE_NS {
 #endif
@@ -387,6 +477,36 @@ template <> struct longest_sequence<char32_t> : std::integral_constant<std::size
 template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE Encoding>
 inline constexpr auto longest_sequence_v = longest_sequence<Encoding>::value;
 
+namespace details {
+
+/// \brief The maximum number of code units that a transcoder can produce from a single input value.
+///
+/// This is usually the number of code units in the longest legal representation of a code point in the output
+/// encoding, but some transcoders can emit more than one code point when they see malformed input.
+///
+/// \tparam FromEncoding  The source encoding.
+/// \tparam ToEncoding  The destination encoding.
+template <typename FromEncoding, typename ToEncoding>
+inline constexpr auto max_output_units = longest_sequence_v<ToEncoding>;
+/// \brief The maximum number of code units produced by a single UTF-16 code unit being converted to UTF-8.
+///
+/// A high surrogate followed by a code unit that is not a low surrogate produces U+FFFD REPLACEMENT CHARACTER
+/// followed by the second code unit: each of which may be three bytes when encoded as UTF-8.
+template <> inline constexpr auto max_output_units<char16_t, char8> = std::size_t{6};
+/// \brief The maximum number of code units produced by a single UTF-16 code unit being converted to UTF-32.
+template <> inline constexpr auto max_output_units<char16_t, char32_t> = std::size_t{2};
+/// \brief The maximum number of code units produced by a single byte passed to a byte transcoder.
+///
+/// Once the byte transcoder has decided that its input does not start with a byte order mark, it may flush as many as
+/// four buffered bytes at once.
+template <> inline constexpr auto max_output_units<std::byte, char8> = 4 * longest_sequence_v<char8>;
+/// \brief The maximum number of code units produced by a single byte passed to a byte transcoder.
+template <> inline constexpr auto max_output_units<std::byte, char16_t> = 4 * longest_sequence_v<char16_t>;
+/// \brief The maximum number of code units produced by a single byte passed to a byte transcoder.
+template <> inline constexpr auto max_output_units<std::byte, char32_t> = 4 * longest_sequence_v<char32_t>;
+
+}  // end namespace details
+
 /// \brief Returns true if the code point \p code_point represents a UTF-16 high surrogate.
 ///
 /// \param code_point  The code point to be tested.
@@ -436,10 +556,132 @@ inline constexpr auto longest_sequence_v = longest_sequence<Encoding>::value;
 }
 ///@}
 
+namespace details {
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+
+/// Counts of the UTF-8 code units which start a code point and of those which start a four byte sequence.
+struct utf8_counts {
+  /// The number of code units which are not continuation bytes.
+  std::size_t starts = 0;
+  /// The number of code units which start a four byte sequence.
+  std::size_t four_byte = 0;
+};
+
+/// \brief Counts the code units in a range of well-formed UTF-8 which start a code point or a four byte sequence.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \returns  The number of code units which start a code point and of those which start a four byte sequence.
+inline utf8_counts count_utf8 (char8 const* first, char8 const* const last) noexcept {
+  utf8_counts result;
+#if ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_SSE2
+  // Each iteration adds at most 1 to the 8-bit lanes of the accumulators, so they are emptied at least every 255
+  // iterations.
+  constexpr auto max_iterations = 255;
+#endif
+#if ICUBABY_HAVE_AVX2
+  while (last - first >= 32) {
+    auto starts = _mm256_setzero_si256 ();
+    auto four_byte = _mm256_setzero_si256 ();
+    for (auto iteration = 0; iteration < max_iterations && last - first >= 32; ++iteration, first += 32) {
+      auto const bytes = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (first));
+      // Bytes 0x80-0xBF are -128 to -65 when treated as signed values.
+      starts = _mm256_sub_epi8 (starts, _mm256_cmpgt_epi8 (bytes, _mm256_set1_epi8 (-65)));
+      auto const high_nibble = _mm256_and_si256 (bytes, _mm256_set1_epi8 (static_cast<char> (0xF0)));
+      four_byte =
+          _mm256_sub_epi8 (four_byte, _mm256_cmpeq_epi8 (high_nibble, _mm256_set1_epi8 (static_cast<char> (0xF0))));
+    }
+    auto const sum = [] (__m256i const v) {
+      auto const sums = _mm256_sad_epu8 (v, _mm256_setzero_si256 ());
+      return static_cast<std::size_t> (_mm256_extract_epi64 (sums, 0) + _mm256_extract_epi64 (sums, 1) +
+                                       _mm256_extract_epi64 (sums, 2) + _mm256_extract_epi64 (sums, 3));
+    };
+    result.starts += sum (starts);
+    result.four_byte += sum (four_byte);
+  }
+#elif ICUBABY_HAVE_SSE2
+  while (last - first >= 16) {
+    auto starts = _mm_setzero_si128 ();
+    auto four_byte = _mm_setzero_si128 ();
+    for (auto iteration = 0; iteration < max_iterations && last - first >= 16; ++iteration, first += 16) {
+      auto const bytes = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (first));
+      // Bytes 0x80-0xBF are -128 to -65 when treated as signed values.
+      starts = _mm_sub_epi8 (starts, _mm_cmpgt_epi8 (bytes, _mm_set1_epi8 (-65)));
+      auto const high_nibble = _mm_and_si128 (bytes, _mm_set1_epi8 (static_cast<char> (0xF0)));
+      four_byte = _mm_sub_epi8 (four_byte, _mm_cmpeq_epi8 (high_nibble, _mm_set1_epi8 (static_cast<char> (0xF0))));
+    }
+    auto const sum = [] (__m128i const v) {
+      auto const sums = _mm_sad_epu8 (v, _mm_setzero_si128 ());
+      return static_cast<std::size_t> (_mm_cvtsi128_si32 (sums) + _mm_extract_epi16 (sums, 4));
+    };
+    result.starts += sum (starts);
+    result.four_byte += sum (four_byte);
+  }
+#endif
+  for (; first != last; ++first) {
+    auto const byte = static_cast<std::uint_least8_t> (*first);
+    result.starts += static_cast<std::size_t> ((byte & 0xC0U) != 0x80U);
+    result.four_byte += static_cast<std::size_t> ((byte & 0xF0U) == 0xF0U);
+  }
+  return result;
+}
+
+/// \brief Counts the UTF-16 low surrogates in a range of code units.
+///
+/// \param first  The start of the range of UTF-16 code units.
+/// \param last  The end of the range of UTF-16 code units.
+/// \returns  The number of code units in the range [0xDC00, 0xDFFF].
+inline std::size_t count_low_surrogates (char16_t const* first, char16_t const* const last) noexcept {
+  auto result = std::size_t{0};
+#if ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_SSE2
+  // Each iteration adds at most 1 to the 16-bit lanes of the accumulator.
+  constexpr auto max_iterations = 0x7FFF;
+#endif
+#if ICUBABY_HAVE_AVX2
+  while (last - first >= 16) {
+    auto low = _mm256_setzero_si256 ();
+    for (auto iteration = 0; iteration < max_iterations && last - first >= 16; ++iteration, first += 16) {
+      auto const units = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (first));
+      auto const surrogate_bits = _mm256_and_si256 (units, _mm256_set1_epi16 (static_cast<short> (0xFC00)));
+      low =
+          _mm256_sub_epi16 (low, _mm256_cmpeq_epi16 (surrogate_bits, _mm256_set1_epi16 (static_cast<short> (0xDC00))));
+    }
+    auto const sums = _mm256_madd_epi16 (low, _mm256_set1_epi16 (1));  // Eight 32-bit sums.
+    auto const halves = _mm_add_epi32 (_mm256_castsi256_si128 (sums), _mm256_extracti128_si256 (sums, 1));
+    auto const quarters = _mm_add_epi32 (halves, _mm_srli_si128 (halves, 8));
+    result += static_cast<std::size_t> (_mm_cvtsi128_si32 (_mm_add_epi32 (quarters, _mm_srli_si128 (quarters, 4))));
+  }
+#elif ICUBABY_HAVE_SSE2
+  while (last - first >= 8) {
+    auto low = _mm_setzero_si128 ();
+    for (auto iteration = 0; iteration < max_iterations && last - first >= 8; ++iteration, first += 8) {
+      auto const units = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (first));
+      auto const surrogate_bits = _mm_and_si128 (units, _mm_set1_epi16 (static_cast<short> (0xFC00)));
+      low = _mm_sub_epi16 (low, _mm_cmpeq_epi16 (surrogate_bits, _mm_set1_epi16 (static_cast<short> (0xDC00))));
+    }
+    auto const sums = _mm_madd_epi16 (low, _mm_set1_epi16 (1));  // Four 32-bit sums.
+    auto const halves = _mm_add_epi32 (sums, _mm_srli_si128 (sums, 8));
+    result += static_cast<std::size_t> (_mm_cvtsi128_si32 (_mm_add_epi32 (halves, _mm_srli_si128 (halves, 4))));
+  }
+#endif
+  for (; first != last; ++first) {
+    result += static_cast<std::size_t> (is_low_surrogate (*first));
+  }
+  return result;
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+
+}  // end namespace details
+
 #if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
 
 /// \brief Returns the number of code points in a sequence.
 ///
+/// Contiguous ranges of UTF-8 or UTF-16 code units with no projection are counted using vector instructions (where
+/// available) when the function is not being evaluated at compile time.
+///
 /// \note The input sequence must be well formed for the result to be accurate.
 /// \tparam Range  An input range.
 /// \tparam Proj  Type of the projection applied to elements.
@@ -449,6 +691,22 @@ inline constexpr auto longest_sequence_v = longest_sequence<Encoding>::value;
 template <std::ranges::input_range Range, typename Proj = std::identity>
   requires unicode_char_type<std::ranges::range_value_t<Range>>
 [[nodiscard]] constexpr std::ranges::range_difference_t<Range> length (Range&& range, Proj proj = {}) {
+  using value_type = std::ranges::range_value_t<Range>;
+  if constexpr (std::ranges::contiguous_range<Range> && std::ranges::sized_range<Range> &&
+                std::is_same_v<Proj, std::identity> &&
+                (std::is_same_v<value_type, char8> || std::is_same_v<value_type, char16_t>)) {
+    if (!std::is_constant_evaluated ()) {
+      auto const* const first = std::ranges::data (range);
+      auto const size = std::ranges::size (range);
+      auto const* const last = first + size;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      if constexpr (std::is_same_v<value_type, char8>) {
+        return static_cast<std::ranges::range_difference_t<Range>> (details::count_utf8 (first, last).starts);
+      } else {
+        return static_cast<std::ranges::range_difference_t<Range>> (size -
+                                                                    details::count_low_surrogates (first, last));
+      }
+    }
+  }
   return std::ranges::count_if (
       std::forward<Range> (range),
       [] (unicode_char_type auto const code_unit) { return is_code_point_start (code_unit); }, proj);
@@ -541,6 +799,472 @@ template <typename InputIterator,
 
 #endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
 
+/// \brief Records the position of every interval'th code point in a sequence of code units so that code points can be
+///   found without scanning from the start of the sequence.
+///
+/// The index does not hold the code units themselves. Code units are passed to append() as they are added to the
+/// text and the same text is later passed to index() and substr(). A lookup scans forward from the nearest checkpoint
+/// and so examines fewer than interval() code points. The checkpoints are held in a container supplied by the caller
+/// so that the library does not itself allocate memory.
+///
+/// \tparam Encoding  The encoding of the code units.
+/// \tparam Container  A sequence container of std::size_t providing push_back(), size(), clear(), and operator[]
+///   (for example, std::vector<std::size_t>).
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE Encoding, typename Container> class code_point_index {
+public:
+  /// The type of the code units that are indexed.
+  using input_type = Encoding;
+  /// The type of the container which holds the checkpoints.
+  using container_type = Container;
+
+  /// \param interval  The number of code points between checkpoints. Must be greater than 0.
+  /// \param checkpoints  The container in which the checkpoints are recorded. Any existing contents are discarded.
+  explicit code_point_index (std::size_t const interval, Container checkpoints = Container{})
+      : interval_{interval}, checkpoints_{std::move (checkpoints)} {
+    assert (interval > 0 && "The checkpoint interval must be greater than 0");
+    checkpoints_.clear ();
+  }
+
+  /// Adds a sequence of code units to the end of the indexed text.
+  ///
+  /// \param first  The start of the range of code units to be added.
+  /// \param last  The end of the range of code units to be added.
+  template <typename InputIterator, typename Sentinel> void append (InputIterator first, Sentinel last) {
+    if constexpr (std::is_pointer_v<InputIterator> && std::is_same_v<InputIterator, Sentinel> &&
+                  (std::is_same_v<input_type, char8> || std::is_same_v<input_type, char16_t>)) {
+      // Skip blocks which do not contain a checkpoint by counting the code points that they contain.
+      constexpr auto block_size = std::ptrdiff_t{64};
+      while (last - first >= block_size) {
+        auto const block_last = first + block_size;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        auto starts = std::size_t{0};
+        if constexpr (std::is_same_v<input_type, char8>) {
+          starts = details::count_utf8 (first, block_last).starts;
+        } else {
+          starts = static_cast<std::size_t> (block_size) - details::count_low_surrogates (first, block_last);
+        }
+        if (code_points_ % interval_ + starts > interval_ || (starts > 0 && code_points_ % interval_ == 0)) {
+          // The block contains a checkpoint: add its code units one at a time to record its position.
+          for (; first != block_last; ++first) {
+            (*this) (*first);
+          }
+          continue;
+        }
+        code_points_ += starts;
+        code_units_ += static_cast<std::size_t> (block_size);
+        first = block_last;
+      }
+    }
+    for (; first != last; ++first) {
+      (*this) (*first);
+    }
+  }
+
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+  /// Adds a range of code units to the end of the indexed text.
+  ///
+  /// \param range  The range of code units to be added.
+  template <std::ranges::input_range Range> void append (Range&& range) {
+    if constexpr (std::ranges::contiguous_range<Range> && std::ranges::sized_range<Range>) {
+      auto const* const first = std::ranges::data (range);
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      this->append (first, first + std::ranges::size (range));
+    } else {
+      this->append (std::ranges::begin (range), std::ranges::end (range));
+    }
+  }
+#endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+  /// Adds a single code unit to the end of the indexed text.
+  ///
+  /// \param code_unit  The code unit to be added.
+  void operator() (input_type const code_unit) {
+    if (is_code_point_start (code_unit)) {
+      if (code_points_ % interval_ == 0) {
+        checkpoints_.push_back (code_units_);
+      }
+      ++code_points_;
+    }
+    ++code_units_;
+  }
+
+  /// Returns an iterator to the beginning of the pos'th code point of the indexed text.
+  ///
+  /// \param first  The start of the indexed text.
+  /// \param last  The end of the indexed text.
+  /// \param pos  The number of code points to move.
+  /// \returns  An iterator that is 'pos' code points after \p first or \p last if there is no such code point.
+  template <typename RandomAccessIterator>
+  [[nodiscard]] RandomAccessIterator index (RandomAccessIterator first, RandomAccessIterator last,
+                                            std::size_t const pos) const {
+    if (pos >= code_points_) {
+      return last;
+    }
+    using difference_type = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    auto const checkpoint = checkpoints_[pos / interval_];
+    return icubaby::index (first + static_cast<difference_type> (checkpoint), last, pos % interval_);
+  }
+
+  /// Returns the range of code units which hold \p count code points of the indexed text starting at code point
+  /// \p pos. The range is truncated if the text ends first.
+  ///
+  /// \param first  The start of the indexed text.
+  /// \param last  The end of the indexed text.
+  /// \param pos  The index of the first code point of the range.
+  /// \param count  The number of code points in the range.
+  /// \returns  A pair of iterators delimiting the code units of the selected code points.
+  template <typename RandomAccessIterator>
+  [[nodiscard]] std::pair<RandomAccessIterator, RandomAccessIterator> substr (RandomAccessIterator first,
+                                                                              RandomAccessIterator last,
+                                                                              std::size_t const pos,
+                                                                              std::size_t const count) const {
+    auto const begin = this->index (first, last, pos);
+    if (count >= code_points_ - std::min (pos, code_points_)) {
+      return {begin, last};
+    }
+    // Scan forward from begin if it is no further away than the checkpoint preceding the end.
+    auto const end = count < interval_ ? icubaby::index (begin, last, count) : this->index (first, last, pos + count);
+    return {begin, end};
+  }
+
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+  /// Returns an iterator to the beginning of the pos'th code point of the indexed text.
+  ///
+  /// \param text  The indexed text.
+  /// \param pos  The number of code points to move.
+  /// \returns  An iterator that is 'pos' code points after the start of \p text or its end if there is no such code
+  ///   point.
+  template <std::ranges::random_access_range Range>
+    requires std::ranges::common_range<Range>
+  [[nodiscard]] std::ranges::borrowed_iterator_t<Range> index (Range&& text, std::size_t const pos) const {
+    return this->index (std::ranges::begin (text), std::ranges::end (text), pos);
+  }
+
+  /// Returns the code units which hold \p count code points of the indexed text starting at code point \p pos.
+  ///
+  /// \param text  The indexed text.
+  /// \param pos  The index of the first code point of the range.
+  /// \param count  The number of code points in the range.
+  /// \returns  The code units of the selected code points.
+  template <std::ranges::random_access_range Range>
+    requires std::ranges::common_range<Range>
+  [[nodiscard]] std::ranges::borrowed_subrange_t<Range> substr (Range&& text, std::size_t const pos,
+                                                               std::size_t const count) const {
+    auto const [begin, end] = this->substr (std::ranges::begin (text), std::ranges::end (text), pos, count);
+    return {begin, end};
+  }
+#endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+  /// Discards the contents of the index.
+  void clear () noexcept {
+    checkpoints_.clear ();
+    code_units_ = 0;
+    code_points_ = 0;
+  }
+
+  /// \returns  The number of code points between checkpoints.
+  [[nodiscard]] constexpr std::size_t interval () const noexcept { return interval_; }
+  /// \returns  The number of code units that have been added to the index.
+  [[nodiscard]] constexpr std::size_t code_units () const noexcept { return code_units_; }
+  /// \returns  The number of code points that have been added to the index.
+  [[nodiscard]] constexpr std::size_t code_points () const noexcept { return code_points_; }
+  /// \returns  The container holding the code unit offset of every interval()'th code point.
+  [[nodiscard]] constexpr Container const& checkpoints () const noexcept { return checkpoints_; }
+
+private:
+  /// The number of code points between checkpoints.
+  std::size_t interval_;
+  /// The code unit offset of every interval_'th code point.
+  Container checkpoints_;
+  /// The number of code units that have been added to the index.
+  std::size_t code_units_ = 0;
+  /// The number of code points that have been added to the index.
+  std::size_t code_points_ = 0;
+};
+
+/// \brief The position of a code point boundary expressed as an offset in each of the Unicode encodings.
+struct offsets {
+  /// The offset in UTF-8 code units.
+  std::size_t utf8 = 0;
+  /// The offset in UTF-16 code units.
+  std::size_t utf16 = 0;
+  /// The offset in code points (UTF-32 code units).
+  std::size_t utf32 = 0;
+
+  /// \brief Returns the offset in the code units of \p Encoding.
+  /// \tparam Encoding  The encoding whose offset is to be returned.
+  /// \returns  The offset in the code units of \p Encoding.
+  template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE Encoding> [[nodiscard]] constexpr std::size_t get () const noexcept {
+    if constexpr (std::is_same_v<Encoding, char8>) {
+      return utf8;
+    } else if constexpr (std::is_same_v<Encoding, char16_t>) {
+      return utf16;
+    } else {
+      return utf32;
+    }
+  }
+
+  /// \brief Returns true if the two offsets are equal.
+  /// \param lhs  The first offsets to compare.
+  /// \param rhs  The second offsets to compare.
+  /// \returns  True if the two offsets are equal.
+  friend constexpr bool operator== (offsets const& lhs, offsets const& rhs) noexcept {
+    return lhs.utf8 == rhs.utf8 && lhs.utf16 == rhs.utf16 && lhs.utf32 == rhs.utf32;
+  }
+  /// \brief Returns true if the two offsets are not equal.
+  /// \param lhs  The first offsets to compare.
+  /// \param rhs  The second offsets to compare.
+  /// \returns  True if the two offsets are not equal.
+  friend constexpr bool operator!= (offsets const& lhs, offsets const& rhs) noexcept { return !(lhs == rhs); }
+};
+
+namespace details {
+
+/// \brief Returns the number of UTF-8 and UTF-16 code units needed to encode the code point which starts with
+///   \p code_unit.
+///
+/// \param code_unit  The first code unit of a well-formed UTF-8 sequence.
+/// \returns  The widths of the code point in each encoding.
+constexpr offsets code_point_widths (char8 const code_unit) noexcept {
+  auto const byte = static_cast<std::uint_least8_t> (code_unit);
+  if (byte < 0x80U) {
+    return {1, 1, 1};
+  }
+  if (byte < 0xE0U) {
+    return {2, 1, 1};
+  }
+  if (byte < 0xF0U) {
+    return {3, 1, 1};
+  }
+  return {4, 2, 1};
+}
+/// \brief Returns the number of UTF-8 and UTF-16 code units needed to encode the code point which starts with
+///   \p code_unit.
+///
+/// \param code_unit  The first code unit of a well-formed UTF-16 sequence.
+/// \returns  The widths of the code point in each encoding.
+constexpr offsets code_point_widths (char16_t const code_unit) noexcept {
+  if (code_unit < 0x80U) {
+    return {1, 1, 1};
+  }
+  if (code_unit < 0x800U) {
+    return {2, 1, 1};
+  }
+  return is_high_surrogate (code_unit) ? offsets{4, 2, 1} : offsets{3, 1, 1};
+}
+/// \brief Returns the number of UTF-8 and UTF-16 code units needed to encode \p code_unit.
+///
+/// \param code_unit  A UTF-32 code unit.
+/// \returns  The widths of the code point in each encoding.
+constexpr offsets code_point_widths (char32_t const code_unit) noexcept {
+  if (code_unit < 0x80U) {
+    return {1, 1, 1};
+  }
+  if (code_unit < 0x800U) {
+    return {2, 1, 1};
+  }
+  return code_unit > 0xFFFFU ? offsets{4, 2, 1} : offsets{3, 1, 1};
+}
+
+/// \brief Returns a reference to the member of \p off which holds the offset in the code units of \p Encoding.
+///
+/// \tparam Encoding  The encoding whose offset is to be returned.
+/// \param off  The offsets to be accessed.
+/// \returns  A reference to the member of \p off which holds the offset in the code units of \p Encoding.
+template <typename Encoding> constexpr std::size_t& offset_of (offsets& off) noexcept {
+  if constexpr (std::is_same_v<Encoding, char8>) {
+    return off.utf8;
+  } else if constexpr (std::is_same_v<Encoding, char16_t>) {
+    return off.utf16;
+  } else {
+    return off.utf32;
+  }
+}
+
+}  // end namespace details
+
+/// \brief Converts offsets in a text between UTF-8 code units, UTF-16 code units, and code points without producing
+///   a transcoded copy of the text.
+///
+/// The index records the offsets of a code point boundary roughly every interval() code units of the text in each of
+/// the three encodings. A query finds the nearest preceding checkpoint by binary search and then scans forward over
+/// at most interval() code units. Like code_point_index, the index does not hold the text itself: code units are
+/// passed to append() as they are added to the text and the same text is later passed to locate() and convert().
+///
+/// \note The text must be well formed for the results to be accurate.
+/// \tparam Encoding  The encoding of the indexed text.
+/// \tparam Container  A sequence container of icubaby::offsets with random-access iterators providing push_back(),
+///   back(), empty(), clear(), begin(), and end() (for example, std::vector<icubaby::offsets>).
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE Encoding, typename Container> class offset_index {
+public:
+  /// The type of the code units that are indexed.
+  using input_type = Encoding;
+  /// The type of the container which holds the checkpoints.
+  using container_type = Container;
+
+  /// \param interval  The approximate number of code units of the text between checkpoints. Must be greater than 0.
+  /// \param checkpoints  The container in which the checkpoints are recorded. Any existing contents are discarded.
+  explicit offset_index (std::size_t const interval, Container checkpoints = Container{})
+      : interval_{interval}, checkpoints_{std::move (checkpoints)} {
+    assert (interval > 0 && "The checkpoint interval must be greater than 0");
+    checkpoints_.clear ();
+  }
+
+  /// Adds a sequence of code units to the end of the indexed text.
+  ///
+  /// \param first  The start of the range of code units to be added.
+  /// \param last  The end of the range of code units to be added.
+  template <typename InputIterator, typename Sentinel> void append (InputIterator first, Sentinel last) {
+    for (; first != last; ++first) {
+      (*this) (*first);
+    }
+  }
+
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+  /// Adds a range of code units to the end of the indexed text.
+  ///
+  /// \param range  The range of code units to be added.
+  template <std::ranges::input_range Range> void append (Range&& range) {
+    this->append (std::ranges::begin (range), std::ranges::end (range));
+  }
+#endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+  /// Adds a single code unit to the end of the indexed text.
+  ///
+  /// \param code_unit  The code unit to be added.
+  void operator() (input_type const code_unit) {
+    if (is_code_point_start (code_unit)) {
+      if (checkpoints_.empty () || source (total_) - source (checkpoints_.back ()) >= interval_) {
+        checkpoints_.push_back (total_);
+      }
+      advance (total_, code_unit);
+    }
+    ++source (total_);
+  }
+
+  /// \brief Finds the code point boundary at or before an offset in the indexed text.
+  ///
+  /// An offset which falls within a code point is rounded down to the start of that code point. An offset beyond
+  /// the end of the text yields the offsets of the end of the text.
+  ///
+  /// \tparam From  The encoding in which \p offset is expressed.
+  /// \param first  The start of the indexed text.
+  /// \param last  The end of the indexed text.
+  /// \param offset  An offset expressed in code units of \p From.
+  /// \returns  The offsets of the selected code point boundary in each encoding.
+  template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE From, typename RandomAccessIterator>
+  [[nodiscard]] offsets locate (RandomAccessIterator first, RandomAccessIterator last, std::size_t const offset) const {
+    if (checkpoints_.empty ()) {
+      return total_;
+    }
+    // Find the last checkpoint which is not beyond the requested offset.
+    auto const pos = std::partition_point (std::begin (checkpoints_), std::end (checkpoints_),
+                                           [offset] (offsets const& cp) { return cp.get<From> () <= offset; });
+    offsets result = pos == std::begin (checkpoints_) ? *pos : *std::prev (pos);
+    using difference_type = typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    for (auto it = first + static_cast<difference_type> (source (result)); it != last; ++it) {
+      if (is_code_point_start (*it)) {
+        if (result.get<From> () + details::code_point_widths (*it).template get<From> () > offset) {
+          break;
+        }
+        advance (result, *it);
+      }
+      ++source (result);
+    }
+    return result;
+  }
+
+  /// \brief Converts an offset in the indexed text from one encoding to another.
+  ///
+  /// \tparam From  The encoding in which \p offset is expressed.
+  /// \tparam To  The encoding in which the result is expressed.
+  /// \param first  The start of the indexed text.
+  /// \param last  The end of the indexed text.
+  /// \param offset  An offset expressed in code units of \p From.
+  /// \returns  The offset in code units of \p To of the code point boundary at or before \p offset.
+  template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE From, ICUBABY_CONCEPT_UNICODE_CHAR_TYPE To,
+            typename RandomAccessIterator>
+  [[nodiscard]] std::size_t convert (RandomAccessIterator first, RandomAccessIterator last,
+                                     std::size_t const offset) const {
+    return this->template locate<From> (first, last, offset).template get<To> ();
+  }
+
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+  /// \brief Finds the code point boundary at or before an offset in the indexed text.
+  ///
+  /// \tparam From  The encoding in which \p offset is expressed.
+  /// \param text  The indexed text.
+  /// \param offset  An offset expressed in code units of \p From.
+  /// \returns  The offsets of the selected code point boundary in each encoding.
+  template <unicode_char_type From, std::ranges::random_access_range Range>
+    requires std::ranges::common_range<Range>
+  [[nodiscard]] offsets locate (Range const& text, std::size_t const offset) const {
+    return this->template locate<From> (std::ranges::begin (text), std::ranges::end (text), offset);
+  }
+  /// \brief Converts an offset in the indexed text from one encoding to another.
+  ///
+  /// \tparam From  The encoding in which \p offset is expressed.
+  /// \tparam To  The encoding in which the result is expressed.
+  /// \param text  The indexed text.
+  /// \param offset  An offset expressed in code units of \p From.
+  /// \returns  The offset in code units of \p To of the code point boundary at or before \p offset.
+  template <unicode_char_type From, unicode_char_type To, std::ranges::random_access_range Range>
+    requires std::ranges::common_range<Range>
+  [[nodiscard]] std::size_t convert (Range const& text, std::size_t const offset) const {
+    return this->template convert<From, To> (std::ranges::begin (text), std::ranges::end (text), offset);
+  }
+#endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+  /// Discards the contents of the index.
+  void clear () noexcept {
+    checkpoints_.clear ();
+    total_ = offsets{};
+  }
+
+  /// \returns  The number of code units of the text between checkpoints.
+  [[nodiscard]] constexpr std::size_t interval () const noexcept { return interval_; }
+  /// \returns  The offsets of the end of the text that has been added to the index.
+  [[nodiscard]] constexpr offsets const& size () const noexcept { return total_; }
+  /// \returns  The container holding the checkpoints.
+  [[nodiscard]] constexpr Container const& checkpoints () const noexcept { return checkpoints_; }
+
+private:
+  /// The approximate number of code units of the text between checkpoints.
+  std::size_t interval_;
+  /// The offsets of code point boundaries at roughly every interval_ code units of the text.
+  Container checkpoints_;
+  /// The offsets of the end of the text that has been added to the index.
+  offsets total_;
+
+  /// \param off  The offsets to be accessed.
+  /// \returns  The offset in code units of the indexed text.
+  static constexpr std::size_t& source (offsets& off) noexcept { return details::offset_of<input_type> (off); }
+  /// \param off  The offsets to be accessed.
+  /// \returns  The offset in code units of the indexed text.
+  static constexpr std::size_t source (offsets const& off) noexcept { return off.get<input_type> (); }
+  /// Moves \p off past the code point which starts with \p code_unit in every encoding other than that of the indexed
+  /// text. The offset in the indexed text is advanced one code unit at a time by the caller.
+  ///
+  /// \param off  The offsets to be advanced.
+  /// \param code_unit  The first code unit of a code point.
+  static constexpr void advance (offsets& off, input_type const code_unit) noexcept {
+    auto const src = source (off);
+    auto const widths = details::code_point_widths (code_unit);
+    off.utf8 += widths.utf8;
+    off.utf16 += widths.utf16;
+    off.utf32 += widths.utf32;
+    source (off) = src;
+  }
+};
+
+/// The action taken by a transcoder when it encounters ill-formed input. Whichever is selected, the transcoder's
+/// well_formed() state becomes false.
+enum class error_policy {
+  replace,    ///< Each ill-formed sequence is replaced by U+FFFD REPLACEMENT CHARACTER. This is the default.
+  skip,       ///< Ill-formed sequences are dropped from the output.
+  stop,       ///< As skip, but all further input is discarded until the transcoder's set_well_formed(true) is called.
+  exception,  ///< std::range_error is thrown.
+};
+
 #if ICUBABY_HAVE_CONCEPTS
 /// \brief Defines the requirements of a type that provides the transcoder interface.
 template <typename T>
@@ -555,6 +1279,17 @@ concept is_transcoder = requires (T coder) {
 
 #endif  // ICUBABY_HAVE_CONCEPTS
 
+/// \brief The value returned by a transcoder's bulk transcode() member function.
+struct transcode_result {
+  /// The number of input code units consumed.
+  std::size_t consumed = 0;
+  /// The number of code units written to the output.
+  std::size_t produced = 0;
+  /// True if the transcoder was left holding a partial code point which will be completed by the input passed to a
+  /// subsequent call.
+  bool partial = false;
+};
+
 template <typename Transcoder, typename OutputIterator>
 ICUBABY_REQUIRES ((is_transcoder<Transcoder> && std::output_iterator<OutputIterator, typename Transcoder::output_type>))
 class iterator;
@@ -564,26 +1299,54 @@ class iterator;
 ///
 /// Each of the specializations of this template (there is one for each input/output combination) supplies the same
 /// interface.
-template <typename FromEncoding, typename ToEncoding>
+///
+/// \tparam FromEncoding  The type of the input code units or std::byte.
+/// \tparam ToEncoding  The type of the output code units.
+/// \tparam Policy  The action taken when ill-formed input is encountered.
+template <typename FromEncoding, typename ToEncoding, error_policy Policy = error_policy::replace>
 class transcoder {
 public:
   /// The type of the code units consumed by this transcoder.
   using input_type = FromEncoding;
   /// The type of the code units produced by this transcoder.
   using output_type = ToEncoding;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
 
   /// \anchor transcoder-call-operator
   /// This member function is the heart of the transcoder. It accepts a single byte or code unit in the input encoding
   /// and, once an entire code point has been consumed, produces the equivalent code point expressed in the output
-  /// encoding. Malformed input is detected and replaced with the Unicode replacement character (U+FFFD REPLACEMENT
-  /// CHARACTER).
+  /// encoding. Malformed input is detected and handled as the transcoder's error policy dictates: by default, it is
+  /// replaced with the Unicode replacement character (U+FFFD REPLACEMENT CHARACTER). A transcoder whose policy is
+  /// error_policy::stop produces no output while its well_formed() state is false.
   ///
   /// \tparam OutputIterator  An output iterator type to which values of type transcoder::output_type can be written.
   /// \param code_unit  A code unit in the source encoding.
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept;
+  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept (Policy != error_policy::exception);
+
+#if ICUBABY_HAVE_SPAN
+  /// \anchor transcoder-transcode
+  /// Converts a block of code units in a single call. The effect is the same as passing each member of \p input in turn
+  /// to \ref transcoder-call-operator "operator()" but conversion stops early if \p output does not have room for the
+  /// code units that would be produced by the next input value. Any partial code point is carried over in the
+  /// transcoder's state to the next call. Calls may be freely interleaved with calls to
+  /// \ref transcoder-call-operator "operator()" and, once all of the input has been supplied, end_cp() must be called
+  /// as usual.
+  ///
+  /// If the transcoder's policy is error_policy::stop, conversion also stops immediately after the code unit at which
+  /// ill-formed input is detected. A transcoder which has stopped consumes the whole of \p input without producing any
+  /// output.
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input, std::span<output_type> output) noexcept (
+      Policy != error_policy::exception);
+#endif  // ICUBABY_HAVE_SPAN
 
   /// Call once the entire input sequence has been fed to \ref transcoder-call-operator "operator()". This function
   /// ensures that the sequence did not end with a partial code point.
@@ -607,6 +1370,14 @@ public:
   /// \returns True if the input was well formed.
   [[nodiscard]] constexpr bool well_formed () const noexcept;
 
+  /// \anchor transcoder-set-well-formed
+  /// Sets the transcoder's "well formed" state without discarding a partial code point. The state is normally
+  /// "sticky": once ill-formed input has been seen, well_formed() returns false. Resetting it to true allows each
+  /// ill-formed sequence in a stream to be detected in turn.
+  ///
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool well_formed) noexcept;
+
   /// \brief Indicates whether a "partial" code point has been passed to \ref transcoder-call-operator "operator()".
   ///
   /// If true, one or more code units are required to build the complete code point.
@@ -714,52 +1485,1062 @@ inline constexpr auto utf16_shift = 10U;
 /// A value with the least significant 10 bits set. Used to create a UTF-16 low surrogate value.
 inline constexpr auto utf16_mask = static_cast<std::uint_least16_t> ((1U << utf16_shift) - 1U);
 
-}  // end namespace details
+/// Writes a Unicode scalar value as one or two UTF-16 code units.
+///
+/// \tparam OutputIterator  An output iterator type to which values of type char16_t can be written.
+/// \param code_point  The code point to be written. Must be a valid Unicode scalar value.
+/// \param dest  Iterator to which the output should be written.
+/// \returns  Iterator one past the last element assigned.
+template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (char16_t) OutputIterator>
+OutputIterator write_utf16 (std::uint_least32_t const code_point, OutputIterator dest) {
+  assert (code_point <= max_code_point && !is_surrogate (static_cast<char32_t> (code_point)));
+  if (code_point <= 0xFFFF) {
+    *(dest++) = static_cast<char16_t> (code_point);
+  } else {
+    // Code points from beyond plane 0 are encoded as a two 16-bit code unit surrogate pair. The first code
+    // unit is the high surrogate and the second is the low surrogate.
+    // - 0x10000 is subtracted from the code point, leaving a 20-bit number (0x00000–0xFFFFF).
+    // - The high ten bits (0x0000–0x03FF) are added to 0xD800 to give the high surrogate (0xD800–0xDBFF).
+    // - The low ten bits (0x000–0x3FF) are added to 0xDC00 to give the low surrogate (0xDC00–0xDFFF).
+    *(dest++) = static_cast<char16_t> (static_cast<std::uint_least32_t> (first_high_surrogate) -
+                                       (utf16_first_surrogate_pair >> utf16_shift) + (code_point >> utf16_shift));
+    *(dest++) =
+        static_cast<char16_t> (static_cast<std::uint_least32_t> (first_low_surrogate) + (code_point & utf16_mask));
+  }
+  return dest;
+}
 
-/// Takes a sequence of UTF-32 code units and converts them to UTF-8.
-template <> class transcoder<char32_t, char8> {
-public:
-  /// The type of the code units consumed by this transcoder.
-  using input_type = char32_t;
-  /// The type of the code units produced by this transcoder.
-  using output_type = char8;
+/// The utf8d table drives the UTF-8 decoder and validator. It consists of two parts. The first part maps bytes to
+/// character classes, the second part encodes a deterministic finite automaton using these character classes as
+/// transitions.
+/// \hideinitializer
+inline constexpr std::array<std::uint_least8_t, 364> utf8d = {{
+  // clang-format off
+  // The first part of the table maps bytes to character classes that
+  // reduce the size of the transition table and create bitmasks.
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+   8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+  10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
+
+  // The second part is a transition table that maps a combination
+  // of a state of the automaton and a character class to a state.
+   0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
+  12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
+  12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
+  12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
+  12,36,12,12,12,12,12,12,12,12,12,12,
+  // clang-format on
+}};
 
-  constexpr transcoder () noexcept = default;
-  /// Initializes a transcoder instance with an initial value for its "well formed" state. This can be useful if
-  /// converting a stream of data which may be using different encodings.
-  ///
-  /// \param well_formed The initial value for the transcoder's "well formed" state.
-  explicit constexpr transcoder (bool well_formed) noexcept : well_formed_{well_formed} {}
+/// The state of the utf8d automaton between code points.
+inline constexpr auto utf8d_accept = std::uint_least8_t{0};
+/// The state of the utf8d automaton once ill-formed input has been encountered.
+inline constexpr auto utf8d_reject = std::uint_least8_t{12};
 
-  /// Accepts a code unit in the UTF-32 source encoding. As UTF-8 output code units are generated, they are written to
-  /// the output iterator \p dest.
-  ///
-  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param code_unit  A code unit in the source encoding.
-  /// \param dest  An output iterator to which the output sequence is written.
-  /// \returns  Iterator one past the last element assigned.
-  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept {
-    if (code_unit < 0x80) {
-      *(dest++) = static_cast<output_type> (code_unit);
-      return dest;
-    }
-    if (code_unit < 0x800) {
-      return transcoder::write2 (code_unit, dest);
-    }
-    if (is_surrogate (code_unit)) {
-      return transcoder::not_well_formed (dest);
-    }
-    if (code_unit < 0x10000) {
-      return transcoder::write3 (code_unit, dest);
-    }
-    if (code_unit <= max_code_point) {
-      return transcoder::write4 (code_unit, dest);
-    }
-    return transcoder::not_well_formed (dest);
+/// Advances the utf8d automaton by a single code unit.
+///
+/// \param state  The current state of the automaton.
+/// \param code_unit  The UTF-8 code unit to be consumed.
+/// \returns  The new state of the automaton.
+constexpr std::uint_least8_t utf8d_next (std::uint_least8_t const state, std::uint_least8_t const code_unit) noexcept {
+  static_assert (utf8d.size () > 255);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+  auto const type = utf8d[code_unit];
+  auto const idx = 256U + state + type;
+  assert (idx < utf8d.size ());
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+  return utf8d[idx];
+}
+
+/// \brief Called by a transcoder when it finds ill-formed input.
+///
+/// \tparam Policy  The transcoder's error policy.
+/// \returns  True if a REPLACEMENT CHARACTER is to be written in place of the ill-formed input.
+/// \throws std::range_error  If \p Policy is error_policy::exception.
+template <error_policy Policy> constexpr bool replace_ill_formed () noexcept (Policy != error_policy::exception) {
+  if constexpr (Policy == error_policy::exception) {
+    throw std::range_error{"icubaby: ill-formed input"};
+  } else {
+    return Policy == error_policy::replace;
   }
+}
 
-  /// Call once the entire input sequence has been fed to operator(). This
+/// \tparam Policy  A transcoder's error policy.
+/// \param well_formed  The transcoder's "well formed" state.
+/// \returns  True if a transcoder with error policy \p Policy and the given "well formed" state has stopped: that is,
+///   it discards its input.
+template <error_policy Policy> constexpr bool stopped (bool const well_formed) noexcept {
+  return Policy == error_policy::stop && !well_formed;
+}
+
+/// The error policy of a transcoder type: its policy member if it has one, otherwise error_policy::replace.
+template <typename Transcoder, typename = void> inline constexpr auto policy_of = error_policy::replace;
+/// The error policy of a transcoder type: its policy member if it has one, otherwise error_policy::replace.
+template <typename Transcoder>
+inline constexpr auto policy_of<Transcoder, std::void_t<decltype (Transcoder::policy)>> = Transcoder::policy;
+
+/// \brief Passes the code units in the range [\p first, \p last) to a transcoder writing the result to the range
+///   [\p out_first, \p out_last).
+///
+/// Conversion stops when the input is exhausted or when the output range may not have space for the code units
+/// produced by the next input value. Once the output range is almost full, each input value is converted into a
+/// small scratch buffer: if the result does not fit, the transcoder's state is restored and conversion ends. This
+/// means that the output can be filled exactly. For a transcoder whose policy is error_policy::stop, conversion also
+/// ends after the code unit at which ill-formed input was found.
+///
+/// \tparam Transcoder  The type of the transcoder used to convert the input.
+/// \param transcoder  The transcoder used to convert the input.
+/// \param first  The start of the range of input code units.
+/// \param last  The end of the range of input code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced together with the transcoder's partial state.
+template <typename Transcoder>
+transcode_result transcode_block (Transcoder& transcoder, typename Transcoder::input_type const* const first,
+                                  typename Transcoder::input_type const* const last,
+                                  typename Transcoder::output_type* const out_first,
+                                  typename Transcoder::output_type* const out_last) noexcept (Transcoder::policy !=
+                                                                                             error_policy::exception) {
+  using input_type = typename Transcoder::input_type;
+  using output_type = typename Transcoder::output_type;
+  constexpr auto max_units = max_output_units<input_type, output_type>;
+  constexpr auto policy = Transcoder::policy;
+
+  if (stopped<policy> (transcoder.well_formed ())) {
+    // A transcoder which has stopped discards its input.
+    return {static_cast<std::size_t> (last - first), 0, transcoder.partial ()};
+  }
+  auto const* in = first;
+  auto* out = out_first;
+  // Convert input until we're close to filling the output.
+  while (in != last && static_cast<std::size_t> (out_last - out) >= max_units) {
+    out = transcoder (*(in++), out);
+    if (stopped<policy> (transcoder.well_formed ())) {
+      return {static_cast<std::size_t> (in - first), static_cast<std::size_t> (out - out_first),
+              transcoder.partial ()};
+    }
+  }
+  for (; in != last; ++in) {
+    std::array<output_type, max_units> scratch{};
+    auto const prev = transcoder;
+    // NOLINTNEXTLINE(llvm-qualified-auto,readability-qualified-auto)
+    auto const scratch_end = transcoder (*in, scratch.begin ());
+    auto const size = scratch_end - scratch.begin ();
+    if (size > out_last - out) {
+      // There's no room for the output from this code unit. Put things back as they were.
+      transcoder = prev;
+      break;
+    }
+    out = std::copy (scratch.begin (), scratch_end, out);
+    if (stopped<policy> (transcoder.well_formed ())) {
+      ++in;
+      break;
+    }
+  }
+  return {static_cast<std::size_t> (in - first), static_cast<std::size_t> (out - out_first), transcoder.partial ()};
+}
+
+/// \brief Writes a Unicode scalar value as between one and four UTF-8 code units.
+///
+/// The following table shows how each range of code points is converted to a series of UTF-8 bytes.
+///
+/// | First CP | Last CP  | Byte 1   | Byte 2   | Byte 3   | Byte 4   |
+/// | -------- | -------- | -------- | -------- | -------- | -------- |
+/// | U+0000   | U+007F   | 0xxxxxxx |          |          |          |
+/// | U+0080   | U+07FF   | 110xxxxx | 10xxxxxx |          |          |
+/// | U+0800   | U+FFFF   | 1110xxxx | 10xxxxxx | 10xxxxxx |          |
+/// | U+010000 | U+10FFFF | 11110xxx | 10xxxxxx | 10xxxxxx | 10xxxxxx |
+///
+/// \tparam OutputIterator  An output iterator type to which values of type char8 can be written.
+/// \param code_point  The code point to be written. Must be a valid Unicode scalar value.
+/// \param dest  Iterator to which the output should be written.
+/// \returns  Iterator one past the last element assigned.
+template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (char8) OutputIterator>
+OutputIterator write_utf8 (std::uint_least32_t const code_point, OutputIterator dest) {
+  assert (code_point <= max_code_point && !is_surrogate (static_cast<char32_t> (code_point)));
+  // The masks to indicate the first byte of a two, three, and four byte sequence.
+  constexpr auto byte_1_of_2 = std::uint_least8_t{0b1100'0000};
+  constexpr auto byte_1_of_3 = std::uint_least8_t{0b1110'0000};
+  constexpr auto byte_1_of_4 = std::uint_least8_t{0b1111'0000};
+  // Produces a continuation byte (that is byte two of a two byte sequence, bytes two and three of a three byte
+  // sequence, and so on) carrying six bits of the code point starting at bit 'shift'.
+  auto const continuation = [code_point] (unsigned const shift) {
+    return static_cast<char8> (((code_point >> shift) & utf8_mask) | 0b1000'0000U);
+  };
+  if (code_point < 0x80) {
+    *(dest++) = static_cast<char8> (code_point);
+  } else if (code_point < 0x800) {
+    *(dest++) = static_cast<char8> ((code_point >> utf8_shift) | byte_1_of_2);
+    *(dest++) = continuation (0U);
+  } else if (code_point < 0x10000) {
+    *(dest++) = static_cast<char8> ((code_point >> (utf8_shift * 2U)) | byte_1_of_3);
+    *(dest++) = continuation (utf8_shift);
+    *(dest++) = continuation (0U);
+  } else {
+    *(dest++) = static_cast<char8> ((code_point >> (utf8_shift * 3U)) | byte_1_of_4);
+    *(dest++) = continuation (utf8_shift * 2U);
+    *(dest++) = continuation (utf8_shift);
+    *(dest++) = continuation (0U);
+  }
+  return dest;
+}
+
+/// \brief Copies the longest prefix of [\p first, \p last) which consists only of ASCII code units to \p out, widening
+///   each to UTF-16 or UTF-32.
+///
+/// Blocks of code units are tested and widened using SSE2/AVX2 instructions where they are available and eight at a
+/// time using ordinary integer arithmetic otherwise.
+///
+/// \tparam OutputType  The output code unit type: either char16_t or char32_t.
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \param out  The start of the output range. This must have room for at least (\p last - \p first) elements.
+/// \returns  The number of code units copied.
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+template <typename OutputType>
+std::size_t ascii_widen (char8 const* const first, char8 const* const last, OutputType* out) noexcept {
+  static_assert (std::is_same_v<OutputType, char16_t> || std::is_same_v<OutputType, char32_t>);
+  auto const* in = first;
+#if ICUBABY_HAVE_AVX2
+  for (; last - in >= 32; in += 32, out += 32) {
+    auto const bytes = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (in));
+    if (_mm256_movemask_epi8 (bytes) != 0) {
+      break;  // There's at least one non-ASCII code unit in this block.
+    }
+    auto const low = _mm256_castsi256_si128 (bytes);
+    auto const high = _mm256_extracti128_si256 (bytes, 1);
+    auto* const dest = reinterpret_cast<__m256i*> (out);
+    if constexpr (std::is_same_v<OutputType, char16_t>) {
+      _mm256_storeu_si256 (dest, _mm256_cvtepu8_epi16 (low));
+      _mm256_storeu_si256 (dest + 1, _mm256_cvtepu8_epi16 (high));
+    } else {
+      _mm256_storeu_si256 (dest, _mm256_cvtepu8_epi32 (low));
+      _mm256_storeu_si256 (dest + 1, _mm256_cvtepu8_epi32 (_mm_srli_si128 (low, 8)));
+      _mm256_storeu_si256 (dest + 2, _mm256_cvtepu8_epi32 (high));
+      _mm256_storeu_si256 (dest + 3, _mm256_cvtepu8_epi32 (_mm_srli_si128 (high, 8)));
+    }
+  }
+#endif  // ICUBABY_HAVE_AVX2
+#if ICUBABY_HAVE_SSE2
+  for (; last - in >= 16; in += 16, out += 16) {
+    auto const bytes = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (in));
+    if (_mm_movemask_epi8 (bytes) != 0) {
+      break;  // There's at least one non-ASCII code unit in this block.
+    }
+    auto const zero = _mm_setzero_si128 ();
+    auto const low = _mm_unpacklo_epi8 (bytes, zero);
+    auto const high = _mm_unpackhi_epi8 (bytes, zero);
+    auto* const dest = reinterpret_cast<__m128i*> (out);
+    if constexpr (std::is_same_v<OutputType, char16_t>) {
+      _mm_storeu_si128 (dest, low);
+      _mm_storeu_si128 (dest + 1, high);
+    } else {
+      _mm_storeu_si128 (dest, _mm_unpacklo_epi16 (low, zero));
+      _mm_storeu_si128 (dest + 1, _mm_unpackhi_epi16 (low, zero));
+      _mm_storeu_si128 (dest + 2, _mm_unpacklo_epi16 (high, zero));
+      _mm_storeu_si128 (dest + 3, _mm_unpackhi_epi16 (high, zero));
+    }
+  }
+#else
+  constexpr auto word_size = sizeof (std::uint_least64_t);
+  if constexpr (sizeof (char8) == 1 && CHAR_BIT == 8) {
+    for (; static_cast<std::size_t> (last - in) >= word_size; in += word_size) {
+      std::uint_least64_t word = 0;
+      std::memcpy (&word, in, word_size);
+      if ((word & UINT64_C (0x8080808080808080)) != 0U) {
+        break;  // There's at least one non-ASCII code unit in this word.
+      }
+      out = std::transform (in, in + word_size, out, [] (char8 const cu) {
+        return static_cast<OutputType> (static_cast<std::uint_least8_t> (cu));
+      });
+    }
+  }
+#endif  // ICUBABY_HAVE_SSE2
+  // Copy any remaining ASCII code units one at a time.
+  for (; in != last; ++in, ++out) {
+    auto const cu = static_cast<std::uint_least8_t> (*in);
+    if (cu > 0x7F) {
+      break;
+    }
+    *out = static_cast<OutputType> (cu);
+  }
+  return static_cast<std::size_t> (in - first);
+}
+
+/// \brief Returns the length of the longest prefix of [\p first, \p last) which consists only of ASCII code units.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \returns  The number of ASCII code units at the start of the range.
+inline std::size_t ascii_prefix_length (char8 const* const first, char8 const* const last) noexcept {
+  auto const* in = first;
+#if ICUBABY_HAVE_SSE2
+  for (; last - in >= 16 && _mm_movemask_epi8 (_mm_loadu_si128 (reinterpret_cast<__m128i const*> (in))) == 0;
+       in += 16) {
+  }
+#else
+  constexpr auto word_size = sizeof (std::uint_least64_t);
+  if constexpr (sizeof (char8) == 1 && CHAR_BIT == 8) {
+    for (; static_cast<std::size_t> (last - in) >= word_size; in += word_size) {
+      std::uint_least64_t word = 0;
+      std::memcpy (&word, in, word_size);
+      if ((word & UINT64_C (0x8080808080808080)) != 0U) {
+        break;
+      }
+    }
+  }
+#endif  // ICUBABY_HAVE_SSE2
+  for (; in != last && static_cast<std::uint_least8_t> (*in) < 0x80; ++in) {
+  }
+  return static_cast<std::size_t> (in - first);
+}
+
+/// \brief Finds the start of an incomplete UTF-8 sequence at the end of the range [\p first, \p last).
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \returns  The position of the lead byte of a sequence which is cut short by the end of the range or \p last if
+///   there is no such sequence.
+inline char8 const* utf8_incomplete_tail (char8 const* const first, char8 const* const last) noexcept {
+  for (auto back = std::ptrdiff_t{1}; back <= 3 && back <= last - first; ++back) {
+    auto const cu = static_cast<std::uint_least8_t> (*(last - back));
+    if ((cu & 0xC0U) != 0x80U) {
+      // This is not a continuation byte. If it is the first byte of a multi-byte sequence, does that sequence extend
+      // beyond the end of the range?
+      if (cu >= 0xC0U) {
+        auto const length = cu >= 0xF0U ? 4 : (cu >= 0xE0U ? 3 : 2);
+        if (length > back) {
+          return last - back;
+        }
+      }
+      break;
+    }
+  }
+  return last;
+}
+
+#if ICUBABY_HAVE_SSSE3
+/// \brief The lookup tables used by the vectorized UTF-8 validator.
+///
+/// This is the algorithm described by John Keiser and Daniel Lemire in "Validating UTF-8 In Less Than One
+/// Instruction Per Byte" (Software: Practice and Experience, 2021). Each pair of adjacent bytes is classified using
+/// three 16-entry tables indexed by the high nibble of the first byte, the low nibble of the first byte, and the high
+/// nibble of the second byte. The AND of the three lookups is non-zero only if the pair is ill-formed. Checks which
+/// need a third or fourth byte are performed separately.
+namespace utf8_lookup {
+
+inline constexpr std::uint8_t too_short = 1U << 0U;   ///< 11______ 0_______ or 11______ 11______
+inline constexpr std::uint8_t too_long = 1U << 1U;    ///< 0_______ 10______
+inline constexpr std::uint8_t overlong_3 = 1U << 2U;  ///< 11100000 100_____
+inline constexpr std::uint8_t too_large = 1U << 3U;   ///< 11110100 1001____ or 11110100 101_____ or 111101__ ...
+inline constexpr std::uint8_t surrogate = 1U << 4U;   ///< 11101101 101_____
+inline constexpr std::uint8_t overlong_2 = 1U << 5U;  ///< 1100000_ 10______
+inline constexpr std::uint8_t too_large_1000 = 1U << 6U;  ///< 11110101 1000____ or 1111011_ 1000____ or ...
+inline constexpr std::uint8_t overlong_4 = 1U << 6U;      ///< 11110000 1000____
+inline constexpr std::uint8_t two_conts = 1U << 7U;       ///< 10______ 10______
+inline constexpr std::uint8_t carry = too_short | too_long | two_conts;
+
+/// Indexed by the high nibble of the first byte of a pair.
+inline constexpr std::array<std::uint8_t, 16> byte_1_high{{
+    // 0_______ ________ (ASCII in byte 1)
+    too_long, too_long, too_long, too_long, too_long, too_long, too_long, too_long,
+    // 10______ ________ (continuation in byte 1)
+    two_conts, two_conts, two_conts, two_conts,
+    // 1100____ ________ (two byte lead in byte 1)
+    too_short | overlong_2,
+    // 1101____ ________ (two byte lead in byte 1)
+    too_short,
+    // 1110____ ________ (three byte lead in byte 1)
+    too_short | overlong_3 | surrogate,
+    // 1111____ ________ (four+ byte lead in byte 1)
+    too_short | too_large | too_large_1000 | overlong_4,
+}};
+/// Indexed by the low nibble of the first byte of a pair.
+inline constexpr std::array<std::uint8_t, 16> byte_1_low{{
+    carry | overlong_3 | overlong_2 | overlong_4,  // ____0000 ________
+    carry | overlong_2,                            // ____0001 ________
+    carry,                                         // ____001_ ________
+    carry,
+    carry | too_large,                   // ____0100 ________
+    carry | too_large | too_large_1000,  // ____0101 ________
+    carry | too_large | too_large_1000,  // ____011_ ________
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,  // ____1___ ________
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000 | surrogate,  // ____1101 ________
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+}};
+/// Indexed by the high nibble of the second byte of a pair.
+inline constexpr std::array<std::uint8_t, 16> byte_2_high{{
+    // ________ 0_______ (ASCII in byte 2)
+    too_short, too_short, too_short, too_short, too_short, too_short, too_short, too_short,
+    // ________ 1000____
+    too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+    // ________ 1001____
+    too_long | overlong_2 | two_conts | overlong_3 | too_large,
+    // ________ 101_____
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    // ________ 11______
+    too_short, too_short, too_short, too_short,
+}};
+
+}  // end namespace utf8_lookup
+
+/// \brief Checks a block of 16 UTF-8 code units using SSSE3 instructions.
+///
+/// \param input  The block of code units to be checked.
+/// \param prev_input  The preceding block of code units. Use a block of zeros if \p input starts at a code point
+///   boundary.
+/// \returns  A vector which is non-zero if an ill-formed sequence ends within \p input. A sequence which is cut short
+///   by the end of the block is not reported.
+inline __m128i utf8_check_block_ssse3 (__m128i const input, __m128i const prev_input) noexcept {
+  auto const table = [] (std::array<std::uint8_t, 16> const& t) {
+    return _mm_loadu_si128 (reinterpret_cast<__m128i const*> (t.data ()));
+  };
+  auto const nibble = _mm_set1_epi8 (0x0F);
+  auto const prev1 = _mm_alignr_epi8 (input, prev_input, 16 - 1);
+  auto const special_cases = _mm_and_si128 (
+      _mm_and_si128 (
+          _mm_shuffle_epi8 (table (utf8_lookup::byte_1_high), _mm_and_si128 (_mm_srli_epi16 (prev1, 4), nibble)),
+          _mm_shuffle_epi8 (table (utf8_lookup::byte_1_low), _mm_and_si128 (prev1, nibble))),
+      _mm_shuffle_epi8 (table (utf8_lookup::byte_2_high), _mm_and_si128 (_mm_srli_epi16 (input, 4), nibble)));
+  // Bytes which must be the second continuation of a three or four byte sequence or the third continuation of a
+  // four byte sequence.
+  auto const prev2 = _mm_alignr_epi8 (input, prev_input, 16 - 2);
+  auto const prev3 = _mm_alignr_epi8 (input, prev_input, 16 - 3);
+  auto const must_be_23_continuation =
+      _mm_or_si128 (_mm_subs_epu8 (prev2, _mm_set1_epi8 (static_cast<char> (0xE0 - 0x80))),
+                    _mm_subs_epu8 (prev3, _mm_set1_epi8 (static_cast<char> (0xF0 - 0x80))));
+  auto const must_be_23_continuation_80 =
+      _mm_and_si128 (must_be_23_continuation, _mm_set1_epi8 (static_cast<char> (0x80)));
+  return _mm_xor_si128 (must_be_23_continuation_80, special_cases);
+}
+
+/// \brief Validates blocks of 16 UTF-8 code units at a time using SSSE3 instructions.
+///
+/// The range must start at a code point boundary. Validation stops at the final block boundary or, if the last block
+/// ends with a partial code point, at the start of that code point.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \returns  The position at which validation stopped or nullptr if the input is ill-formed.
+inline char8 const* validate_utf8_ssse3 (char8 const* const first, char8 const* const last) noexcept {
+  // A block ending in any byte greater than these values is cut short.
+  auto const incomplete_max =
+      _mm_setr_epi8 (-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast<char> (0xF0 - 1),
+                     static_cast<char> (0xE0 - 1), static_cast<char> (0xC0 - 1));
+
+  auto const* in = first;
+  auto prev_input = _mm_setzero_si128 ();
+  auto prev_incomplete = _mm_setzero_si128 ();
+  auto error = _mm_setzero_si128 ();
+  for (; last - in >= 16; in += 16) {
+    auto const input = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (in));
+    if (_mm_movemask_epi8 (input) == 0) {
+      // An all-ASCII block is valid unless the previous block was cut short.
+      error = _mm_or_si128 (error, prev_incomplete);
+      prev_incomplete = _mm_setzero_si128 ();
+    } else {
+      error = _mm_or_si128 (error, utf8_check_block_ssse3 (input, prev_input));
+      prev_incomplete = _mm_subs_epu8 (input, incomplete_max);
+    }
+    prev_input = input;
+  }
+  if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (error, _mm_setzero_si128 ())) != 0xFFFF) {
+    return nullptr;
+  }
+  return utf8_incomplete_tail (first, in);
+}
+#endif  // ICUBABY_HAVE_SSSE3
+
+#if ICUBABY_HAVE_AVX2
+/// \brief Validates blocks of 32 UTF-8 code units at a time using AVX2 instructions.
+///
+/// This is the same algorithm as validate_utf8_ssse3() using vectors which are twice as wide.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \returns  The position at which validation stopped or nullptr if the input is ill-formed.
+inline char8 const* validate_utf8_avx2 (char8 const* const first, char8 const* const last) noexcept {
+  auto const table = [] (std::array<std::uint8_t, 16> const& t) {
+    return _mm256_broadcastsi128_si256 (_mm_loadu_si128 (reinterpret_cast<__m128i const*> (t.data ())));
+  };
+  auto const byte_1_high = table (utf8_lookup::byte_1_high);
+  auto const byte_1_low = table (utf8_lookup::byte_1_low);
+  auto const byte_2_high = table (utf8_lookup::byte_2_high);
+  auto const nibble = _mm256_set1_epi8 (0x0F);
+  auto const incomplete_max =
+      _mm256_setr_epi8 (-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                        -1, -1, -1, -1, -1, static_cast<char> (0xF0 - 1), static_cast<char> (0xE0 - 1),
+                        static_cast<char> (0xC0 - 1));
+
+  auto const* in = first;
+  auto prev_input = _mm256_setzero_si256 ();
+  auto prev_incomplete = _mm256_setzero_si256 ();
+  auto error = _mm256_setzero_si256 ();
+  for (; last - in >= 32; in += 32) {
+    auto const input = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (in));
+    if (_mm256_movemask_epi8 (input) == 0) {
+      error = _mm256_or_si256 (error, prev_incomplete);
+      prev_incomplete = _mm256_setzero_si256 ();
+    } else {
+      // The AVX2 alignr instruction works on each 128-bit lane independently: build a vector whose low lane is the
+      // high lane of the previous input and whose high lane is the low lane of this input.
+      auto const shifted = _mm256_permute2x128_si256 (prev_input, input, 0x21);
+      auto const prev1 = _mm256_alignr_epi8 (input, shifted, 16 - 1);
+      auto const special_cases = _mm256_and_si256 (
+          _mm256_and_si256 (_mm256_shuffle_epi8 (byte_1_high, _mm256_and_si256 (_mm256_srli_epi16 (prev1, 4), nibble)),
+                            _mm256_shuffle_epi8 (byte_1_low, _mm256_and_si256 (prev1, nibble))),
+          _mm256_shuffle_epi8 (byte_2_high, _mm256_and_si256 (_mm256_srli_epi16 (input, 4), nibble)));
+      auto const prev2 = _mm256_alignr_epi8 (input, shifted, 16 - 2);
+      auto const prev3 = _mm256_alignr_epi8 (input, shifted, 16 - 3);
+      auto const must_be_23_continuation =
+          _mm256_or_si256 (_mm256_subs_epu8 (prev2, _mm256_set1_epi8 (static_cast<char> (0xE0 - 0x80))),
+                           _mm256_subs_epu8 (prev3, _mm256_set1_epi8 (static_cast<char> (0xF0 - 0x80))));
+      auto const must_be_23_continuation_80 =
+          _mm256_and_si256 (must_be_23_continuation, _mm256_set1_epi8 (static_cast<char> (0x80)));
+      error = _mm256_or_si256 (error, _mm256_xor_si256 (must_be_23_continuation_80, special_cases));
+      prev_incomplete = _mm256_subs_epu8 (input, incomplete_max);
+    }
+    prev_input = input;
+  }
+  if (!_mm256_testz_si256 (error, error)) {
+    return nullptr;
+  }
+  return utf8_incomplete_tail (first, in);
+}
+
+/// \brief Builds a table of pshufb controls which gather the selected 16-bit lanes of an 8-lane vector.
+///
+/// Entry n of the table moves each lane whose bit is set in n to the front of the vector, preserving their order.
+/// Unused lanes are zeroed.
+///
+/// \returns  The table of shuffle controls.
+constexpr std::array<std::array<std::uint8_t, 16>, 256> make_compress_epi16_table () noexcept {
+  std::array<std::array<std::uint8_t, 16>, 256> result{};
+  for (auto mask = std::size_t{0}; mask < result.size (); ++mask) {
+    auto pos = std::size_t{0};
+    for (auto lane = 0U; lane < 8U; ++lane) {
+      if ((mask & (1U << lane)) != 0U) {
+        result[mask][pos++] = static_cast<std::uint8_t> (lane * 2U);
+        result[mask][pos++] = static_cast<std::uint8_t> (lane * 2U + 1U);
+      }
+    }
+    for (; pos < result[mask].size (); ++pos) {
+      result[mask][pos] = 0x80;
+    }
+  }
+  return result;
+}
+/// The shuffle controls used to compress 16-bit lanes. See make_compress_epi16_table().
+inline constexpr auto compress_epi16_table = make_compress_epi16_table ();
+
+/// \brief Builds a table containing the number of bits set in each 8-bit value.
+///
+/// \returns  The table of bit counts.
+constexpr std::array<std::uint8_t, 256> make_popcount8_table () noexcept {
+  std::array<std::uint8_t, 256> result{};
+  for (auto value = std::size_t{1}; value < result.size (); ++value) {
+    result[value] = static_cast<std::uint8_t> (result[value >> 1U] + (value & 1U));
+  }
+  return result;
+}
+/// The number of bits set in each 8-bit value.
+inline constexpr auto popcount8_table = make_popcount8_table ();
+
+/// \brief Converts UTF-8 to UTF-16 sixteen input bytes at a time using AVX2 (or AVX-512 VBMI2) instructions.
+///
+/// The input must start at a code point boundary. Each block is validated with utf8_check_block_ssse3(). The code
+/// point starting at each byte position is then computed in a 16-bit lane assuming that the byte is the first of a
+/// one, two, or three byte sequence, and the lanes which correspond to continuation bytes are squeezed out. The
+/// kernel stops at the first block which contains a four byte sequence or ill-formed input, or when fewer than 18
+/// input bytes or 16 output code units remain. The caller is expected to handle whatever remains one code unit at a
+/// time.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced. Conversion always stops at a code point boundary.
+inline transcode_result utf8_to_utf16_avx2 (char8 const* const first, char8 const* const last,
+                                            char16_t* const out_first, char16_t* const out_last) noexcept {
+  auto const* in = first;
+  auto* out = out_first;
+  // We look two bytes beyond each 16 byte block to find the continuation bytes of a sequence which starts in the
+  // block.
+  while (last - in >= 18 && out_last - out >= 16) {
+    auto const bytes = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (in));
+    if (_mm_movemask_epi8 (bytes) == 0) {
+      // The block is entirely ASCII.
+      _mm256_storeu_si256 (reinterpret_cast<__m256i*> (out), _mm256_cvtepu8_epi16 (bytes));
+      in += 16;
+      out += 16;
+      continue;
+    }
+    // Bytes greater than 0xEF are either the first byte of a four byte sequence or are ill-formed.
+    auto const zero = _mm_setzero_si128 ();
+    auto const four_byte = _mm_subs_epu8 (bytes, _mm_set1_epi8 (static_cast<char> (0xEF)));
+    auto const error = _mm_or_si128 (four_byte, utf8_check_block_ssse3 (bytes, zero));
+    if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (error, zero)) != 0xFFFF) {
+      break;
+    }
+    // Don't convert a code point which is cut short by the end of the block.
+    auto const length = static_cast<unsigned> (utf8_incomplete_tail (in, in + 16) - in);
+    // Continuation bytes (0x80-0xBF) are the only values less than 0xC0 when compared as signed 8-bit integers.
+    auto const continuation =
+        static_cast<unsigned> (_mm_movemask_epi8 (_mm_cmplt_epi8 (bytes, _mm_set1_epi8 (static_cast<char> (0xC0)))));
+    auto const starts = ~continuation & ((1U << length) - 1U);
+
+    auto const byte0 = _mm256_cvtepu8_epi16 (bytes);
+    auto const byte1 = _mm256_cvtepu8_epi16 (_mm_loadu_si128 (reinterpret_cast<__m128i const*> (in + 1)));
+    auto const byte2 = _mm256_cvtepu8_epi16 (_mm_loadu_si128 (reinterpret_cast<__m128i const*> (in + 2)));
+    auto const payload = _mm256_set1_epi16 (details::utf8_mask);
+    // 110xxxxx 10yyyyyy -> 00000xxx xxyyyyyy
+    auto const two = _mm256_or_si256 (_mm256_slli_epi16 (_mm256_and_si256 (byte0, _mm256_set1_epi16 (0x1F)), 6),
+                                      _mm256_and_si256 (byte1, payload));
+    // 1110xxxx 10yyyyyy 10zzzzzz -> xxxxyyyy yyzzzzzz
+    auto const three = _mm256_or_si256 (
+        _mm256_or_si256 (_mm256_slli_epi16 (_mm256_and_si256 (byte0, _mm256_set1_epi16 (0x0F)), 12),
+                         _mm256_slli_epi16 (_mm256_and_si256 (byte1, payload), 6)),
+        _mm256_and_si256 (byte2, payload));
+    auto value = _mm256_blendv_epi8 (byte0, two, _mm256_cmpgt_epi16 (byte0, _mm256_set1_epi16 (0x7F)));
+    value = _mm256_blendv_epi8 (value, three, _mm256_cmpgt_epi16 (byte0, _mm256_set1_epi16 (0xDF)));
+
+#if ICUBABY_HAVE_AVX512VBMI2
+    _mm256_mask_compressstoreu_epi16 (out, static_cast<__mmask16> (starts), value);
+    out += popcount8_table[starts & 0xFFU] + popcount8_table[starts >> 8U];
+#else
+    auto const low_mask = starts & 0xFFU;
+    auto const high_mask = starts >> 8U;
+    auto const shuffle = [] (unsigned const mask) {
+      return _mm_loadu_si128 (reinterpret_cast<__m128i const*> (compress_epi16_table[mask].data ()));
+    };
+    _mm_storeu_si128 (reinterpret_cast<__m128i*> (out),
+                      _mm_shuffle_epi8 (_mm256_castsi256_si128 (value), shuffle (low_mask)));
+    out += popcount8_table[low_mask];
+    _mm_storeu_si128 (reinterpret_cast<__m128i*> (out),
+                      _mm_shuffle_epi8 (_mm256_extracti128_si256 (value, 1), shuffle (high_mask)));
+    out += popcount8_table[high_mask];
+#endif  // ICUBABY_HAVE_AVX512VBMI2
+    in += length;
+  }
+  return {static_cast<std::size_t> (in - first), static_cast<std::size_t> (out - out_first), false};
+}
+#endif  // ICUBABY_HAVE_AVX2
+
+#if ICUBABY_HAVE_SSSE3
+/// \brief Builds a table of pshufb controls which pack four 32-bit lanes, each holding a UTF-8 sequence of between one
+///   and three bytes, into contiguous bytes.
+///
+/// The table index is formed from two 4-bit masks: the low nibble has a bit set for each lane whose sequence is at
+/// least two bytes long, and the high nibble has a bit set for each lane whose sequence is three bytes long. Entry 16
+/// of each row holds the total number of bytes produced.
+///
+/// \returns  The table of shuffle controls and lengths.
+constexpr std::array<std::array<std::uint8_t, 17>, 256> make_pack_utf8_table () noexcept {
+  std::array<std::array<std::uint8_t, 17>, 256> result{};
+  for (auto key = std::size_t{0}; key < result.size (); ++key) {
+    auto pos = std::size_t{0};
+    for (auto lane = 0U; lane < 4U; ++lane) {
+      auto const two = (key & (1U << lane)) != 0U;
+      auto const three = two && (key & (1U << (lane + 4U))) != 0U;
+      auto const length = 1U + (two ? 1U : 0U) + (three ? 1U : 0U);
+      for (auto byte = 0U; byte < length; ++byte) {
+        result[key][pos++] = static_cast<std::uint8_t> (lane * 4U + byte);
+      }
+    }
+    result[key][16] = static_cast<std::uint8_t> (pos);
+    for (; pos < 16U; ++pos) {
+      result[key][pos] = 0x80;
+    }
+  }
+  return result;
+}
+/// The shuffle controls used to pack UTF-8 sequences. See make_pack_utf8_table().
+inline constexpr auto pack_utf8_table = make_pack_utf8_table ();
+
+/// \brief Computes the UTF-8 encoding of four BMP code points held in 32-bit lanes.
+///
+/// \param value  Four code points, none of which may be a surrogate.
+/// \param two  All-ones in each lane whose code point needs at least two bytes.
+/// \param three  All-ones in each lane whose code point needs three bytes.
+/// \returns  The one, two, or three bytes of each sequence, lead byte first, in the low bytes of each lane.
+inline __m128i utf8_encode_lanes (__m128i const value, __m128i const two, __m128i const three) noexcept {
+  auto const continuation = [] (__m128i const v) {
+    return _mm_or_si128 (_mm_and_si128 (v, _mm_set1_epi32 (0x3F)), _mm_set1_epi32 (0x80));
+  };
+  // 0xxxxxxx, 110xxxxx, or 1110xxxx
+  auto const lead = _mm_or_si128 (
+      _mm_andnot_si128 (two, value),
+      _mm_or_si128 (
+          _mm_and_si128 (_mm_andnot_si128 (three, two),
+                         _mm_or_si128 (_mm_srli_epi32 (value, 6), _mm_set1_epi32 (0xC0))),
+          _mm_and_si128 (three, _mm_or_si128 (_mm_srli_epi32 (value, 12), _mm_set1_epi32 (0xE0)))));
+  // The final byte of a two byte sequence or the middle byte of a three byte sequence.
+  auto const second =
+      continuation (_mm_or_si128 (_mm_andnot_si128 (three, value), _mm_and_si128 (three, _mm_srli_epi32 (value, 6))));
+  // The final byte of a three byte sequence.
+  auto const third = continuation (value);
+  return _mm_or_si128 (lead, _mm_or_si128 (_mm_slli_epi32 (second, 8), _mm_slli_epi32 (third, 16)));
+}
+#if ICUBABY_HAVE_AVX512VBMI2
+/// \brief Computes the UTF-8 encoding of eight BMP code points held in 32-bit lanes.
+///
+/// \param value  Eight code points, none of which may be a surrogate.
+/// \param two  All-ones in each lane whose code point needs at least two bytes.
+/// \param three  All-ones in each lane whose code point needs three bytes.
+/// \returns  The one, two, or three bytes of each sequence, lead byte first, in the low bytes of each lane.
+inline __m256i utf8_encode_lanes (__m256i const value, __m256i const two, __m256i const three) noexcept {
+  auto const continuation = [] (__m256i const v) {
+    return _mm256_or_si256 (_mm256_and_si256 (v, _mm256_set1_epi32 (0x3F)), _mm256_set1_epi32 (0x80));
+  };
+  auto const lead = _mm256_or_si256 (
+      _mm256_andnot_si256 (two, value),
+      _mm256_or_si256 (
+          _mm256_and_si256 (_mm256_andnot_si256 (three, two),
+                            _mm256_or_si256 (_mm256_srli_epi32 (value, 6), _mm256_set1_epi32 (0xC0))),
+          _mm256_and_si256 (three, _mm256_or_si256 (_mm256_srli_epi32 (value, 12), _mm256_set1_epi32 (0xE0)))));
+  auto const second = continuation (
+      _mm256_or_si256 (_mm256_andnot_si256 (three, value), _mm256_and_si256 (three, _mm256_srli_epi32 (value, 6))));
+  auto const third = continuation (value);
+  return _mm256_or_si256 (lead, _mm256_or_si256 (_mm256_slli_epi32 (second, 8), _mm256_slli_epi32 (third, 16)));
+}
+#endif  // ICUBABY_HAVE_AVX512VBMI2
+
+/// \brief Converts UTF-16 to UTF-8 eight code units at a time using SSSE3 (or AVX-512 VBMI2) instructions.
+///
+/// The UTF-8 encoding of each code unit is computed in a 32-bit lane assuming that it is in the Basic Multilingual
+/// Plane and is therefore encoded as one, two, or three bytes. The lanes are then packed together, using a pshufb
+/// table or a compress store if AVX-512 VBMI2/VL is available. The kernel stops at the first block which contains a
+/// surrogate, or when fewer than 8 input code units or 32 output bytes remain. The caller is expected to handle
+/// surrogate pairs (and unpaired surrogates) one code unit at a time.
+///
+/// \param first  The start of the range of UTF-16 code units.
+/// \param last  The end of the range of UTF-16 code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced.
+inline transcode_result utf16_to_utf8_ssse3 (char16_t const* const first, char16_t const* const last,
+                                             char8* const out_first, char8* const out_last) noexcept {
+  auto const* in = first;
+  auto* out = out_first;
+  while (last - in >= 8 && out_last - out >= 32) {
+    auto const units = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (in));
+    if (_mm_movemask_epi8 (_mm_cmpeq_epi16 (_mm_and_si128 (units, _mm_set1_epi16 (static_cast<short> (0xFF80))),
+                                            _mm_setzero_si128 ())) == 0xFFFF) {
+      // The block is entirely ASCII.
+      _mm_storel_epi64 (reinterpret_cast<__m128i*> (out), _mm_packus_epi16 (units, units));
+      in += 8;
+      out += 8;
+      continue;
+    }
+    // Surrogates are handled by the caller.
+    if (_mm_movemask_epi8 (_mm_cmpeq_epi16 (_mm_and_si128 (units, _mm_set1_epi16 (static_cast<short> (0xF800))),
+                                            _mm_set1_epi16 (static_cast<short> (0xD800)))) != 0) {
+      break;
+    }
+
+#if ICUBABY_HAVE_AVX512VBMI2
+    auto const value = _mm256_cvtepu16_epi32 (units);
+    auto const two = _mm256_cmpgt_epi32 (value, _mm256_set1_epi32 (0x7F));
+    auto const three = _mm256_cmpgt_epi32 (value, _mm256_set1_epi32 (0x7FF));
+    auto const bytes = utf8_encode_lanes (value, two, three);
+    // Select byte 0 of every lane, byte 1 of lanes needing two or more bytes, and byte 2 of those needing three.
+    auto const keep = _mm256_or_si256 (
+        _mm256_set1_epi32 (0xFF),
+        _mm256_or_si256 (_mm256_and_si256 (two, _mm256_set1_epi32 (0xFF00)),
+                         _mm256_and_si256 (three, _mm256_set1_epi32 (0xFF0000))));
+    auto const mask = static_cast<std::uint32_t> (_mm256_movemask_epi8 (keep));
+    _mm256_mask_compressstoreu_epi8 (out, static_cast<__mmask32> (mask), bytes);
+    out += popcount8_table[mask & 0xFFU] + popcount8_table[(mask >> 8U) & 0xFFU] +
+           popcount8_table[(mask >> 16U) & 0xFFU] + popcount8_table[mask >> 24U];
+#else
+    auto const zero = _mm_setzero_si128 ();
+    for (auto const value : {_mm_unpacklo_epi16 (units, zero), _mm_unpackhi_epi16 (units, zero)}) {
+      auto const two = _mm_cmpgt_epi32 (value, _mm_set1_epi32 (0x7F));
+      auto const three = _mm_cmpgt_epi32 (value, _mm_set1_epi32 (0x7FF));
+      auto const bytes = utf8_encode_lanes (value, two, three);
+      auto const key = static_cast<unsigned> (_mm_movemask_ps (_mm_castsi128_ps (two))) |
+                       (static_cast<unsigned> (_mm_movemask_ps (_mm_castsi128_ps (three))) << 4U);
+      auto const& entry = pack_utf8_table[key];
+      _mm_storeu_si128 (reinterpret_cast<__m128i*> (out),
+                        _mm_shuffle_epi8 (bytes, _mm_loadu_si128 (reinterpret_cast<__m128i const*> (entry.data ()))));
+      out += entry[16];
+    }
+#endif  // ICUBABY_HAVE_AVX512VBMI2
+    in += 8;
+  }
+  return {static_cast<std::size_t> (in - first), static_cast<std::size_t> (out - out_first), false};
+}
+#endif  // ICUBABY_HAVE_SSSE3
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+
+// The bulk kernels
+// ~~~~~~~~~~~~~~~~
+// These are the entry points used by transcode() and validator<>. Each converts (or checks) a prefix of the input
+// using the fastest code available and stops at a code point boundary, leaving the remainder to the caller's state
+// machine. If ICUBABY_DISPATCH is 1, they forward to the implementation chosen at run time by icubaby-dispatch.
+
+/// \brief Converts a prefix of a range of UTF-8 code units to UTF-32.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced.
+inline transcode_result bulk_utf8_to_utf32 (char8 const* const first, char8 const* const last,
+                                            char32_t* const out_first, char32_t* const out_last) noexcept {
+#if ICUBABY_DISPATCH
+  auto const res = ::icubaby::dispatch::utf8_to_utf32 (first, last, out_first, out_last);
+  return {res.consumed, res.produced, false};
+#else
+  auto const count = ascii_widen (first, first + std::min (last - first, out_last - out_first), out_first);
+  return {count, count, false};
+#endif  // ICUBABY_DISPATCH
+}
+
+/// \brief Converts a prefix of a range of UTF-8 code units to UTF-16.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced.
+inline transcode_result bulk_utf8_to_utf16 (char8 const* const first, char8 const* const last,
+                                            char16_t* const out_first, char16_t* const out_last) noexcept {
+#if ICUBABY_DISPATCH
+  auto const res = ::icubaby::dispatch::utf8_to_utf16 (first, last, out_first, out_last);
+  return {res.consumed, res.produced, false};
+#else
+  auto in = first;
+  auto out = out_first;
+#if ICUBABY_HAVE_AVX2
+  auto const vector_res = utf8_to_utf16_avx2 (in, last, out, out_last);
+  in += vector_res.consumed;
+  out += vector_res.produced;
+#endif  // ICUBABY_HAVE_AVX2
+  auto const count = ascii_widen (in, in + std::min (last - in, out_last - out), out);
+  return {static_cast<std::size_t> (in - first) + count, static_cast<std::size_t> (out - out_first) + count, false};
+#endif  // ICUBABY_DISPATCH
+}
+
+/// True if bulk_utf16_to_utf8() can convert more than zero code units.
+inline constexpr bool have_bulk_utf16_to_utf8 = ICUBABY_DISPATCH || ICUBABY_HAVE_SSSE3;
+
+/// \brief Converts a prefix of a range of UTF-16 code units to UTF-8.
+///
+/// \param first  The start of the range of UTF-16 code units.
+/// \param last  The end of the range of UTF-16 code units.
+/// \param out_first  The start of the output range.
+/// \param out_last  The end of the output range.
+/// \returns  The number of code units consumed and produced.
+inline transcode_result bulk_utf16_to_utf8 ([[maybe_unused]] char16_t const* const first,
+                                            [[maybe_unused]] char16_t const* const last,
+                                            [[maybe_unused]] char8* const out_first,
+                                            [[maybe_unused]] char8* const out_last) noexcept {
+#if ICUBABY_DISPATCH
+  auto const res = ::icubaby::dispatch::utf16_to_utf8 (first, last, out_first, out_last);
+  return {res.consumed, res.produced, false};
+#elif ICUBABY_HAVE_SSSE3
+  return utf16_to_utf8_ssse3 (first, last, out_first, out_last);
+#else
+  return {};
+#endif  // ICUBABY_DISPATCH
+}
+
+/// \brief Checks a prefix of a range of UTF-8 code units.
+///
+/// \param first  The start of the range of UTF-8 code units.
+/// \param last  The end of the range of UTF-8 code units.
+/// \returns  nullptr if the input is ill-formed, otherwise the position of the first code unit that was not checked.
+///   This is always the start of a code point.
+inline char8 const* bulk_validate_utf8 (char8 const* const first, char8 const* const last) noexcept {
+#if ICUBABY_DISPATCH
+  return ::icubaby::dispatch::validate_utf8 (first, last);
+#elif ICUBABY_HAVE_AVX2
+  return validate_utf8_avx2 (first, last);
+#elif ICUBABY_HAVE_SSSE3
+  return validate_utf8_ssse3 (first, last);
+#else
+  return first + ascii_prefix_length (first, last);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+#endif  // ICUBABY_DISPATCH
+}
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+
+/// The sums needed to compute the length of a range of UTF-16 code units when converted to UTF-8 or UTF-32.
+struct utf16_counts {
+  /// The sum of the number of UTF-8 code units for each UTF-16 code unit converted independently: 1, 2, or 3. A
+  /// surrogate counts as 3.
+  std::size_t utf8 = 0;
+  /// The number of high surrogates which are immediately followed by a low surrogate.
+  std::size_t pairs = 0;
+};
+
+/// \brief Computes the sums needed to compute the length of a range of UTF-16 code units when converted to UTF-8
+///   or UTF-32.
+///
+/// A high surrogate followed by a low surrogate produces a single code point (four UTF-8 code units). Every other
+/// surrogate produces U+REPLACEMENT CHARACTER (three UTF-8 code units). The UTF-8 length of the input is therefore
+/// utf8 - 2 * pairs and its UTF-32 length is the number of code units less pairs.
+///
+/// \param first  The start of the range of UTF-16 code units.
+/// \param last  The end of the range of UTF-16 code units.
+/// \returns  The sum of the UTF-8 lengths of the code units and the number of surrogate pairs.
+inline utf16_counts count_utf16 (char16_t const* const first, char16_t const* const last) noexcept {
+  utf16_counts result;
+  auto const* in = first;
+#if ICUBABY_HAVE_SSE2
+  // Each iteration adds at most 1 to the 16-bit lanes of the accumulators.
+  constexpr auto max_iterations = 0x7FFF;
+  auto const zero = _mm_setzero_si128 ();
+  auto const high_bits = _mm_set1_epi16 (static_cast<short> (0xD800));
+  auto const low_bits = _mm_set1_epi16 (static_cast<short> (0xDC00));
+  auto const sum = [] (__m128i const v) {
+    auto const sums = _mm_madd_epi16 (v, _mm_set1_epi16 (1));  // Four 32-bit sums.
+    auto const halves = _mm_add_epi32 (sums, _mm_srli_si128 (sums, 8));
+    return static_cast<std::size_t> (_mm_cvtsi128_si32 (_mm_add_epi32 (halves, _mm_srli_si128 (halves, 4))));
+  };
+  auto below = std::size_t{0};  // The number of thresholds (0x80 and 0x800) that code units fall below.
+  auto high = _mm_setzero_si128 ();  // The high surrogates in the previous block.
+  while (last - in >= 8) {
+    auto below_acc = _mm_setzero_si128 ();
+    auto pairs_acc = _mm_setzero_si128 ();
+    for (auto iteration = 0; iteration < max_iterations && last - in >= 8; ++iteration, in += 8) {
+      auto const units = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (in));
+      auto const below_80 =
+          _mm_cmpeq_epi16 (_mm_and_si128 (units, _mm_set1_epi16 (static_cast<short> (0xFF80))), zero);
+      auto const below_800 =
+          _mm_cmpeq_epi16 (_mm_and_si128 (units, _mm_set1_epi16 (static_cast<short> (0xF800))), zero);
+      below_acc = _mm_sub_epi16 (_mm_sub_epi16 (below_acc, below_80), below_800);
+
+      auto const surrogate_bits = _mm_and_si128 (units, _mm_set1_epi16 (static_cast<short> (0xFC00)));
+      auto const this_high = _mm_cmpeq_epi16 (surrogate_bits, high_bits);
+      // Shift the high surrogate mask along by one code unit, bringing in the final lane of the previous block.
+      auto const prev_high = _mm_or_si128 (_mm_slli_si128 (this_high, 2), _mm_srli_si128 (high, 14));
+      pairs_acc = _mm_sub_epi16 (pairs_acc, _mm_and_si128 (prev_high, _mm_cmpeq_epi16 (surrogate_bits, low_bits)));
+      high = this_high;
+    }
+    below += sum (below_acc);
+    result.pairs += sum (pairs_acc);
+  }
+  // Every code unit contributes 3 less 1 for each of the thresholds that it is below.
+  result.utf8 = static_cast<std::size_t> (in - first) * 3U - below;
+#endif  // ICUBABY_HAVE_SSE2
+  for (; in != last; ++in) {
+    auto const cu = static_cast<std::uint_least16_t> (*in);
+    result.utf8 += 1U + static_cast<std::size_t> (cu >= 0x80U) + static_cast<std::size_t> (cu >= 0x800U);
+    result.pairs += static_cast<std::size_t> (is_low_surrogate (cu) && in != first && is_high_surrogate (*(in - 1)));
+  }
+  return result;
+}
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+
+/// An output iterator which counts the code units that are written to it.
+class count_iterator {
+public:
+  /// Defines this class as fulfilling the requirements of an output iterator.
+  using iterator_category = std::output_iterator_tag;
+  /// The class is an output iterator and as such does not yield values.
+  using value_type = void;
+  /// A type that can be used to identify distance between iterators.
+  using difference_type = std::ptrdiff_t;
+  /// Defines a pointer to the type iterated over (none in the case of this iterator).
+  using pointer = void;
+  /// Defines a reference to the type iterated over (none in the case of this iterator).
+  using reference = void;
+
+  /// \param count  The counter which is incremented for each code unit written.
+  constexpr explicit count_iterator (std::size_t* const count) noexcept : count_{count} {}
+
+  /// Counts a code unit.
+  /// \returns \*this
+  template <typename T> constexpr count_iterator& operator= (T const& /*value*/) noexcept {
+    ++*count_;
+    return *this;
+  }
+  /// \brief no-op
+  /// \returns \*this
+  constexpr count_iterator& operator* () noexcept { return *this; }
+  /// \brief no-op
+  /// \returns \*this
+  constexpr count_iterator& operator++ () noexcept { return *this; }
+  /// \brief no-op
+  /// \returns \*this
+  constexpr count_iterator operator++ (int) noexcept { return *this; }
+
+private:
+  std::size_t* count_;
+};
+
+}  // end namespace details
+
+/// Takes a sequence of UTF-32 code units and converts them to UTF-8.
+template <error_policy Policy> class transcoder<char32_t, char8, Policy> {
+public:
+  /// The type of the code units consumed by this transcoder.
+  using input_type = char32_t;
+  /// The type of the code units produced by this transcoder.
+  using output_type = char8;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
+
+  constexpr transcoder () noexcept = default;
+  /// Initializes a transcoder instance with an initial value for its "well formed" state. This can be useful if
+  /// converting a stream of data which may be using different encodings.
+  ///
+  /// \param well_formed The initial value for the transcoder's "well formed" state.
+  explicit constexpr transcoder (bool well_formed) noexcept : well_formed_{well_formed} {}
+
+  /// Accepts a code unit in the UTF-32 source encoding. As UTF-8 output code units are generated, they are written to
+  /// the output iterator \p dest.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
+  /// \param code_unit  A code unit in the source encoding.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
+  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept (Policy != error_policy::exception) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return dest;
+    }
+    if (is_surrogate (code_unit) || code_unit > max_code_point) {
+      well_formed_ = false;
+      if (!details::replace_ill_formed<Policy> ()) {
+        return dest;
+      }
+      code_unit = replacement_char;
+    }
+    return details::write_utf8 (static_cast<std::uint_least32_t> (code_unit), dest);
+  }
+
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of UTF-32 code units in a single call. See \ref transcoder-transcode "transcode()".
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    return details::transcode_block (*this, input.data (), input.data () + input.size (), output.data (),
+                                     output.data () + output.size ());
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
+  /// Call once the entire input sequence has been fed to operator(). This
   /// function ensures that the sequence did not end with a partial code point.
   ///
   /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
@@ -785,6 +2566,9 @@ public:
 
   /// \returns True if the input represented well formed UTF-32.
   [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept { well_formed_ = well_formed; }
   /// \returns True if a partial code-point has been passed to operator() and
   ///   false otherwise.
   // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
@@ -793,111 +2577,176 @@ public:
 private:
   /// True if the input consumed is well formed, false otherwise.
   bool well_formed_ = true;
+};
 
-  // The following table shows how each range of code points is converted
-  // to a series of UTF-8 bytes.
-  //
-  // | First CP | Last CP  | Byte 1   | Byte 2   | Byte 3   | Byte 4   |
-  // | -------- | -------- | -------- | -------- | -------- | -------- |
-  // | U+0000   | U+007F   | 0xxxxxxx |          |          |          |
-  // | U+0080   | U+07FF   | 110xxxxx | 10xxxxxx |          |          |
-  // | U+0800   | U+FFFF   | 1110xxxx | 10xxxxxx | 10xxxxxx |          |
-  // | U+010000 | U+10FFFF | 11110xxx | 10xxxxxx | 10xxxxxx | 10xxxxxx |
-
-  /// The a mask to indicate the first byte of a two byte sequence.
-  static constexpr auto byte_1_of_2 = std::uint_least8_t{0b1100'0000};
-  /// The a mask to indicate the first byte of a three byte sequence.
-  static constexpr auto byte_1_of_3 = std::uint_least8_t{0b1110'0000};
-  /// The a mask to indicate the first byte of a four byte sequence.
-  static constexpr auto byte_1_of_4 = std::uint_least8_t{0b1111'0000};
-  /// The a mask to indicate a continuation byte (that is byte two of a two byte sequence, bytes two and three of a
-  /// three byte sequence, and so on.
-  static constexpr auto continuation = std::uint_least8_t{0b1000'0000};
-
-  /// Writes a series of "continuation" bytes to the output.
-  ///
-  /// Continuation bytes are all but the first byte of a two, three, or four byte encoding and each follows the same
-  /// format of having the two most significant bits set to 0b10 and six bits of the input code unit filling the rest of
-  /// the byte.
-  ///
-  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param number  The number of continuation bytes to be written.
-  /// \param code_unit  The code unit to be written.
-  /// \param dest  An output iterator to which the output sequence is written.
-  /// \returns  Iterator one past the last element assigned.
-  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  static constexpr OutputIterator write_continuation (std::uint_least8_t const number, input_type const code_unit,
-                                                      OutputIterator dest) {
-    if (number == 0U) {
-      return dest;
-    }
-    *(dest++) = static_cast<output_type> (((code_unit >> (details::utf8_shift * (number - 1U))) & details::utf8_mask) |
-                                          continuation);
-    return transcoder::write_continuation (number - 1U, code_unit, dest);
-  }
+/// Takes a sequence of UTF-8 code units and converts them to UTF-32.
+template <error_policy Policy> class transcoder<char8, char32_t, Policy> {
+public:
+  /// The type of the code units consumed by this transcoder.
+  using input_type = char8;
+  /// The type of the code units produced by this transcoder.
+  using output_type = char32_t;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
 
-  /// Writes a two CU value to the output.
-  ///
-  /// Code points in the range [U+80, U+800) are represented as two UTF-8 code units.
+  constexpr transcoder () noexcept : transcoder (true) {}
+  /// Initializes a transcoder instance with an initial value for its "well formed" state. This can be useful if
+  /// converting a stream of data which may be using different encodings.
   ///
-  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param code_unit  The code unit to be written.
-  /// \param dest  An output iterator to which the output sequence is written.
-  /// \returns  Iterator one past the last element assigned.
-  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  static OutputIterator write2 (input_type code_unit, OutputIterator dest) {
-    assert (code_unit >= 0x80U && code_unit <= 0x7FFU && "Code point is out-of-range for 2 byte UTF-8");
-    *(dest++) = static_cast<output_type> ((code_unit >> details::utf8_shift) | byte_1_of_2);
-    return transcoder::write_continuation (std::uint_least8_t{1}, code_unit, dest);
-  }
-  /// Writes a three CU value to the output.
-  ///
-  /// Code points in the range [U+800, U+10000) are represented as three UTF-8 code units.
+  /// \param well_formed The initial value for the transcoder's "well formed" state.
+  explicit constexpr transcoder(bool well_formed) noexcept
+      : code_point_{0}, well_formed_{static_cast<std::uint_least32_t>(well_formed)}, state_{accept} {}
+
+  /// Accepts a code unit in the UTF-8 source encoding. As UTF-32 output code units are generated, they are written to
+  /// the output iterator \p dest.
   ///
-  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param code_unit  The code unit to be written.
-  /// \param dest  An output iterator to which the output sequence is written.
+  /// \tparam OutputIterator  An output iterator type to which values of
+  ///   output_type can be written.
+  /// \param code_unit  A UTF-8 code unit,
+  /// \param dest  Iterator to which the output should be written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  static OutputIterator write3 (input_type code_unit, OutputIterator dest) {
-    assert (code_unit >= 0x800U && code_unit <= 0xFFFFU && "Code point is out-of-range for 3 byte UTF-8");
-    *(dest++) = static_cast<output_type> ((code_unit >> (details::utf8_shift * 2U)) | byte_1_of_3);
-    return transcoder::write_continuation (std::uint_least8_t{2}, code_unit, dest);
+  OutputIterator operator() (input_type code_unit, OutputIterator dest) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return dest;
+    }
+    // Prior to C++20, char8 might be signed.
+    static_assert (sizeof (input_type) <= sizeof (std::uint_least8_t));
+    auto ucu = static_cast<std::uint_least8_t> (code_unit);
+    // Clamp ucu in the event that it has more than 8 bits.
+    if constexpr (CHAR_BIT > 8 || sizeof (std::uint_least8_t) > 1) {
+      ucu = std::max (ucu, std::uint_least8_t{0xFF});
+    }
+    static_assert (details::utf8d.size () > 255);
+    assert (ucu < details::utf8d.size ());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    auto const type = details::utf8d[ucu];
+    code_point_ = (state_ != accept) ? static_cast<std::uint_least32_t> (ucu & details::utf8_mask) |
+                                       static_cast<std::uint_least32_t> (code_point_ << details::utf8_shift)
+                                     : (0xFFU >> type) & ucu;
+    auto const idx = 256U + state_ + type;
+    assert (idx < details::utf8d.size ());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    state_ = details::utf8d[idx];
+    switch (state_) {
+    case accept: *(dest++) = code_point_; break;
+    case reject:
+      well_formed_ = false;
+      state_ = accept;
+      if (details::replace_ill_formed<Policy> ()) {
+        *(dest++) = replacement_char;
+      }
+      break;
+    default: break;
+    }
+    return dest;
   }
-  /// Writes a four CU value to the output.
+
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of UTF-8 code units in a single call. See \ref transcoder-transcode "transcode()".
   ///
-  /// Code points in the range [U+10000, U+10FFFF] are represented as four UTF-8 code units.
+  /// Runs of ASCII code units are widened directly to the output: only the remaining code units are passed through
+  /// the decoder's state machine.
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return {input.size (), 0, this->partial ()};
+    }
+    auto const is_ascii = [] (input_type const cu) { return static_cast<std::uint_least8_t> (cu) < 0x80; };
+    auto const input_span = input;  // Keep the original span to compute the number of code units consumed.
+    auto const output_span = output;
+    while (!input.empty ()) {
+      if (state_ == accept) {
+        auto const vector_res = details::bulk_utf8_to_utf32 (input.data (), input.data () + input.size (),
+                                                             output.data (), output.data () + output.size ());
+        input = input.subspan (vector_res.consumed);
+        output = output.subspan (vector_res.produced);
+        if (input.empty ()) {
+          break;
+        }
+      }
+      // Pass the code units up to the next ASCII character through the state machine.
+      auto const run =
+          static_cast<std::size_t> (std::find_if (input.begin () + 1, input.end (), is_ascii) - input.begin ());
+      auto const res = details::transcode_block (*this, input.data (), input.data () + run, output.data (),
+                                                 output.data () + output.size ());
+      input = input.subspan (res.consumed);
+      output = output.subspan (res.produced);
+      if (res.consumed < run || details::stopped<Policy> (well_formed_)) {
+        break;  // The output is full or ill-formed input has stopped conversion.
+      }
+    }
+    return {input_span.size () - input.size (), output_span.size () - output.size (), this->partial ()};
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
+  /// Call once the entire input sequence has been fed to operator(). This function ensures that the sequence did not
+  /// end with a partial code point.
   ///
   /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param code_unit  The code unit to be written.
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  static OutputIterator write4 (input_type code_unit, OutputIterator dest) {
-    assert (code_unit >= 0x10000U && code_unit <= 0x10FFFFU && "Code point is out-of-range for 4 byte UTF-8");
-    *(dest++) = static_cast<output_type> ((code_unit >> (details::utf8_shift * 3U)) | byte_1_of_4);
-    return transcoder::write_continuation (std::uint_least8_t{3}, code_unit, dest);
+  constexpr OutputIterator end_cp (OutputIterator dest) {
+    if (state_ != accept) {
+      state_ = reject;
+      well_formed_ = false;
+      if (details::replace_ill_formed<Policy> ()) {
+        *(dest++) = replacement_char;
+      }
+    }
+    return dest;
   }
-  /// Writes U+FFFD REPLACEMENT CHAR to the output and records the input as not well formed.
+
+  /// Call once the entire input sequence has been fed to operator(). This function ensures that the sequence did not
+  /// end with a partial code point.
   ///
-  /// \param dest  An output iterator to which the output sequence is written.
   /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
+  /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  OutputIterator not_well_formed (OutputIterator dest) {
-    well_formed_ = false;
-    static_assert (!is_surrogate (replacement_char));
-    return (*this) (replacement_char, dest);
+  constexpr iterator<transcoder, OutputIterator> end_cp (iterator<transcoder, OutputIterator> dest) {
+    auto coder = dest.transcoder ();
+    assert (coder == this);
+    return {coder, coder->end_cp (dest.base ())};
+  }
+
+  /// \returns True if the input represented well formed UTF-8.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept {
+    well_formed_ = static_cast<std::uint_least32_t> (well_formed);
   }
+  /// \returns True if a partial code-point has been passed to operator() and false otherwise.
+  [[nodiscard]] constexpr bool partial () const noexcept { return state_ != accept; }
+
+private:
+  /// The code point value being assembled from input code units.
+  std::uint_least32_t code_point_ : code_point_bits;
+  /// True if the input consumed is well formed, false otherwise.
+  std::uint_least32_t well_formed_ : 1;
+  /// Pad bits intended to put the next value to a byte boundary.
+  std::uint_least32_t : 2;
+  enum : std::uint_least8_t { accept = details::utf8d_accept, reject = details::utf8d_reject };
+  /// The state of the converter.
+  std::uint_least32_t state_ : 8;
 };
 
-/// Takes a sequence of UTF-8 code units and converts them to UTF-32.
-template <> class transcoder<char8, char32_t> {
+/// Takes a sequence of UTF-8 code units and converts them to UTF-16.
+template <error_policy Policy> class transcoder<char8, char16_t, Policy> {
 public:
   /// The type of the code units consumed by this transcoder.
   using input_type = char8;
   /// The type of the code units produced by this transcoder.
-  using output_type = char32_t;
+  using output_type = char16_t;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
 
   constexpr transcoder () noexcept : transcoder (true) {}
   /// Initializes a transcoder instance with an initial value for its "well formed" state. This can be useful if
@@ -907,7 +2756,7 @@ public:
   explicit constexpr transcoder(bool well_formed) noexcept
       : code_point_{0}, well_formed_{static_cast<std::uint_least32_t>(well_formed)}, state_{accept} {}
 
-  /// Accepts a code unit in the UTF-8 source encoding. As UTF-32 output code units are generated, they are written to
+  /// Accepts a code unit in the UTF-8 source encoding. As UTF-16 output code units are generated, they are written to
   /// the output iterator \p dest.
   ///
   /// \tparam OutputIterator  An output iterator type to which values of
@@ -917,6 +2766,9 @@ public:
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
   OutputIterator operator() (input_type code_unit, OutputIterator dest) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return dest;
+    }
     // Prior to C++20, char8 might be signed.
     static_assert (sizeof (input_type) <= sizeof (std::uint_least8_t));
     auto ucu = static_cast<std::uint_least8_t> (code_unit);
@@ -924,29 +2776,77 @@ public:
     if constexpr (CHAR_BIT > 8 || sizeof (std::uint_least8_t) > 1) {
       ucu = std::max (ucu, std::uint_least8_t{0xFF});
     }
-    static_assert (utf8d_.size () > 255);
-    assert (ucu < utf8d_.size ());
+    static_assert (details::utf8d.size () > 255);
+    assert (ucu < details::utf8d.size ());
     // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-    auto const type = utf8d_[ucu];
+    auto const type = details::utf8d[ucu];
     code_point_ = (state_ != accept) ? static_cast<std::uint_least32_t> (ucu & details::utf8_mask) |
                                        static_cast<std::uint_least32_t> (code_point_ << details::utf8_shift)
                                      : (0xFFU >> type) & ucu;
     auto const idx = 256U + state_ + type;
-    assert (idx < utf8d_.size ());
+    assert (idx < details::utf8d.size ());
     // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-    state_ = utf8d_[idx];
+    state_ = details::utf8d[idx];
     switch (state_) {
-    case accept: *(dest++) = code_point_; break;
+    case accept: dest = details::write_utf16 (code_point_, dest); break;
     case reject:
       well_formed_ = false;
       state_ = accept;
-      *(dest++) = replacement_char;
+      if (details::replace_ill_formed<Policy> ()) {
+        *(dest++) = static_cast<output_type> (replacement_char);
+      }
       break;
     default: break;
     }
     return dest;
   }
 
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of UTF-8 code units in a single call. See \ref transcoder-transcode "transcode()".
+  ///
+  /// Runs of ASCII code units are widened directly to the output. When AVX2 instructions are available, blocks
+  /// containing only one, two, and three byte sequences are converted using a vectorized kernel. The remaining code
+  /// units (four byte sequences and ill-formed input) are passed through the decoder's state machine.
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return {input.size (), 0, this->partial ()};
+    }
+    auto const is_ascii = [] (input_type const cu) { return static_cast<std::uint_least8_t> (cu) < 0x80; };
+    auto const input_span = input;  // Keep the original span to compute the number of code units consumed.
+    auto const output_span = output;
+    while (!input.empty ()) {
+      if (state_ == accept) {
+        auto const vector_res = details::bulk_utf8_to_utf16 (input.data (), input.data () + input.size (),
+                                                             output.data (), output.data () + output.size ());
+        input = input.subspan (vector_res.consumed);
+        output = output.subspan (vector_res.produced);
+        if (input.empty ()) {
+          break;
+        }
+      }
+      // Pass the code units up to the next ASCII character through the state machine. The run is kept short so that
+      // we return to the vectorized code promptly.
+      auto const run = static_cast<std::size_t> (
+          std::find_if (input.begin () + 1, input.begin () + std::min (input.size (), scalar_run), is_ascii) -
+          input.begin ());
+      auto const res = details::transcode_block (*this, input.data (), input.data () + run, output.data (),
+                                                 output.data () + output.size ());
+      input = input.subspan (res.consumed);
+      output = output.subspan (res.produced);
+      if (res.consumed < run || details::stopped<Policy> (well_formed_)) {
+        break;  // The output is full or ill-formed input has stopped conversion.
+      }
+    }
+    return {input_span.size () - input.size (), output_span.size () - output.size (), this->partial ()};
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
   /// Call once the entire input sequence has been fed to operator(). This function ensures that the sequence did not
   /// end with a partial code point.
   ///
@@ -957,8 +2857,10 @@ public:
   constexpr OutputIterator end_cp (OutputIterator dest) {
     if (state_ != accept) {
       state_ = reject;
-      *(dest++) = replacement_char;
       well_formed_ = false;
+      if (details::replace_ill_formed<Policy> ()) {
+        *(dest++) = static_cast<output_type> (replacement_char);
+      }
     }
     return dest;
   }
@@ -978,54 +2880,39 @@ public:
 
   /// \returns True if the input represented well formed UTF-8.
   [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept {
+    well_formed_ = static_cast<std::uint_least32_t> (well_formed);
+  }
   /// \returns True if a partial code-point has been passed to operator() and false otherwise.
   [[nodiscard]] constexpr bool partial () const noexcept { return state_ != accept; }
 
 private:
-  /// The utf8d_ table consists of two parts. The first part maps bytes to character classes, the
-  /// second part encodes a deterministic finite automaton using these character classes as
-  /// transitions.
-  /// \hideinitializer
-  static inline std::array<std::uint_least8_t, 364> const utf8d_ = {{
-      // clang-format off
-    // The first part of the table maps bytes to character classes that
-    // reduce the size of the transition table and create bitmasks.
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
-     7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
-     8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
-    10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
-
-    // The second part is a transition table that maps a combination
-    // of a state of the automaton and a character class to a state.
-     0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
-    12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
-    12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
-    12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
-    12,36,12,12,12,12,12,12,12,12,12,12,
-      // clang-format on
-  }};
   /// The code point value being assembled from input code units.
   std::uint_least32_t code_point_ : code_point_bits;
   /// True if the input consumed is well formed, false otherwise.
   std::uint_least32_t well_formed_ : 1;
   /// Pad bits intended to put the next value to a byte boundary.
   std::uint_least32_t : 2;
-  enum : std::uint_least8_t { accept = 0, reject = 12 };
+  enum : std::uint_least8_t { accept = details::utf8d_accept, reject = details::utf8d_reject };
   /// The state of the converter.
   std::uint_least32_t state_ : 8;
+
+  /// The maximum number of code units that transcode() passes to the state machine before trying the faster paths
+  /// again.
+  static constexpr auto scalar_run = std::size_t{16};
 };
 
 /// Takes a sequence of UTF-32 code units and converts them to UTF-16.
-template <> class transcoder<char32_t, char16_t> {
+template <error_policy Policy> class transcoder<char32_t, char16_t, Policy> {
 public:
   /// The type of the code units consumed by this transcoder.
   using input_type = char32_t;
   /// The type of the code units produced by this transcoder.
   using output_type = char16_t;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
 
   constexpr transcoder () noexcept = default;
   /// Initializes a transcoder instance with an initial value for its "well formed" state. This can be useful if
@@ -1042,26 +2929,33 @@ public:
   /// \param dest  Iterator to which the output should be written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept {
+  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept (Policy != error_policy::exception) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return dest;
+    }
     if (is_surrogate (code_unit) || code_unit > max_code_point) {
-      dest = (*this) (replacement_char, dest);
       well_formed_ = false;
-    } else if (code_unit <= 0xFFFF) {
-      *(dest++) = static_cast<output_type> (code_unit);
-    } else {
-      // Code points from beyond plane 0 are encoded as a two 16-bit code unit surrogate pair. The first code
-      // unit is the high surrogate and the second is the low surrogate.
-      // - 0x10000 is subtracted from the code point, leaving a 20-bit number (0x00000–0xFFFFF).
-      // - The high ten bits (0x0000–0x03FF) are added to 0xD800 to give the high surrogate (0xD800–0xDBFF).
-      // - The low ten bits (0x000–0x3FF) are added to 0xDC00 to give the low surrogate (0xDC00–0xDFFF).
-      *(dest++) = static_cast<output_type> (static_cast<std::uint_least32_t> (first_high_surrogate) -
-                                            (details::utf16_first_surrogate_pair >> details::utf16_shift) +
-                                            (code_unit >> details::utf16_shift));
-      *(dest++) = static_cast<output_type> (static_cast<std::uint_least32_t> (first_low_surrogate) +
-                                            (code_unit & details::utf16_mask));
+      if (!details::replace_ill_formed<Policy> ()) {
+        return dest;
+      }
+      code_unit = replacement_char;
     }
-    return dest;
+    return details::write_utf16 (static_cast<std::uint_least32_t> (code_unit), dest);
+  }
+
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of UTF-32 code units in a single call. See \ref transcoder-transcode "transcode()".
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    return details::transcode_block (*this, input.data (), input.data () + input.size (), output.data (),
+                                     output.data () + output.size ());
   }
+#endif  // ICUBABY_HAVE_SPAN
 
   /// Call once the entire input sequence has been fed to operator(). This function ensures that the sequence did not
   /// end with a partial code point.
@@ -1089,6 +2983,9 @@ public:
 
   /// \returns True if the input represented valid UTF-32.
   [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept { well_formed_ = well_formed; }
   /// \returns True if a partial code-point has been passed to operator() and
   ///   false otherwise.
   // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
@@ -1100,12 +2997,14 @@ private:
 };
 
 /// Takes a sequence of UTF-16 code units and converts them to UTF-32.
-template <> class transcoder<char16_t, char32_t> {
+template <error_policy Policy> class transcoder<char16_t, char32_t, Policy> {
 public:
   /// The type of the code units consumed by this transcoder.
   using input_type = char16_t;
   /// The type of the code units produced by this transcoder.
   using output_type = char32_t;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
 
   constexpr transcoder () noexcept : transcoder (true) {}
   /// Initializes a transcoder instance with an initial value for its "well formed" state. This can be useful if
@@ -1125,7 +3024,10 @@ public:
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept {
+  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept (Policy != error_policy::exception) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return dest;
+    }
     if (!has_high_) {
       if (is_high_surrogate (code_unit)) {
         // A high surrogate code unit indicates that this is the first of a
@@ -1138,6 +3040,9 @@ public:
       // A low-surrogate without a preceding high-surrogate.
       if (is_low_surrogate (code_unit)) {
         well_formed_ = false;
+        if (!details::replace_ill_formed<Policy> ()) {
+          return dest;
+        }
         code_unit = replacement_char;
       }
       *(dest++) = code_unit;
@@ -1156,8 +3061,10 @@ public:
     // There was a high-surrogate followed by something other than a low surrogate. A high-surrogate followed by a
     // second high-surrogate yields a single REPLACEMENT CHARACTER. A high-surrogate followed by something other than
     // a low-surrogate gives REPLACEMENT CHARACTER followed by the second input code point.
-    *(dest++) = replacement_char;
     well_formed_ = false;
+    if (details::replace_ill_formed<Policy> ()) {
+      *(dest++) = replacement_char;
+    }
     if (is_high_surrogate (code_unit)) {
       // There was a high surrogate followed by a second high-surrogate: remember the latter.
       high_ = adjusted_high (code_unit);
@@ -1165,12 +3072,28 @@ public:
       return dest;
     }
 
-    *(dest++) = code_unit;
     high_ = 0;
     has_high_ = false;
+    if (!details::stopped<Policy> (well_formed_)) {
+      *(dest++) = code_unit;
+    }
     return dest;
   }
 
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of UTF-16 code units in a single call. See \ref transcoder-transcode "transcode()".
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    return details::transcode_block (*this, input.data (), input.data () + input.size (), output.data (),
+                                     output.data () + output.size ());
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
   /// Call once the entire input sequence has been fed to operator(). This function ensures that the sequence did not
   /// end with a partial code point.
   ///
@@ -1178,10 +3101,12 @@ public:
   /// \returns  The output iterator.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator> OutputIterator end_cp (OutputIterator dest) {
     if (has_high_) {
-      *(dest++) = replacement_char;
       high_ = 0;
       has_high_ = false;
       well_formed_ = false;
+      if (details::replace_ill_formed<Policy> ()) {
+        *(dest++) = replacement_char;
+      }
     }
     return dest;
   }
@@ -1201,6 +3126,11 @@ public:
 
   /// \returns True if the input represented well formed UTF-16.
   [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept {
+    well_formed_ = static_cast<std::uint_least16_t> (well_formed);
+  }
   /// \returns True if a partial code-point has been passed to operator() and false otherwise.
   [[nodiscard]] constexpr bool partial () const noexcept { return has_high_; }
 
@@ -1228,118 +3158,650 @@ private:
   }
 };
 
-/// \brief An enumeration representing the encoding detected by transcoder<std::byte, X>.
-enum class encoding : std::uint_least8_t {
-  unknown,  ///< No encoding has yet been determined.
-  utf8,     ///< The detected encoding is UTF-8.
-  utf16be,  ///< The detected encoding is big-endian UTF-16.
-  utf16le,  ///< The detected encoding is little-endian UTF-16.
-  utf32be,  ///< The detected encoding is big-endian UTF-32.
-  utf32le,  ///< The detected encoding is little-endian UTF-32.
-};
-
-namespace details {
-
-/// An alias template for a two-dimensional std::array
-template <typename T, std::size_t Rows, std::size_t Columns> using array2d = std::array<std::array<T, Columns>, Rows>;
-
-/// \brief A two-dimensional array containing the bytes that make up the encoded value of U+FEFF BYTE ORDER MARK.
-///
-/// \note The indices of the outer array must agree with the [encoding_utf16](\ref transcoder-encoding_utf16),
-///       [encoding_utf32](\ref transcoder-encoding_utf32), [encoding_utf8](\ref transcoder-encoding_utf8),
-///       [big_endian](\ref transcoder-big_endian), and [little_endian](\ref transcoder-little_endian) constants from
-///       the transcoder<std::byte, ToEncoding> specialization. We use the encoding and endian fields together to
-///       produce the outer index into this array. UTF-8 encoding has no inherent endianness so is modelled as
-///       big-endian to enable it to occupy just the final entry in this array
-inline array2d<std::byte, 5, 4> const boms{{
-    {std::byte{0xFE}, std::byte{0xFF}},                                    // UTF-16 BE
-    {std::byte{0xFF}, std::byte{0xFE}},                                    // UTF-16 LE
-    {std::byte{0x00}, std::byte{0x00}, std::byte{0xFE}, std::byte{0xFF}},  // UTF-32 BE
-    {std::byte{0xFF}, std::byte{0xFE}, std::byte{0x00}, std::byte{0x00}},  // UTF-32 LE
-    {std::byte{0xEF}, std::byte{0xBB}, std::byte{0xBF}},                   // UTF-8
-}};
-
-}  // end namespace details
-
-/// \brief The "byte transcoder" takes a sequence of bytes, determines their encoding and converts
-///    to a specified encoding.
-///
-/// This transcoder is used when the input encoding is not known at compile-time. If present, a leading
-/// byte-order-mark is interpreted to select the source encoding; if not present, UTF-8 encoding is assumed.
-///
-/// The byte transcoder is implemented as a finite state machine. The following diagram shows the state transitions that
-/// occur as input bytes are received. Each vertex rectangle represents a state (the upper half has the state name
-/// and the lower briefly describes the meaning of that state). Each edge describes the condition for that transition to
-/// be made.
-///
-/// - An edge with description of the form *x=y* (where *y* is a hexadecimal constant) is taken if the input value *x*
-///   is equal to the constant *y*.
-/// - An edge with the description "otherwise" is taken if no other edges with the same origin are matched.
-/// - An edge without a description is unconditionally taken for the next byte
-///
-/// \dotfile byte_transcoder.dot
-template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding> class transcoder<std::byte, ToEncoding> {
+/// Takes a sequence of UTF-16 code units and converts them to UTF-8.
+template <error_policy Policy> class transcoder<char16_t, char8, Policy> {
 public:
-  /// The type of the values consumed by this transcoder.
-  using input_type = std::byte;
+  /// The type of the code units consumed by this transcoder.
+  using input_type = char16_t;
   /// The type of the code units produced by this transcoder.
-  using output_type = ToEncoding;
+  using output_type = char8;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
 
-  /// \brief Accepts a byte for decoding. Output is written to a supplied output iterator.
+  constexpr transcoder () noexcept : transcoder (true) {}
+  /// Initializes a transcoder instance with an initial value for its "well formed" state. This can be useful if
+  /// converting a stream of data which may be using different encodings.
   ///
-  /// As output code units are generated, they are written to the output iterator \p dest.
+  /// \param well_formed The initial value for the transcoder's "well formed" state.
+  explicit constexpr transcoder (bool well_formed) noexcept
+      : high_{0},
+        has_high_{static_cast<uint_least16_t> (false)},
+        well_formed_{static_cast<uint_least16_t> (well_formed)} {}
+
+  /// Accepts a code unit in the UTF-16 source encoding. As UTF-8 output code units are generated, they are written to
+  /// the output iterator \p dest.
   ///
   /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param value  A byte of input.
+  /// \param code_unit  A code unit in the source encoding.
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  OutputIterator operator() (input_type value, OutputIterator dest) noexcept {
-    switch (state_) {
-    case states::start: dest = this->start_state (value, dest); break;
-    case states::utf8_bom_byte2:
-      assert (this->get_byte_no () == 2 && "Expected this state to target byte #2");
-      buffer_[this->get_byte_no ()] = value;
-      // Start decoding as UTF-8. If we have a complete UTF-8 BOM drop it, otherwise output the code units seen so far.
-      dest = this->run8_start (value != this->bom_value (), dest);
-      break;
-
-    case states::utf16_be_bom_byte1:
-      assert (this->get_byte_no () == 1 && "Expected this state to target byte #1");
-      buffer_[this->get_byte_no ()] = value;
-      // We either have a complete UTF-16 BE BOM, in which case we start transcoding, or we default to UTF-8 emitting
-      // the bytes consumed so far.
-      dest = value == this->bom_value () ? this->run16_start (dest) : this->run8_start (true, dest);
-      break;
-
-    case states::utf32_or_16_le_bom_byte2:
-      assert (this->get_byte_no () == 2 && "Expected this state to target byte #2");
-      if (value != transcoder::bom_value (encoding_utf32 | little_endian, this->get_byte_no ())) {
-        // This isn't a UTF-32 LE BOM but the start of a UTF-16 run.
-        dest = this->run16_start (dest);
-        state_ = states::run_16le_byte1;
-        buffer_[0] = value;
-        break;
+  OutputIterator operator() (input_type code_unit, OutputIterator dest) noexcept (Policy != error_policy::exception) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return dest;
+    }
+    if (!has_high_) {
+      if (is_high_surrogate (code_unit)) {
+        // A high surrogate code unit indicates that this is the first of a
+        // high/low surrogate pair.
+        high_ = adjusted_high (code_unit);
+        has_high_ = true;
+        return dest;
       }
-      [[fallthrough]];
 
-    case states::utf8_bom_byte1:
-    case states::utf32_or_16_le_bom_byte1:
-    case states::utf32_or_16_be_bom_byte1:
-    case states::utf32_be_bom_byte2:
-      assert ((this->get_byte_no () == 1 || this->get_byte_no () == 2) && "This must be byte #1 or #2");
-      buffer_[this->get_byte_no ()] = value;
-      if (value == this->bom_value ()) {
-        state_ = this->next_byte ();
-      } else {
-        // Default input encoding. Emit buffer.
-        dest = this->run8_start (true, dest);
+      // A low-surrogate without a preceding high-surrogate.
+      if (is_low_surrogate (code_unit)) {
+        well_formed_ = false;
+        return details::replace_ill_formed<Policy> () ? details::write_utf8 (replacement_char, dest) : dest;
       }
-      break;
+      return details::write_utf8 (code_unit, dest);
+    }
 
-    case states::utf32_le_bom_byte3:
-    case states::utf32_be_bom_byte3:
-      assert (this->get_byte_no () == 3 && "Expected this to be byte #3");
+    // A high surrogate followed by a low-surrogate.
+    if (is_low_surrogate (code_unit)) {
+      auto const code_point = ((static_cast<std::uint_least32_t> (high_) << details::utf16_shift) |
+                               (static_cast<std::uint_least32_t> (code_unit) - first_low_surrogate)) +
+                              details::utf16_first_surrogate_pair;
+      high_ = 0;
+      has_high_ = false;
+      return details::write_utf8 (code_point, dest);
+    }
+    // There was a high-surrogate followed by something other than a low surrogate. A high-surrogate followed by a
+    // second high-surrogate yields a single REPLACEMENT CHARACTER. A high-surrogate followed by something other than
+    // a low-surrogate gives REPLACEMENT CHARACTER followed by the second input code point.
+    well_formed_ = false;
+    if (details::replace_ill_formed<Policy> ()) {
+      dest = details::write_utf8 (replacement_char, dest);
+    }
+    if (is_high_surrogate (code_unit)) {
+      // There was a high surrogate followed by a second high-surrogate: remember the latter.
+      high_ = adjusted_high (code_unit);
+      assert (has_high_);
+      return dest;
+    }
+
+    high_ = 0;
+    has_high_ = false;
+    return details::stopped<Policy> (well_formed_) ? dest : details::write_utf8 (code_unit, dest);
+  }
+
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of UTF-16 code units in a single call. See \ref transcoder-transcode "transcode()".
+  ///
+  /// When vector instructions are available, blocks of code units from the Basic Multilingual Plane are converted
+  /// using a vectorized kernel. Surrogate pairs and unpaired surrogates are handled one code unit at a time.
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    if constexpr (!details::have_bulk_utf16_to_utf8) {
+      return details::transcode_block (*this, input.data (), input.data () + input.size (), output.data (),
+                                       output.data () + output.size ());
+    } else {
+      if (details::stopped<Policy> (well_formed_)) {
+        return {input.size (), 0, this->partial ()};
+      }
+      auto const input_span = input;  // Keep the original span to compute the number of code units consumed.
+      auto const output_span = output;
+      while (!input.empty ()) {
+        if (!has_high_) {
+          auto const vector_res = details::bulk_utf16_to_utf8 (input.data (), input.data () + input.size (),
+                                                               output.data (), output.data () + output.size ());
+          input = input.subspan (vector_res.consumed);
+          output = output.subspan (vector_res.produced);
+          if (input.empty ()) {
+            break;
+          }
+        }
+        // Pass a short run of code units through operator(). This deals with surrogates and with the tail of the input
+        // or output which is too short for the vector kernel.
+        auto const run = std::min (input.size (), scalar_run);
+        auto const res = details::transcode_block (*this, input.data (), input.data () + run, output.data (),
+                                                   output.data () + output.size ());
+        input = input.subspan (res.consumed);
+        output = output.subspan (res.produced);
+        if (res.consumed < run || details::stopped<Policy> (well_formed_)) {
+          break;  // The output is full or ill-formed input has stopped conversion.
+        }
+      }
+      return {input_span.size () - input.size (), output_span.size () - output.size (), this->partial ()};
+    }
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
+  /// Call once the entire input sequence has been fed to operator(). This function ensures that the sequence did not
+  /// end with a partial code point.
+  ///
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  The output iterator.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator> OutputIterator end_cp (OutputIterator dest) {
+    if (has_high_) {
+      high_ = 0;
+      has_high_ = false;
+      well_formed_ = false;
+      if (details::replace_ill_formed<Policy> ()) {
+        dest = details::write_utf8 (replacement_char, dest);
+      }
+    }
+    return dest;
+  }
+
+  /// Call once the entire input sequence has been fed to operator(). This function ensures that the sequence did not
+  /// end with a partial code point.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
+  constexpr iterator<transcoder, OutputIterator> end_cp (iterator<transcoder, OutputIterator> dest) {
+    auto coder = dest.transcoder ();
+    assert (coder == this);
+    return {coder, coder->end_cp (dest.base ())};
+  }
+
+  /// \returns True if the input represented well formed UTF-16.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept {
+    well_formed_ = static_cast<std::uint_least16_t> (well_formed);
+  }
+  /// \returns True if a partial code-point has been passed to operator() and false otherwise.
+  [[nodiscard]] constexpr bool partial () const noexcept { return has_high_; }
+
+private:
+  /// The previous high surrogate that was passed to operator(). Valid if has_high_ is true.
+  uint_least16_t high_ : details::utf16_shift;
+  /// true if the previous code unit passed to operator() was a high surrogate, false otherwise.
+  uint_least16_t has_high_ : 1;
+  /// true if the code units passed to operator() represent well formed UTF-16 input, false otherwise.
+  uint_least16_t well_formed_ : 1;
+
+  /// \brief This function returns a high surrogate value that can be stored in the high_ field.
+  ///
+  /// The high surrogate value is stored after the first_high_surrogate value has been subtracted. This reduces the
+  /// number of bits that we need to remember.
+  ///
+  /// \param code_unit A UTF-16 code unit for which icubaby::is_high_surrogate() returns true.
+  /// \returns A high surrogate value that can be stored in the class's high_ field.
+  static std::uint_least16_t adjusted_high (std::uint_least16_t code_unit) noexcept {
+    assert (code_unit >= first_high_surrogate && "A high surrogate must be at least first_high_surrogate");
+    auto const high_cu = code_unit - first_high_surrogate;
+    assert (high_cu < std::numeric_limits<decltype (high_)>::max () && high_cu < (1U << details::utf16_shift) &&
+            "high_cu won't fit in the high_ field!");
+    return static_cast<uint_least16_t> (high_cu);
+  }
+
+  /// The maximum number of code units that transcode() passes to operator() before trying the vector kernel again.
+  static constexpr auto scalar_run = std::size_t{16};
+};
+
+/// \brief An enumeration representing the encoding detected by transcoder<std::byte, X>.
+enum class encoding : std::uint_least8_t {
+  unknown,  ///< No encoding has yet been determined.
+  utf8,     ///< The detected encoding is UTF-8.
+  utf16be,  ///< The detected encoding is big-endian UTF-16.
+  utf16le,  ///< The detected encoding is little-endian UTF-16.
+  utf32be,  ///< The detected encoding is big-endian UTF-32.
+  utf32le,  ///< The detected encoding is little-endian UTF-32.
+};
+
+namespace details {
+
+/// An alias template for a two-dimensional std::array
+template <typename T, std::size_t Rows, std::size_t Columns> using array2d = std::array<std::array<T, Columns>, Rows>;
+
+/// \brief A two-dimensional array containing the bytes that make up the encoded value of U+FEFF BYTE ORDER MARK.
+///
+/// \note The indices of the outer array must agree with the [encoding_utf16](\ref transcoder-encoding_utf16),
+///       [encoding_utf32](\ref transcoder-encoding_utf32), [encoding_utf8](\ref transcoder-encoding_utf8),
+///       [big_endian](\ref transcoder-big_endian), and [little_endian](\ref transcoder-little_endian) constants from
+///       the transcoder<std::byte, ToEncoding> specialization. We use the encoding and endian fields together to
+///       produce the outer index into this array. UTF-8 encoding has no inherent endianness so is modelled as
+///       big-endian to enable it to occupy just the final entry in this array
+inline array2d<std::byte, 5, 4> const boms{{
+    {std::byte{0xFE}, std::byte{0xFF}},                                    // UTF-16 BE
+    {std::byte{0xFF}, std::byte{0xFE}},                                    // UTF-16 LE
+    {std::byte{0x00}, std::byte{0x00}, std::byte{0xFE}, std::byte{0xFF}},  // UTF-32 BE
+    {std::byte{0xFF}, std::byte{0xFE}, std::byte{0x00}, std::byte{0x00}},  // UTF-32 LE
+    {std::byte{0xEF}, std::byte{0xBB}, std::byte{0xBF}},                   // UTF-8
+}};
+
+/// \brief Assembles native-endian code units from a sequence of bytes.
+///
+/// Where SSE2 is available (and the host is therefore little-endian), little-endian input is copied directly.
+/// Big-endian UTF-16 and UTF-32 is byte-swapped using pshufb (SSSE3) or vpshufb (AVX2), 16 or 32 bytes at a time, or
+/// using shifts and word shuffles when only SSE2 is available.
+///
+/// \tparam CodeUnit  The type of the code units to be assembled: char8, char16_t, or char32_t.
+/// \param first  The start of the input bytes. There must be count * sizeof (CodeUnit) bytes.
+/// \param count  The number of code units to be assembled.
+/// \param little_endian  True if the input bytes are little-endian and false if they are big-endian.
+/// \param out  The array to which the code units are written.
+template <typename CodeUnit>
+void gather_code_units (std::byte const* first, std::size_t count, bool const little_endian,
+                        CodeUnit* out) noexcept {
+  if constexpr (sizeof (CodeUnit) == 1) {
+    (void)little_endian;
+    std::memcpy (out, first, count);
+  } else {
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+#if ICUBABY_HAVE_SSE2
+    if (little_endian) {
+      std::memcpy (out, first, count * sizeof (CodeUnit));
+      return;
+    }
+#if ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_SSSE3
+    // A pshufb control which reverses the bytes of each 16- or 32-bit lane.
+    auto const swap = sizeof (CodeUnit) == 2
+                          ? _mm_setr_epi8 (1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+                          : _mm_setr_epi8 (3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+#endif  // ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_SSSE3
+    constexpr auto units_per_vector = 16 / sizeof (CodeUnit);
+#if ICUBABY_HAVE_AVX2
+    auto const swap256 = _mm256_broadcastsi128_si256 (swap);
+    for (; count >= 2 * units_per_vector; count -= 2 * units_per_vector) {
+      auto const bytes = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (first));
+      _mm256_storeu_si256 (reinterpret_cast<__m256i*> (out), _mm256_shuffle_epi8 (bytes, swap256));
+      first += 32;
+      out += 2 * units_per_vector;
+    }
+#endif  // ICUBABY_HAVE_AVX2
+    for (; count >= units_per_vector; count -= units_per_vector) {
+      auto const bytes = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (first));
+#if ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_SSSE3
+      auto const swapped = _mm_shuffle_epi8 (bytes, swap);
+#else
+      // Swap the bytes of each 16-bit lane and then, for UTF-32, the 16-bit halves of each 32-bit lane.
+      auto swapped = _mm_or_si128 (_mm_slli_epi16 (bytes, 8), _mm_srli_epi16 (bytes, 8));
+      if constexpr (sizeof (CodeUnit) == 4) {
+        constexpr auto swap_pairs = 0xB1;  // _MM_SHUFFLE (2, 3, 0, 1)
+        swapped = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (swapped, swap_pairs), swap_pairs);
+      }
+#endif  // ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_SSSE3
+      _mm_storeu_si128 (reinterpret_cast<__m128i*> (out), swapped);
+      first += 16;
+      out += units_per_vector;
+    }
+#endif  // ICUBABY_HAVE_SSE2
+    auto const assemble = [first, out, count] (auto const byte_index) {
+      for (auto index = std::size_t{0}; index < count; ++index) {
+        auto value = std::uint_least32_t{0};
+        auto const* const unit = first + index * sizeof (CodeUnit);
+        for (auto byte = std::size_t{0}; byte < sizeof (CodeUnit); ++byte) {
+          value = (value << 8U) | static_cast<std::uint_least32_t> (to_underlying (unit[byte_index (byte)]));
+        }
+        out[index] = static_cast<CodeUnit> (value);
+      }
+    };
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+    if (little_endian) {
+      assemble ([] (std::size_t const byte) { return sizeof (CodeUnit) - 1U - byte; });
+    } else {
+      assemble ([] (std::size_t const byte) { return byte; });
+    }
+  }
+}
+
+/// \brief Counts the zero bytes in a range, grouped by their offset modulo 4.
+///
+/// \param first  The start of the range of bytes.
+/// \param last  The end of the range of bytes.
+/// \returns  An array whose element i is the number of zero bytes whose offset from \p first modulo 4 is i.
+inline std::array<std::size_t, 4> count_zero_bytes (std::byte const* first, std::byte const* const last) noexcept {
+  std::array<std::size_t, 4> result{};
+  auto offset = std::size_t{0};
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+#if ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_SSE2
+  // Each iteration adds at most 1 to the 8-bit lanes of the accumulator, so it is emptied at least every 255
+  // iterations. The vector width is a multiple of 4 so lane i always holds the count for offset i modulo 4.
+  constexpr auto max_iterations = 255;
+#if ICUBABY_HAVE_AVX2
+  using vector = __m256i;
+#else
+  using vector = __m128i;
+#endif  // ICUBABY_HAVE_AVX2
+  constexpr auto width = static_cast<std::ptrdiff_t> (sizeof (vector));
+  while (last - first >= width) {
+#if ICUBABY_HAVE_AVX2
+    auto zeros = _mm256_setzero_si256 ();
+    for (auto iteration = 0; iteration < max_iterations && last - first >= width; ++iteration, first += width) {
+      auto const bytes = _mm256_loadu_si256 (reinterpret_cast<__m256i const*> (first));
+      zeros = _mm256_sub_epi8 (zeros, _mm256_cmpeq_epi8 (bytes, _mm256_setzero_si256 ()));
+      offset += width;
+    }
+    std::array<std::uint8_t, width> lanes;
+    _mm256_storeu_si256 (reinterpret_cast<__m256i*> (lanes.data ()), zeros);
+#else
+    auto zeros = _mm_setzero_si128 ();
+    for (auto iteration = 0; iteration < max_iterations && last - first >= width; ++iteration, first += width) {
+      auto const bytes = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (first));
+      zeros = _mm_sub_epi8 (zeros, _mm_cmpeq_epi8 (bytes, _mm_setzero_si128 ()));
+      offset += width;
+    }
+    std::array<std::uint8_t, width> lanes;
+    _mm_storeu_si128 (reinterpret_cast<__m128i*> (lanes.data ()), zeros);
+#endif  // ICUBABY_HAVE_AVX2
+    for (auto lane = std::size_t{0}; lane < lanes.size (); ++lane) {
+      result[lane % 4U] += lanes[lane];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    }
+  }
+#endif  // ICUBABY_HAVE_AVX2 || ICUBABY_HAVE_SSE2
+  for (; first != last; ++first, ++offset) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    result[offset % 4U] += static_cast<std::size_t> (*first == std::byte{0});
+  }
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+  return result;
+}
+
+/// \brief Returns true if a sequence of bytes could be the start of well-formed UTF-16 or UTF-32.
+///
+/// A UTF-16 high surrogate must be followed by a low surrogate and a low surrogate must follow a high surrogate. A
+/// UTF-32 code unit must be a Unicode scalar value. A high surrogate at the end of the input is accepted since its low
+/// surrogate may simply not be included.
+///
+/// \tparam CodeUnit  The type of the code units: char16_t or char32_t.
+/// \param first  The start of the input bytes. There must be count * sizeof (CodeUnit) bytes.
+/// \param count  The number of code units to be checked.
+/// \param little_endian  True if the input bytes are little-endian and false if they are big-endian.
+/// \returns  True if the code units are well formed.
+template <typename CodeUnit>
+bool well_formed_units (std::byte const* first, std::size_t count, bool const little_endian) noexcept {
+  std::array<CodeUnit, 64> units;
+  auto want_low = false;
+  while (count > 0) {
+    auto const chunk = std::min (count, units.size ());
+    gather_code_units (first, chunk, little_endian, units.data ());
+    for (auto index = std::size_t{0}; index < chunk; ++index) {
+      auto const unit = units[index];  // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+      if constexpr (std::is_same_v<CodeUnit, char16_t>) {
+        if (is_low_surrogate (unit) != want_low) {
+          return false;
+        }
+        want_low = is_high_surrogate (unit);
+      } else {
+        if (!is_code_point_start (unit)) {
+          return false;
+        }
+      }
+    }
+    first += chunk * sizeof (CodeUnit);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    count -= chunk;
+  }
+  return true;
+}
+
+/// \brief Returns true if a sequence of bytes could be the start of well-formed UTF-8.
+///
+/// \param first  The start of the input bytes.
+/// \param last  The end of the input bytes.
+/// \returns  True if the bytes are well formed UTF-8 apart from a possible incomplete code point at the end.
+inline bool well_formed_utf8 (std::byte const* const first, std::byte const* const last) noexcept {
+  // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+  auto const* const utf8_last = reinterpret_cast<char8 const*> (last);
+  auto const* in = bulk_validate_utf8 (reinterpret_cast<char8 const*> (first), utf8_last);
+  // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (in == nullptr) {
+    return false;
+  }
+  auto state = utf8d_accept;
+  for (; in != utf8_last && state != utf8d_reject; ++in) {  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    state = utf8d_next (state, static_cast<std::uint_least8_t> (*in));
+  }
+  return state != utf8d_reject;
+}
+
+}  // end namespace details
+
+/// \brief Guesses the encoding of a sequence of bytes.
+///
+/// If the input starts with a byte order mark, the encoding that it denotes is returned. Otherwise the following
+/// tests are applied in order:
+///
+/// - The most significant byte of every UTF-32 code unit is zero and, since most text lies in the Basic Multilingual
+///   Plane, so is the next byte of most code units. Input which matches this pattern and consists of Unicode scalar
+///   values is UTF-32.
+/// - Text in Latin and many other scripts has a zero high byte in most UTF-16 code units but few zero low bytes. Input
+///   which matches this pattern and whose surrogates are correctly paired is UTF-16.
+/// - Well-formed UTF-8 is UTF-8.
+/// - Otherwise, input whose surrogates are correctly paired is UTF-16, preferring little-endian.
+/// - Anything else is assumed to be UTF-8.
+///
+/// The zero bytes are counted and UTF-8 validity checked using SSE2/AVX2 instructions where they are available. The
+/// cost is proportional to the size of the input, so callers that are examining a large file should pass only a
+/// prefix of it.
+///
+/// \param first  The start of the input bytes.
+/// \param last  The end of the input bytes.
+/// \returns  The guessed encoding or encoding::unknown if the input is empty. The input need not end on a code point
+///   boundary.
+inline encoding guess_encoding (std::byte const* const first, std::byte const* const last) noexcept {
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  auto const size = static_cast<std::size_t> (last - first);
+  if (size == 0) {
+    return encoding::unknown;
+  }
+  auto const has_bom = [first, size] (std::size_t const index, std::size_t const bom_size) {
+    return size >= bom_size && std::equal (first, first + bom_size, details::boms[index].begin ());
+  };
+  // The UTF-32 LE byte order mark starts with the UTF-16 LE byte order mark so must be checked first.
+  if (has_bom (3, 4)) {
+    return encoding::utf32le;
+  }
+  if (has_bom (2, 4)) {
+    return encoding::utf32be;
+  }
+  if (has_bom (1, 2)) {
+    return encoding::utf16le;
+  }
+  if (has_bom (0, 2)) {
+    return encoding::utf16be;
+  }
+  if (has_bom (4, 3)) {
+    return encoding::utf8;
+  }
+
+  auto const units32 = size / 4U;
+  auto const units16 = size / 2U;
+  auto const zeros = details::count_zero_bytes (first, first + units32 * 4U);
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  if (units32 > 0) {
+    // UTF-32: the most significant byte of each code unit is zero, as is the next byte of at least half of them.
+    auto const utf32 = [first, units32, &zeros] (std::size_t const msb, std::size_t const next, bool const le) {
+      return zeros[msb] == units32 && zeros[next] * 2U >= units32 &&
+             details::well_formed_units<char32_t> (first, units32, le);
+    };
+    if (utf32 (3, 2, true)) {
+      return encoding::utf32le;
+    }
+    if (utf32 (0, 1, false)) {
+      return encoding::utf32be;
+    }
+  }
+  // UTF-16: at least a quarter of the counted code units have a zero high byte, and zero high bytes outnumber zero low
+  // bytes by more than two to one.
+  auto const even = zeros[0] + zeros[2];
+  auto const odd = zeros[1] + zeros[3];
+  auto const utf16 = [first, units16, units32] (std::size_t const high, std::size_t const low, bool const le) {
+    return high > 2U * low && high * 4U >= units32 * 2U && details::well_formed_units<char16_t> (first, units16, le);
+  };
+  if (utf16 (odd, even, true)) {
+    return encoding::utf16le;
+  }
+  if (utf16 (even, odd, false)) {
+    return encoding::utf16be;
+  }
+  if (details::well_formed_utf8 (first, last)) {
+    return encoding::utf8;
+  }
+  if (units16 > 0) {
+    if (details::well_formed_units<char16_t> (first, units16, true)) {
+      return encoding::utf16le;
+    }
+    if (details::well_formed_units<char16_t> (first, units16, false)) {
+      return encoding::utf16be;
+    }
+  }
+  return encoding::utf8;
+}
+
+#if ICUBABY_HAVE_SPAN
+/// \brief Guesses the encoding of a sequence of bytes.
+///
+/// \param input  The input bytes.
+/// \returns  The guessed encoding or encoding::unknown if the input is empty.
+/// \see guess_encoding(std::byte const*, std::byte const*)
+inline encoding guess_encoding (std::span<std::byte const> input) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return guess_encoding (input.data (), input.data () + input.size ());
+}
+#endif  // ICUBABY_HAVE_SPAN
+
+/// A tag type used to select the byte transcoder's encoding detection mode.
+struct detect_encoding_t {
+  /// Constructs the tag.
+  explicit constexpr detect_encoding_t () noexcept = default;
+};
+/// A tag value used to select the byte transcoder's encoding detection mode.
+inline constexpr detect_encoding_t detect_encoding{};
+
+/// \brief The "byte transcoder" takes a sequence of bytes, determines their encoding and converts
+///    to a specified encoding.
+///
+/// This transcoder is used when the input encoding is not known at compile-time. If present, a leading
+/// byte-order-mark is interpreted to select the source encoding; if not present, UTF-8 encoding is assumed. A
+/// transcoder constructed with detect_encoding instead guesses the encoding of input without a byte order mark.
+///
+/// The byte transcoder is implemented as a finite state machine. The following diagram shows the state transitions that
+/// occur as input bytes are received. Each vertex rectangle represents a state (the upper half has the state name
+/// and the lower briefly describes the meaning of that state). Each edge describes the condition for that transition to
+/// be made.
+///
+/// - An edge with description of the form *x=y* (where *y* is a hexadecimal constant) is taken if the input value *x*
+///   is equal to the constant *y*.
+/// - An edge with the description "otherwise" is taken if no other edges with the same origin are matched.
+/// - An edge without a description is unconditionally taken for the next byte
+///
+/// \dotfile byte_transcoder.dot
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding, error_policy Policy>
+class transcoder<std::byte, ToEncoding, Policy> {
+public:
+  /// The type of the values consumed by this transcoder.
+  using input_type = std::byte;
+  /// The type of the code units produced by this transcoder.
+  using output_type = ToEncoding;
+  /// The action taken when ill-formed input is encountered. The same policy is used to convert the input once its
+  /// encoding has been determined.
+  static constexpr error_policy policy = Policy;
+
+  /// Constructs a transcoder which determines the input encoding from an optional leading byte order mark.
+  transcoder () noexcept = default;
+  /// \brief Constructs a transcoder for input whose encoding is already known.
+  ///
+  /// The transcoder starts decoding immediately rather than buffering the initial bytes while looking for a byte
+  /// order mark. If \p enc is encoding::unknown, the transcoder behaves as if default constructed.
+  ///
+  /// \param enc  The encoding of the input.
+  /// \param strip_bom  If true, a byte order mark for encoding \p enc at the start of the input is removed.
+  explicit transcoder (encoding const enc, bool const strip_bom = true) noexcept {
+    this->select_encoding (enc, strip_bom);
+  }
+  /// \brief Constructs a transcoder which guesses the input encoding if there is no byte order mark.
+  ///
+  /// The first call to transcode() with non-empty input passes up to \p prefix bytes of that input to
+  /// guess_encoding(). The transcoder then behaves as if it had been constructed with the resulting encoding (and
+  /// strip_bom set to true). Bytes passed to operator() are not examined in this way: if operator() is called first,
+  /// the encoding is determined by an optional byte order mark as usual.
+  ///
+  /// \param prefix  The maximum number of bytes to be examined. If 0, no detection is performed.
+  explicit transcoder (detect_encoding_t /*unused*/, std::size_t const prefix = default_detect_prefix) noexcept
+      : detect_prefix_{prefix} {}
+
+  /// The default number of bytes examined by a transcoder constructed with detect_encoding.
+  static constexpr auto default_detect_prefix = std::size_t{4096};
+
+  /// \brief Accepts a byte for decoding. Output is written to a supplied output iterator.
+  ///
+  /// As output code units are generated, they are written to the output iterator \p dest.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
+  /// \param value  A byte of input.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
+  OutputIterator operator() (input_type value, OutputIterator dest) noexcept (Policy != error_policy::exception) {
+    if (check_bom_) {
+      // The input encoding was given to the constructor and we're checking for a leading byte order mark.
+      if (value == this->bom_value (bom_matched_)) {
+        ++bom_matched_;
+        if (bom_matched_ == this->bom_size ()) {
+          // Drop the complete byte order mark.
+          check_bom_ = false;
+          bom_matched_ = 0;
+        }
+        return dest;
+      }
+      dest = this->replay_bom (dest);
+    }
+    switch (state_) {
+    case states::start: dest = this->start_state (value, dest); break;
+    case states::utf8_bom_byte2:
+      assert (this->get_byte_no () == 2 && "Expected this state to target byte #2");
+      buffer_[this->get_byte_no ()] = value;
+      // Start decoding as UTF-8. If we have a complete UTF-8 BOM drop it, otherwise output the code units seen so far.
+      dest = this->run8_start (value != this->bom_value (), dest);
+      break;
+
+    case states::utf16_be_bom_byte1:
+      assert (this->get_byte_no () == 1 && "Expected this state to target byte #1");
+      buffer_[this->get_byte_no ()] = value;
+      // We either have a complete UTF-16 BE BOM, in which case we start transcoding, or we default to UTF-8 emitting
+      // the bytes consumed so far.
+      dest = value == this->bom_value () ? this->run16_start (dest) : this->run8_start (true, dest);
+      break;
+
+    case states::utf32_or_16_le_bom_byte2:
+      assert (this->get_byte_no () == 2 && "Expected this state to target byte #2");
+      if (value != transcoder::bom_value (encoding_utf32 | little_endian, this->get_byte_no ())) {
+        // This isn't a UTF-32 LE BOM but the start of a UTF-16 run.
+        dest = this->run16_start (dest);
+        state_ = states::run_16le_byte1;
+        buffer_[0] = value;
+        break;
+      }
+      [[fallthrough]];
+
+    case states::utf8_bom_byte1:
+    case states::utf32_or_16_le_bom_byte1:
+    case states::utf32_or_16_be_bom_byte1:
+    case states::utf32_be_bom_byte2:
+      assert ((this->get_byte_no () == 1 || this->get_byte_no () == 2) && "This must be byte #1 or #2");
+      buffer_[this->get_byte_no ()] = value;
+      if (value == this->bom_value ()) {
+        state_ = this->next_byte ();
+      } else {
+        // Default input encoding. Emit buffer.
+        dest = this->run8_start (true, dest);
+      }
+      break;
+
+    case states::utf32_le_bom_byte3:
+    case states::utf32_be_bom_byte3:
+      assert (this->get_byte_no () == 3 && "Expected this to be byte #3");
       buffer_[this->get_byte_no ()] = value;
       if (value == transcoder::bom_value (encoding_utf32 | (static_cast<std::byte> (state_) & endian_mask),
                                           this->get_byte_no ())) {
@@ -1382,6 +3844,55 @@ public:
     return dest;
   }
 
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of bytes in a single call. See \ref transcoder-transcode "transcode()".
+  ///
+  /// \param input  A span of input bytes.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  ///
+  /// Once the input encoding has been determined, whole code units are assembled in blocks and passed to the
+  /// transcoder for that encoding's transcode() member function. This avoids the per-byte state machine and allows
+  /// vectorized conversion. Byte order mark detection and code units which are split between calls are handled one
+  /// byte at a time.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    auto const* const first = input.data ();
+    auto const* const last = first + input.size ();
+    auto* const out_first = output.data ();
+    auto* const out_last = out_first + output.size ();
+    auto const* in = first;
+    auto* out = out_first;
+    if (detect_prefix_ != 0 && state_ == states::start && first != last) {
+      this->select_encoding (guess_encoding (first, first + std::min (input.size (), detect_prefix_)), true);
+      detect_prefix_ = 0;
+    }
+    while (in != last) {
+      if (!check_bom_ && this->is_run_mode () && this->get_byte_no () == 0) {
+        auto const [consumed, produced] = this->run_block (in, last, out, out_last);
+        in += consumed;
+        out += produced;
+        if (static_cast<std::size_t> (last - in) >= this->code_unit_size ()) {
+          break;  // The output is full.
+        }
+        if (in == last) {
+          break;
+        }
+      }
+      auto const res = details::transcode_block (*this, in, in + 1, out, out_last);
+      if (res.consumed == 0) {
+        break;
+      }
+      ++in;
+      out += res.produced;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return {static_cast<std::size_t> (in - first), static_cast<std::size_t> (out - out_first), this->partial ()};
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
   /// \brief Call once the entire input sequence has been fed to operator().
   ///
   /// This function ensures that the sequence did not end with a partial code point.
@@ -1390,10 +3901,13 @@ public:
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (ToEncoding) OutputIterator>
-  OutputIterator end_cp (OutputIterator dest) noexcept {
+  OutputIterator end_cp (OutputIterator dest) noexcept (Policy != error_policy::exception) {
     if (transcoder_variant_.valueless_by_exception ()) {
       return dest;
     }
+    if (check_bom_) {
+      dest = this->replay_bom (dest);
+    }
     return std::visit (
         [this, &dest] (auto& arg) {
           if constexpr (std::is_same_v<std::decay_t<decltype (arg)>, std::monostate>) {
@@ -1423,14 +3937,19 @@ public:
   /// \returns True if the input represents well formed Unicode.
   [[nodiscard]] constexpr bool well_formed () const noexcept;
 
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()". Until the input encoding
+  /// has been determined, the input is well formed and the call has no effect.
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool well_formed) noexcept;
+
   /// \brief Return true if a partial code-point has been passed to operator().
   /// \returns True if a partial code-point has been passed to operator() and
   /// false otherwise.
   [[nodiscard]] constexpr bool partial () const noexcept;
 
   /// \brief The detected encoding of the input stream.
-  /// \returns The encoding of the input stream as detected by consuming an optional leading byte order mark. Initially
-  ///          encoding::unknown.
+  /// \returns The encoding of the input stream as detected by consuming an optional leading byte order mark or, for a
+  ///          transcoder constructed with detect_encoding, as guessed by guess_encoding(). Initially encoding::unknown.
   [[nodiscard]] constexpr encoding selected_encoding () const noexcept;
 
 private:
@@ -1662,11 +4181,11 @@ private:
   }
 
   /// A short name for the transcoder used when UTF-8 input has been detected.
-  using t8_type = transcoder<icubaby::char8, ToEncoding>;
+  using t8_type = transcoder<icubaby::char8, ToEncoding, Policy>;
   /// A short name for the transcoder used when UTF-16 input has been detected.
-  using t16_type = transcoder<char16_t, ToEncoding>;
+  using t16_type = transcoder<char16_t, ToEncoding, Policy>;
   /// A short name for the transcoder used when UTF-32 input has been detected.
-  using t32_type = transcoder<char32_t, ToEncoding>;
+  using t32_type = transcoder<char32_t, ToEncoding, Policy>;
 
   /// The current state of the FSM.
   states state_ = states::start;
@@ -1674,6 +4193,14 @@ private:
   std::array<std::byte, 4> buffer_{};
   /// Holds the transcoder used to convert input code units. Holds monostate until the input encoding has been selected.
   std::variant<std::monostate, t8_type, t16_type, t32_type> transcoder_variant_;
+  /// True if the input encoding was given to the constructor and the leading bytes of the input are being compared
+  /// with the encoding's byte order mark.
+  bool check_bom_ = false;
+  /// The number of bytes of the byte order mark that have been matched while check_bom_ is true.
+  std::uint_least8_t bom_matched_ = 0;
+  /// The number of bytes to be examined by guess_encoding() on the first call to transcode(), or 0 if the encoding is
+  /// not to be guessed.
+  std::size_t detect_prefix_ = 0;
 
   /// \brief A helper for ensuring that a type will not cause variant_ to become valueless by exception.
   ///
@@ -1690,6 +4217,129 @@ private:
   static_assert (is_nothrowable<t16_type>::value);
   static_assert (is_nothrowable<t32_type>::value);
 
+  /// \brief Selects the input encoding and enters run mode.
+  ///
+  /// \param enc  The encoding of the input. If encoding::unknown, the transcoder is unchanged.
+  /// \param strip_bom  If true, a byte order mark for encoding \p enc at the start of the input is removed.
+  void select_encoding (encoding const enc, bool const strip_bom) noexcept {
+    switch (enc) {
+    case encoding::utf8:
+      (void)transcoder_variant_.template emplace<t8_type> ();
+      state_ = states::run_8;
+      break;
+    case encoding::utf16be:
+    case encoding::utf16le:
+      (void)transcoder_variant_.template emplace<t16_type> ();
+      state_ = enc == encoding::utf16be ? states::run_16be_byte0 : states::run_16le_byte0;
+      break;
+    case encoding::utf32be:
+    case encoding::utf32le:
+      (void)transcoder_variant_.template emplace<t32_type> ();
+      state_ = enc == encoding::utf32be ? states::run_32be_byte0 : states::run_32le_byte0;
+      break;
+    case encoding::unknown:
+    default: return;
+    }
+    check_bom_ = strip_bom;
+  }
+
+  /// \returns  The number of bytes in the byte order mark of the selected input encoding.
+  [[nodiscard]] constexpr std::uint_least8_t bom_size () const noexcept {
+    auto const enc = static_cast<std::byte> (state_) & encoding_mask;
+    return enc == encoding_utf32 ? 4U : (enc == encoding_utf16 ? 2U : 3U);
+  }
+  /// \param byte_number  The index of a byte within the byte order mark of the selected input encoding.
+  /// \returns  A byte from the byte order mark of the selected input encoding.
+  [[nodiscard]] constexpr std::byte bom_value (std::uint_least8_t const byte_number) const noexcept {
+    return transcoder::bom_value (static_cast<std::byte> (state_) & (encoding_mask | endian_mask), byte_number);
+  }
+  /// Ends the check for a leading byte order mark. The bytes matched so far were not part of a byte order mark and are
+  /// decoded.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (ToEncoding) OutputIterator>
+  [[nodiscard]] OutputIterator replay_bom (OutputIterator dest) noexcept (Policy != error_policy::exception) {
+    check_bom_ = false;
+    for (auto index = std::uint_least8_t{0}; index < bom_matched_; ++index) {
+      dest = (*this) (this->bom_value (index), dest);
+    }
+    bom_matched_ = 0;
+    return dest;
+  }
+
+  /// \returns  The number of bytes in each code unit of the selected input encoding.
+  [[nodiscard]] constexpr std::size_t code_unit_size () const noexcept {
+    auto const enc = static_cast<std::byte> (state_) & encoding_mask;
+    return enc == encoding_utf32 ? 4U : (enc == encoding_utf16 ? 2U : 1U);
+  }
+
+#if ICUBABY_HAVE_SPAN
+  /// \brief Converts whole code units of input once the input encoding has been selected.
+  ///
+  /// \param first  The start of the input bytes. This must be the first byte of a code unit.
+  /// \param last  The end of the input bytes.
+  /// \param out_first  The start of the output range.
+  /// \param out_last  The end of the output range.
+  /// \returns  The number of bytes consumed and the number of code units produced.
+  std::pair<std::size_t, std::size_t> run_block (input_type const* const first, input_type const* const last,
+                                                 output_type* const out_first,
+                                                 output_type* const out_last) noexcept (Policy !=
+                                                     error_policy::exception) {
+    assert (this->is_run_mode () && this->get_byte_no () == 0);
+    if (auto* const utf8_input = std::get_if<t8_type> (&transcoder_variant_)) {
+      return transcoder::run_units (*utf8_input, first, last, false, out_first, out_last);
+    }
+    if (auto* const utf16_input = std::get_if<t16_type> (&transcoder_variant_)) {
+      return transcoder::run_units (*utf16_input, first, last, this->is_little_endian (), out_first, out_last);
+    }
+    if (auto* const utf32_input = std::get_if<t32_type> (&transcoder_variant_)) {
+      return transcoder::run_units (*utf32_input, first, last, this->is_little_endian (), out_first, out_last);
+    }
+    assert (false && "The variant must hold a transcoder in run mode");
+    return {0, 0};
+  }
+
+  /// \brief Assembles blocks of code units from the input bytes and passes them to a transcoder.
+  ///
+  /// \tparam Transcoder  The type of the transcoder for the selected input encoding.
+  /// \param trans  The transcoder for the selected input encoding.
+  /// \param first  The start of the input bytes. This must be the first byte of a code unit.
+  /// \param last  The end of the input bytes.
+  /// \param little_endian  True if the input bytes are little-endian and false if they are big-endian.
+  /// \param out_first  The start of the output range.
+  /// \param out_last  The end of the output range.
+  /// \returns  The number of bytes consumed and the number of code units produced.
+  template <typename Transcoder>
+  static std::pair<std::size_t, std::size_t> run_units (Transcoder& trans, input_type const* const first,
+                                                        input_type const* const last, bool const little_endian,
+                                                        output_type* const out_first,
+                                                        output_type* const out_last) noexcept (Policy !=
+                                                            error_policy::exception) {
+    using unit_type = typename Transcoder::input_type;
+    constexpr auto block_size = std::size_t{512};
+    std::array<unit_type, block_size> units;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    auto const* in = first;
+    auto* out = out_first;
+    // A transcoder which had already stopped on entry discards all of its input.
+    auto const stopped_on_entry = details::stopped<Policy> (trans.well_formed ());
+    while (static_cast<std::size_t> (last - in) >= sizeof (unit_type)) {
+      auto const count = std::min (block_size, static_cast<std::size_t> (last - in) / sizeof (unit_type));
+      details::gather_code_units (in, count, little_endian, units.data ());
+      auto const res = trans.transcode (std::span<unit_type const>{units.data (), count}, std::span{out, out_last});
+      in += res.consumed * sizeof (unit_type);
+      out += res.produced;
+      if (res.consumed < count || (!stopped_on_entry && details::stopped<Policy> (trans.well_formed ()))) {
+        break;  // The output is full or ill-formed input has stopped conversion.
+      }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return {static_cast<std::size_t> (in - first), static_cast<std::size_t> (out - out_first)};
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
   /// Handles the initial state of the FSM. Checks the initial input byte against the collection of potential byte order
   /// mark initial bytes and decides on the next action.
   ///
@@ -1698,7 +4348,8 @@ private:
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (ToEncoding) OutputIterator>
-  [[nodiscard]] OutputIterator start_state (input_type const value, OutputIterator dest) noexcept {
+  [[nodiscard]] OutputIterator start_state (input_type const value,
+                                            OutputIterator dest) noexcept (Policy != error_policy::exception) {
     static constexpr auto byte_number = 0U;
     buffer_[byte_number] = value;
     if (value == transcoder::bom_value (encoding_utf8 | big_endian, byte_number)) {
@@ -1724,7 +4375,8 @@ private:
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (ToEncoding) OutputIterator>
-  [[nodiscard]] OutputIterator run8_start (bool const copy_buffer, OutputIterator dest) noexcept {
+  [[nodiscard]] OutputIterator run8_start (bool const copy_buffer,
+                                           OutputIterator dest) noexcept (Policy != error_policy::exception) {
     assert (!this->is_run_mode () && "The FSM should not be in run mode when run8_start is called");
     assert (std::holds_alternative<std::monostate> (transcoder_variant_) &&
             "The variant should hold monostate until the FSM is in run mode");
@@ -1767,7 +4419,8 @@ private:
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (ToEncoding) OutputIterator>
-  [[nodiscard]] OutputIterator run16 (input_type const value, OutputIterator dest) noexcept {
+  [[nodiscard]] OutputIterator run16 (input_type const value,
+                                      OutputIterator dest) noexcept (Policy != error_policy::exception) {
     assert (state_ == states::run_16be_byte1 || state_ == states::run_16le_byte1);
     assert (std::holds_alternative<t16_type> (transcoder_variant_));
 
@@ -1791,7 +4444,8 @@ private:
   /// \param dest  An output iterator to which the output sequence is written.
   /// \returns  Iterator one past the last element assigned.
   template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (ToEncoding) OutputIterator>
-  [[nodiscard]] OutputIterator run32 (input_type const value, OutputIterator dest) noexcept {
+  [[nodiscard]] OutputIterator run32 (input_type const value,
+                                      OutputIterator dest) noexcept (Policy != error_policy::exception) {
     assert (state_ == states::run_32be_byte3 || state_ == states::run_32le_byte3);
     assert (std::holds_alternative<t32_type> (transcoder_variant_));
 
@@ -1853,13 +4507,16 @@ private:
 
 // partial
 // ~~~~~~~
-template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding>
-constexpr bool transcoder<std::byte, ToEncoding>::partial () const noexcept {
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding, error_policy Policy>
+constexpr bool transcoder<std::byte, ToEncoding, Policy>::partial () const noexcept {
   // We ensure that the variant cannot ever become stateless. This check is belt and braces to guarantee that
   // std::visit() cannot throw.
   if (transcoder_variant_.valueless_by_exception ()) {
     return false;
   }
+  if (bom_matched_ > 0) {
+    return true;
+  }
   return std::visit (
       [this] (auto const& arg) {
         if constexpr (std::is_same_v<std::decay_t<decltype (arg)>, std::monostate>) {
@@ -1873,8 +4530,8 @@ constexpr bool transcoder<std::byte, ToEncoding>::partial () const noexcept {
 
 // well formed
 // ~~~~~~~~~~~
-template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding>
-constexpr bool transcoder<std::byte, ToEncoding>::well_formed () const noexcept {
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding, error_policy Policy>
+constexpr bool transcoder<std::byte, ToEncoding, Policy>::well_formed () const noexcept {
   if (transcoder_variant_.valueless_by_exception ()) {
     return true;
   }
@@ -1889,10 +4546,26 @@ constexpr bool transcoder<std::byte, ToEncoding>::well_formed () const noexcept
       transcoder_variant_);
 }
 
+// set well formed
+// ~~~~~~~~~~~~~~~
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding, error_policy Policy>
+constexpr void transcoder<std::byte, ToEncoding, Policy>::set_well_formed (bool const well_formed) noexcept {
+  if (transcoder_variant_.valueless_by_exception ()) {
+    return;
+  }
+  std::visit (
+      [well_formed] (auto& arg) {
+        if constexpr (!std::is_same_v<std::decay_t<decltype (arg)>, std::monostate>) {
+          arg.set_well_formed (well_formed);
+        }
+      },
+      transcoder_variant_);
+}
+
 // selected encoding
 // ~~~~~~~~~~~~~~~~~
-template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding>
-constexpr encoding transcoder<std::byte, ToEncoding>::selected_encoding () const noexcept {
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding, error_policy Policy>
+constexpr encoding transcoder<std::byte, ToEncoding, Policy>::selected_encoding () const noexcept {
   if (!this->is_run_mode ()) {
     return encoding::unknown;
   }
@@ -1929,13 +4602,17 @@ struct triangulator_intermediate_code_units<char16_t, ToEncoding> : public std::
 ///
 /// \tparam FromEncoding  The source encoding.
 /// \tparam ToEncoding  The destination encoding.
-template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE FromEncoding, ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding>
+/// \tparam Policy  The action taken when ill-formed input is encountered.
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE FromEncoding, ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding,
+          error_policy Policy = error_policy::replace>
 class triangulator {
 public:
   /// The type of the code units consumed by this transcoder.
   using input_type = FromEncoding;
   /// The type of the code units produced by this transcoder.
   using output_type = ToEncoding;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
 
   /// Accepts a code unit in the source encoding (as given by triangulator::input_type). These are first converted
   /// to UTF-32 and then to the output encoding (double_transcoder::output_type). As output code units are generated,
@@ -1956,133 +4633,413 @@ public:
     return copy (begin, intermediate_ (code_unit, begin), dest);
   }
 
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of code units in a single call. See \ref transcoder-transcode "transcode()".
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    return details::transcode_block (*this, input.data (), input.data () + input.size (), output.data (),
+                                     output.data () + output.size ());
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
+  /// Call once the entire input sequence has been fed to operator(). This
+  /// function ensures that the sequence did not end with a partial code point.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator> OutputIterator end_cp (OutputIterator dest) {
+    std::array<char32_t, triangulator_intermediate_code_units<FromEncoding, ToEncoding>::value> intermediate{};
+    // NOLINTNEXTLINE(llvm-qualified-auto,readability-qualified-auto)
+    auto const first = std::begin (intermediate);
+    // NOLINTNEXTLINE(llvm-qualified-auto,readability-qualified-auto)
+    auto const last = intermediate_.end_cp (first);
+    assert (last >= first && last <= std::end (intermediate));
+    return output_.end_cp (this->copy (first, last, dest));
+  }
+
+  /// Call once the entire input sequence has been fed to operator(). This
+  /// function ensures that the sequence did not end with a partial code point.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
+  constexpr iterator<transcoder<FromEncoding, ToEncoding, Policy>, OutputIterator> end_cp (
+      iterator<transcoder<FromEncoding, ToEncoding, Policy>, OutputIterator> dest) {
+    auto const transcoder = dest.transcoder ();
+    assert (transcoder == this);
+    return {transcoder, transcoder->end_cp (dest.base ())};
+  }
+
+  /// \returns True if the input passed to operator() was valid.
+  [[nodiscard]] constexpr bool well_formed () const noexcept {
+    return intermediate_.well_formed () && output_.well_formed ();
+  }
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept {
+    intermediate_.set_well_formed (well_formed);
+    output_.set_well_formed (well_formed);
+  }
+
+  /// \returns True if a partial code-point has been passed to operator() and
+  /// false otherwise.
+  [[nodiscard]] constexpr bool partial () const noexcept { return intermediate_.partial (); }
+
+private:
+  /// We use the intermediate_ transcoder to convert from the input encoding to UTF-32.
+  transcoder<input_type, char32_t, Policy> intermediate_;
+  /// The output_ transcoder converts from the intermediate (UTF-32) encoding to the selected output encoding.
+  transcoder<char32_t, output_type, Policy> output_;
+
+  /// Copies the range [first, last) to the output iterator \p dest via the output_ transcoder.
+  ///
+  /// \param first  The first of the range to copy.
+  /// \param last  The last of the range to copy.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <typename InputIterator, typename OutputIterator>
+  OutputIterator copy (InputIterator first, InputIterator last, OutputIterator dest) {
+    (void)std::for_each (first, last, [this, &dest] (char32_t const code_unit) { dest = output_ (code_unit, dest); });
+    return dest;
+  }
+};
+
+}  // end namespace details
+
+/// Takes a sequence of UTF-8 code units and converts them to UTF-8.
+template <error_policy Policy>
+class transcoder<char8, char8, Policy> : public details::triangulator<char8, char8, Policy> {};
+/// Takes a sequence of UTF-16 code units and converts them to UTF-16.
+template <error_policy Policy>
+class transcoder<char16_t, char16_t, Policy> : public details::triangulator<char16_t, char16_t, Policy> {};
+/// Takes a sequence of UTF-32 code units and converts them to UTF-32.
+template <error_policy Policy> class transcoder<char32_t, char32_t, Policy> {
+public:
+  /// The type of the code units consumed by this transcoder.
+  using input_type = char32_t;
+  /// The type of the code units produced by this transcoder.
+  using output_type = char32_t;
+  /// The action taken when ill-formed input is encountered.
+  static constexpr error_policy policy = Policy;
+
+  /// Accepts a code unit in the UTF-32 source encoding. As UTF-32 output code units are generated, they are written to
+  /// the output iterator \p dest.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which values of
+  ///   output_type can be written.
+  /// \param code_unit  A UTF-32 code unit,
+  /// \param dest  Iterator to which the output should be written.
+  /// \returns  Iterator one past the last element assigned.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
+  OutputIterator operator() (input_type code_unit, OutputIterator dest) {
+    if (details::stopped<Policy> (well_formed_)) {
+      return dest;
+    }
+    // From D90 in Chapter 3 of Unicode 15.0.0
+    // <https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf>:
+    //
+    // "Because surrogate code points are not included in the set of Unicode
+    // scalar values, UTF-32 code units in the range 0000D80016..0000DFFF16 are
+    // ill-formed. Any UTF-32 code unit greater than 0x0010FFFF is ill-formed."
+    if (code_unit > max_code_point || is_surrogate (code_unit)) {
+      well_formed_ = false;
+      if (!details::replace_ill_formed<Policy> ()) {
+        return dest;
+      }
+      code_unit = replacement_char;
+    }
+    *(dest++) = code_unit;
+    return dest;
+  }
+
+#if ICUBABY_HAVE_SPAN
+  /// Converts a block of UTF-32 code units in a single call. See \ref transcoder-transcode "transcode()".
+  ///
+  /// \param input  A span of code units in the source encoding.
+  /// \param output  A span to which the output sequence is written.
+  /// \returns  The number of input code units consumed, the number of output code units produced, and whether the
+  ///   transcoder is holding a partial code point.
+  transcode_result transcode (std::span<input_type const> input,
+                              std::span<output_type> output) noexcept (Policy != error_policy::exception) {
+    return details::transcode_block (*this, input.data (), input.data () + input.size (), output.data (),
+                                     output.data () + output.size ());
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
   /// Call once the entire input sequence has been fed to operator(). This
   /// function ensures that the sequence did not end with a partial code point.
   ///
-  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param dest  An output iterator to which the output sequence is written.
-  /// \returns  Iterator one past the last element assigned.
-  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator> OutputIterator end_cp (OutputIterator dest) {
-    std::array<char32_t, triangulator_intermediate_code_units<FromEncoding, ToEncoding>::value> intermediate{};
-    // NOLINTNEXTLINE(llvm-qualified-auto,readability-qualified-auto)
-    auto const first = std::begin (intermediate);
-    // NOLINTNEXTLINE(llvm-qualified-auto,readability-qualified-auto)
-    auto const last = intermediate_.end_cp (first);
-    assert (last >= first && last <= std::end (intermediate));
-    return output_.end_cp (this->copy (first, last, dest));
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  The output iterator.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
+  constexpr OutputIterator end_cp (OutputIterator dest) const {
+    return dest;
+  }
+
+  /// Call once the entire input sequence has been fed to operator(). This
+  /// function ensures that the sequence did not end with a partial code point.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
+  constexpr iterator<transcoder, OutputIterator> end_cp (iterator<transcoder, OutputIterator> dest) {
+    auto coder = dest.transcoder ();
+    assert (coder == this);
+    return {coder, coder->end_cp (dest.base ())};
+  }
+
+  /// \returns True if the input represented well formed UTF-32.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state. See \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the transcoder's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept { well_formed_ = well_formed; }
+  /// \returns True if a partial code-point has been passed to operator() and
+  /// false otherwise.
+  // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+  [[nodiscard]] constexpr bool partial () const noexcept { return false; }
+
+private:
+  /// True if the input consumed is well formed, false otherwise.
+  bool well_formed_ = true;
+};
+
+/// \brief A shorter name for the UTF-8 to UTF-8 transcoder.
+/// This, assuming well-formed input, represents no change.
+using t8_8 = transcoder<char8, char8>;
+/// A shorter name for the UTF-8 to UTF-16 transcoder.
+using t8_16 = transcoder<char8, char16_t>;
+/// A shorter name for the UTF-8 to UTF-32 transcoder.
+using t8_32 = transcoder<char8, char32_t>;
+/// A shorter name for the UTF-16 to UTF-8 transcoder.
+using t16_8 = transcoder<char16_t, char8>;
+/// \brief A shorter name for the UTF-16 to UTF-16 transcoder.
+/// This, assuming well-formed input, represents no change.
+using t16_16 = transcoder<char16_t, char16_t>;
+/// A shorter name for the UTF-16 to UTF-32 transcoder.
+using t16_32 = transcoder<char16_t, char32_t>;
+
+/// A shorter name for the UTF-32 to UTF-8 transcoder.
+using t32_8 = transcoder<char32_t, char8>;
+/// A shorter name for the UTF-32 to UTF-16 transcoder.
+using t32_16 = transcoder<char32_t, char16_t>;
+/// \brief A shorter name for the UTF-32 to UTF-32 transcoder.
+/// This, assuming well-formed input, represents no change.
+using t32_32 = transcoder<char32_t, char32_t>;
+
+/// A shorter name for the UTF-8 "byte transcoder" which consumes bytes in unknown input encoding and produces UTF-8.
+using tx_8 = transcoder<std::byte, char8>;
+/// A shorter name for the UTF-16 "byte transcoder" which consumes bytes in unknown input encoding and produces UTF-16.
+using tx_16 = transcoder<std::byte, char16_t>;
+/// A shorter name for the UTF-32 "byte transcoder" which consumes bytes in unknown input encoding and produces UTF-32.
+using tx_32 = transcoder<std::byte, char32_t>;
+
+/// \brief Checks that a sequence of code units is well formed without producing any output.
+///
+/// A validator instance may be given its input in a series of chunks: a code point which is split between the end of
+/// one chunk and the start of the next is checked correctly. Call end_cp() once the entire input has been supplied to
+/// check that it did not end with a partial code point.
+///
+/// \tparam Encoding  The encoding of the input code units.
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE Encoding> class validator;
+
+/// Checks that a sequence of UTF-8 code units is well formed.
+template <> class validator<char8> {
+public:
+  /// The type of the code units consumed by this validator.
+  using input_type = char8;
+
+  /// Accepts a single UTF-8 code unit.
+  ///
+  /// \param code_unit  A UTF-8 code unit.
+  /// \returns  True if the input seen so far is well formed.
+  constexpr bool operator() (input_type const code_unit) noexcept {
+    state_ = details::utf8d_next (state_, static_cast<std::uint_least8_t> (code_unit));
+    if (state_ == details::utf8d_reject) {
+      // As a transcoder does, drop the ill-formed sequence and start afresh with the next code unit.
+      state_ = details::utf8d_accept;
+      well_formed_ = false;
+    }
+    return well_formed_;
+  }
+
+#if ICUBABY_HAVE_SPAN
+  /// Accepts a block of UTF-8 code units. Where available, SSSE3 or AVX2 instructions are used to check blocks of 16
+  /// or 32 code units at a time.
+  ///
+  /// \param input  A span of UTF-8 code units.
+  /// \returns  True if the input seen so far is well formed.
+  bool operator() (std::span<input_type const> input) noexcept {
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    auto const* in = input.data ();
+    auto const* const last = in + input.size ();
+    while (well_formed_ && in != last) {
+      if (state_ == details::utf8d_accept) {
+        in = details::bulk_validate_utf8 (in, last);
+        if (in == nullptr) {
+          well_formed_ = false;
+          break;
+        }
+        if (in == last) {
+          break;
+        }
+      }
+      (void)(*this) (*in);
+      ++in;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return well_formed_;
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
+  /// Call once the entire input sequence has been supplied. This function ensures that the sequence did not end with
+  /// a partial code point.
+  ///
+  /// \returns  True if the input was well formed.
+  constexpr bool end_cp () noexcept {
+    if (state_ != details::utf8d_accept) {
+      state_ = details::utf8d_accept;
+      well_formed_ = false;
+    }
+    return well_formed_;
+  }
+
+  /// \returns True if the input seen so far is well formed.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state without discarding a partial code point. See
+  /// \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the validator's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept { well_formed_ = well_formed; }
+  /// \returns True if a partial code point has been accepted and false otherwise.
+  [[nodiscard]] constexpr bool partial () const noexcept { return state_ != details::utf8d_accept; }
+
+private:
+  /// True if the input consumed is well formed, false otherwise.
+  bool well_formed_ = true;
+  /// The state of the utf8d automaton.
+  std::uint_least8_t state_ = details::utf8d_accept;
+};
+
+/// Checks that a sequence of UTF-16 code units is well formed.
+template <> class validator<char16_t> {
+public:
+  /// The type of the code units consumed by this validator.
+  using input_type = char16_t;
+
+  /// Accepts a single UTF-16 code unit.
+  ///
+  /// \param code_unit  A UTF-16 code unit.
+  /// \returns  True if the input seen so far is well formed.
+  constexpr bool operator() (input_type const code_unit) noexcept {
+    if (has_high_) {
+      // A high surrogate followed by a second high surrogate starts a new pair.
+      has_high_ = is_high_surrogate (code_unit);
+      if (!is_low_surrogate (code_unit)) {
+        well_formed_ = false;
+      }
+    } else if (is_high_surrogate (code_unit)) {
+      has_high_ = true;
+    } else if (is_low_surrogate (code_unit)) {
+      well_formed_ = false;
+    }
+    return well_formed_;
   }
 
-  /// Call once the entire input sequence has been fed to operator(). This
-  /// function ensures that the sequence did not end with a partial code point.
+#if ICUBABY_HAVE_SPAN
+  /// Accepts a block of UTF-16 code units.
   ///
-  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param dest  An output iterator to which the output sequence is written.
-  /// \returns  Iterator one past the last element assigned.
-  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  constexpr iterator<transcoder<FromEncoding, ToEncoding>, OutputIterator> end_cp (
-      iterator<transcoder<FromEncoding, ToEncoding>, OutputIterator> dest) {
-    auto const transcoder = dest.transcoder ();
-    assert (transcoder == this);
-    return {transcoder, transcoder->end_cp (dest.base ())};
+  /// \param input  A span of UTF-16 code units.
+  /// \returns  True if the input seen so far is well formed.
+  constexpr bool operator() (std::span<input_type const> input) noexcept {
+    for (auto const code_unit : input) {
+      if (!(*this) (code_unit)) {
+        break;
+      }
+    }
+    return well_formed_;
   }
+#endif  // ICUBABY_HAVE_SPAN
 
-  /// \returns True if the input passed to operator() was valid.
-  [[nodiscard]] constexpr bool well_formed () const noexcept {
-    return intermediate_.well_formed () && output_.well_formed ();
+  /// Call once the entire input sequence has been supplied. This function ensures that the sequence did not end with
+  /// a partial code point.
+  ///
+  /// \returns  True if the input was well formed.
+  constexpr bool end_cp () noexcept {
+    if (has_high_) {
+      has_high_ = false;
+      well_formed_ = false;
+    }
+    return well_formed_;
   }
 
-  /// \returns True if a partial code-point has been passed to operator() and
-  /// false otherwise.
-  [[nodiscard]] constexpr bool partial () const noexcept { return intermediate_.partial (); }
+  /// \returns True if the input seen so far is well formed.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+  /// Sets the "well formed" state without discarding a partial code point. See
+  /// \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the validator's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept { well_formed_ = well_formed; }
+  /// \returns True if a partial code point has been accepted and false otherwise.
+  [[nodiscard]] constexpr bool partial () const noexcept { return has_high_; }
 
 private:
-  /// We use the intermediate_ transcoder to convert from the input encoding to UTF-32.
-  transcoder<input_type, char32_t> intermediate_;
-  /// The output_ transcoder converts from the intermediate (UTF-32) encoding to the selected output encoding.
-  transcoder<char32_t, output_type> output_;
-
-  /// Copies the range [first, last) to the output iterator \p dest via the output_ transcoder.
-  ///
-  /// \param first  The first of the range to copy.
-  /// \param last  The last of the range to copy.
-  /// \param dest  An output iterator to which the output sequence is written.
-  /// \returns  Iterator one past the last element assigned.
-  template <typename InputIterator, typename OutputIterator>
-  OutputIterator copy (InputIterator first, InputIterator last, OutputIterator dest) {
-    (void)std::for_each (first, last, [this, &dest] (char32_t const code_unit) { dest = output_ (code_unit, dest); });
-    return dest;
-  }
+  /// True if the input consumed is well formed, false otherwise.
+  bool well_formed_ = true;
+  /// True if the previous code unit was a high surrogate.
+  bool has_high_ = false;
 };
 
-}  // end namespace details
-
-/// Takes a sequence of UTF-8 code units and converts them to UTF-16.
-template <> class transcoder<char8, char16_t> : public details::triangulator<char8, char16_t> {};
-/// Takes a sequence of UTF-16 code units and converts them to UTF-8.
-template <> class transcoder<char16_t, char8> : public details::triangulator<char16_t, char8> {};
-/// Takes a sequence of UTF-8 code units and converts them to UTF-8.
-template <> class transcoder<char8, char8> : public details::triangulator<char8, char8> {};
-/// Takes a sequence of UTF-16 code units and converts them to UTF-16.
-template <> class transcoder<char16_t, char16_t> : public details::triangulator<char16_t, char16_t> {};
-/// Takes a sequence of UTF-32 code units and converts them to UTF-32.
-template <> class transcoder<char32_t, char32_t> {
+/// Checks that a sequence of UTF-32 code units is well formed.
+template <> class validator<char32_t> {
 public:
-  /// The type of the code units consumed by this transcoder.
+  /// The type of the code units consumed by this validator.
   using input_type = char32_t;
-  /// The type of the code units produced by this transcoder.
-  using output_type = char32_t;
 
-  /// Accepts a code unit in the UTF-32 source encoding. As UTF-32 output code units are generated, they are written to
-  /// the output iterator \p dest.
+  /// Accepts a single UTF-32 code unit.
   ///
-  /// \tparam OutputIterator  An output iterator type to which values of
-  ///   output_type can be written.
-  /// \param code_unit  A UTF-32 code unit,
-  /// \param dest  Iterator to which the output should be written.
-  /// \returns  Iterator one past the last element assigned.
-  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  OutputIterator operator() (input_type code_unit, OutputIterator dest) {
-    // From D90 in Chapter 3 of Unicode 15.0.0
-    // <https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf>:
-    //
-    // "Because surrogate code points are not included in the set of Unicode
-    // scalar values, UTF-32 code units in the range 0000D80016..0000DFFF16 are
-    // ill-formed. Any UTF-32 code unit greater than 0x0010FFFF is ill-formed."
+  /// \param code_unit  A UTF-32 code unit.
+  /// \returns  True if the input seen so far is well formed.
+  constexpr bool operator() (input_type const code_unit) noexcept {
     if (code_unit > max_code_point || is_surrogate (code_unit)) {
       well_formed_ = false;
-      code_unit = replacement_char;
     }
-    *(dest++) = code_unit;
-    return dest;
+    return well_formed_;
   }
 
-  /// Call once the entire input sequence has been fed to operator(). This
-  /// function ensures that the sequence did not end with a partial code point.
+#if ICUBABY_HAVE_SPAN
+  /// Accepts a block of UTF-32 code units.
   ///
-  /// \param dest  An output iterator to which the output sequence is written.
-  /// \returns  The output iterator.
-  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  constexpr OutputIterator end_cp (OutputIterator dest) const {
-    return dest;
+  /// \param input  A span of UTF-32 code units.
+  /// \returns  True if the input seen so far is well formed.
+  constexpr bool operator() (std::span<input_type const> input) noexcept {
+    for (auto const code_unit : input) {
+      if (!(*this) (code_unit)) {
+        break;
+      }
+    }
+    return well_formed_;
   }
+#endif  // ICUBABY_HAVE_SPAN
 
-  /// Call once the entire input sequence has been fed to operator(). This
-  /// function ensures that the sequence did not end with a partial code point.
+  /// Call once the entire input sequence has been supplied. UTF-32 has no multi-unit sequences so this function
+  /// simply returns the validator's state.
   ///
-  /// \tparam OutputIterator  An output iterator type to which values of type output_type can be written.
-  /// \param dest  An output iterator to which the output sequence is written.
-  /// \returns  Iterator one past the last element assigned.
-  template <ICUBABY_CONCEPT_OUTPUT_ITERATOR (output_type) OutputIterator>
-  constexpr iterator<transcoder, OutputIterator> end_cp (iterator<transcoder, OutputIterator> dest) {
-    auto coder = dest.transcoder ();
-    assert (coder == this);
-    return {coder, coder->end_cp (dest.base ())};
-  }
+  /// \returns  True if the input was well formed.
+  constexpr bool end_cp () noexcept { return well_formed_; }
 
-  /// \returns True if the input represented well formed UTF-32.
+  /// \returns True if the input seen so far is well formed.
   [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
-  /// \returns True if a partial code-point has been passed to operator() and
-  /// false otherwise.
+  /// Sets the "well formed" state without discarding a partial code point. See
+  /// \ref transcoder-set-well-formed "set_well_formed()".
+  /// \param well_formed  The new value for the validator's "well formed" state.
+  constexpr void set_well_formed (bool const well_formed) noexcept { well_formed_ = well_formed; }
+  /// \returns True if a partial code point has been accepted and false otherwise.
   // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
   [[nodiscard]] constexpr bool partial () const noexcept { return false; }
 
@@ -2091,37 +5048,709 @@ private:
   bool well_formed_ = true;
 };
 
-/// \brief A shorter name for the UTF-8 to UTF-8 transcoder.
-/// This, assuming well-formed input, represents no change.
-using t8_8 = transcoder<char8, char8>;
-/// A shorter name for the UTF-8 to UTF-16 transcoder.
-using t8_16 = transcoder<char8, char16_t>;
-/// A shorter name for the UTF-8 to UTF-32 transcoder.
-using t8_32 = transcoder<char8, char32_t>;
-/// A shorter name for the UTF-16 to UTF-8 transcoder.
-using t16_8 = transcoder<char16_t, char8>;
-/// \brief A shorter name for the UTF-16 to UTF-16 transcoder.
-/// This, assuming well-formed input, represents no change.
-using t16_16 = transcoder<char16_t, char16_t>;
-/// A shorter name for the UTF-16 to UTF-32 transcoder.
-using t16_32 = transcoder<char16_t, char32_t>;
+#if ICUBABY_HAVE_SPAN
+/// \brief Checks whether a sequence of code units is well formed.
+///
+/// \tparam Encoding  The encoding of the input code units.
+/// \param input  The complete sequence of code units to be checked.
+/// \returns  True if \p input is well formed and false otherwise.
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE Encoding> bool validate (std::span<Encoding const> input) noexcept {
+  validator<Encoding> v;
+  (void)v (input);
+  return v.end_cp ();
+}
+
+/// \brief Records the position of each ill-formed sequence found by transcode_errors() or validate().
+///
+/// Offsets are measured in input code units from the start of the first block of input given to the recorder, so a
+/// single recorder may be used for a stream that is converted in a series of calls. The offset of an ill-formed
+/// sequence is that of the code unit at which it was detected: the unit which could not continue the sequence or,
+/// for a sequence that is truncated by the end of the input, the end of the input. A transcoder replaces each
+/// ill-formed sequence with a single REPLACEMENT CHARACTER, so count() is also the number of replacements made.
+///
+/// The offsets of the first errors are written to a span supplied by the caller. Once that span is full, errors are
+/// counted but their offsets are not recorded.
+class error_recorder {
+public:
+  /// The value returned by first_error() if no ill-formed input has been found.
+  static constexpr auto npos = std::numeric_limits<std::size_t>::max ();
+
+  /// Constructs a recorder which counts errors without recording their offsets.
+  constexpr error_recorder () noexcept = default;
+  /// \param offsets  A span to which the offsets of the first offsets.size() errors are written.
+  explicit constexpr error_recorder (std::span<std::size_t> const offsets) noexcept : offsets_{offsets} {}
+
+  /// Records an ill-formed sequence.
+  ///
+  /// \param index  The position of the ill-formed sequence relative to offset().
+  constexpr void record (std::size_t const index) noexcept {
+    auto const pos = offset_ + index;
+    if (count_ == 0) {
+      first_error_ = pos;
+    }
+    if (count_ < offsets_.size ()) {
+      offsets_[count_] = pos;
+    }
+    ++count_;
+  }
+  /// Moves the start of the next block of input.
+  ///
+  /// \param count  The number of input code units that have been consumed.
+  constexpr void advance (std::size_t const count) noexcept { offset_ += count; }
+
+  /// Calls the transcoder's end_cp() member function and records an error if the input ended with a partial code
+  /// point.
+  ///
+  /// \param transcoder  The transcoder whose end_cp() member function is to be called.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <typename Transcoder, typename OutputIterator>
+  ICUBABY_REQUIRES (is_transcoder<Transcoder>)
+  OutputIterator end_cp (Transcoder& transcoder, OutputIterator dest) {
+    auto const well_formed = transcoder.well_formed ();
+    if constexpr (details::policy_of<Transcoder> == error_policy::stop) {
+      // Resetting the "well formed" state would restart a stopped transcoder. Once stopped, errors are not recorded.
+      dest = transcoder.end_cp (dest);
+      if (well_formed && !transcoder.well_formed ()) {
+        this->record (0);
+      }
+    } else {
+      transcoder.set_well_formed (true);
+      dest = transcoder.end_cp (dest);
+      if (!transcoder.well_formed ()) {
+        this->record (0);
+      }
+      transcoder.set_well_formed (well_formed && transcoder.well_formed ());
+    }
+    return dest;
+  }
+
+  /// \returns  The offset of the first ill-formed sequence or npos if none has been found.
+  [[nodiscard]] constexpr std::size_t first_error () const noexcept { return first_error_; }
+  /// \returns  The number of ill-formed sequences that have been found.
+  [[nodiscard]] constexpr std::size_t count () const noexcept { return count_; }
+  /// \returns  The offsets of the first ill-formed sequences, up to the size of the span given to the constructor.
+  [[nodiscard]] constexpr std::span<std::size_t const> offsets () const noexcept {
+    return offsets_.first (std::min (count_, offsets_.size ()));
+  }
+  /// \returns  The number of input code units that have been consumed.
+  [[nodiscard]] constexpr std::size_t offset () const noexcept { return offset_; }
+
+private:
+  /// The span to which the offsets of the first errors are written.
+  std::span<std::size_t> offsets_;
+  /// The number of input code units that have been consumed.
+  std::size_t offset_ = 0;
+  /// The offset of the first ill-formed sequence.
+  std::size_t first_error_ = npos;
+  /// The number of ill-formed sequences found.
+  std::size_t count_ = 0;
+};
+
+/// \brief Checks whether a sequence of code units is well formed and records the position of each ill-formed
+///   sequence.
+///
+/// The input is checked in slices of 256 code units. A slice that contains ill-formed input is checked again one code
+/// unit at a time to find where each error lies, so well-formed input is checked at the same speed as validate() and
+/// no second pass over rejected input is needed to find its errors.
+///
+/// \tparam Encoding  The encoding of the input code units.
+/// \param input  The complete sequence of code units to be checked.
+/// \param errors  The error_recorder to which ill-formed sequences are reported.
+/// \returns  True if \p input is well formed and false otherwise.
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE Encoding>
+bool validate (std::span<Encoding const> input, error_recorder& errors) noexcept {
+  constexpr auto slice = std::size_t{256};
+  auto const initial_count = errors.count ();
+  validator<Encoding> v;
+  for (auto consumed = std::size_t{0}; consumed < input.size ();) {
+    auto const in = input.subspan (consumed, std::min (slice, input.size () - consumed));
+    auto const before = v;
+    if (!v (in)) {
+      v = before;
+      for (auto index = std::size_t{0}; index < in.size (); ++index) {
+        if (!v (in[index])) {
+          errors.record (consumed + index);
+          v.set_well_formed (true);
+        }
+      }
+    }
+    consumed += in.size ();
+  }
+  errors.advance (input.size ());
+  if (!v.end_cp ()) {
+    errors.record (0);
+  }
+  return errors.count () == initial_count;
+}
+
+/// \brief Computes the number of code units that converting a sequence of code units from one encoding to another
+///   will produce.
+///
+/// The result is exactly the number of code units produced by passing \p input to a default-constructed
+/// transcoder<FromEncoding, ToEncoding> followed by a call to end_cp(). This includes any REPLACEMENT CHARACTER
+/// code points that are substituted for ill-formed input. Well-formed UTF-8 and UTF-16 input is counted using vector
+/// instructions where they are available. This allows an output buffer of exactly the right size to be allocated
+/// before transcoding.
+///
+/// \tparam FromEncoding  The encoding of the input code units.
+/// \tparam ToEncoding  The encoding to which the input would be converted.
+/// \param input  The complete sequence of code units to be measured.
+/// \returns  The number of code units that converting \p input to ToEncoding will produce.
+template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE FromEncoding, ICUBABY_CONCEPT_UNICODE_CHAR_TYPE ToEncoding>
+std::size_t output_length (std::span<FromEncoding const> input) noexcept {
+  if constexpr (std::is_same_v<FromEncoding, ToEncoding> && !std::is_same_v<FromEncoding, char8>) {
+    // Every UTF-16 code unit or surrogate pair and every UTF-32 code unit produces an output of the same length (a
+    // REPLACEMENT CHARACTER if necessary).
+    return input.size ();
+  } else if constexpr (std::is_same_v<FromEncoding, char32_t>) {
+    auto result = std::size_t{0};
+    for (auto const code_unit : input) {
+      auto const code_point = static_cast<std::uint_least32_t> (code_unit);
+      auto const supplementary = code_point > 0xFFFF && code_point <= max_code_point;
+      if constexpr (std::is_same_v<ToEncoding, char16_t>) {
+        result += supplementary ? 2U : 1U;
+      } else {
+        // Surrogates and values outside the code space are replaced by U+FFFD which needs three bytes.
+        result += 1U + static_cast<std::size_t> (code_point >= 0x80) + static_cast<std::size_t> (code_point >= 0x800) +
+                  static_cast<std::size_t> (supplementary);
+      }
+    }
+    return result;
+  } else if constexpr (std::is_same_v<FromEncoding, char16_t>) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    auto const counts = details::count_utf16 (input.data (), input.data () + input.size ());
+    if constexpr (std::is_same_v<ToEncoding, char8>) {
+      return counts.utf8 - 2U * counts.pairs;
+    } else {
+      return input.size () - counts.pairs;
+    }
+  } else {
+    // Well-formed UTF-8 is counted in windows of up to 'window' code units. A window containing ill-formed input is
+    // passed to a transcoder one code unit at a time.
+    constexpr auto window = std::size_t{4096};
+    auto result = std::size_t{0};
+    auto out = details::count_iterator{&result};
+    transcoder<FromEncoding, ToEncoding> transcoder;
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    auto const* first = input.data ();
+    auto const* const last = first + input.size ();
+    while (first != last) {
+      if (!transcoder.partial ()) {
+        auto const* const window_last = first + std::min (static_cast<std::size_t> (last - first), window);
+        auto const* const valid_last = details::bulk_validate_utf8 (first, window_last);
+        if (valid_last == nullptr) {
+          for (; first != window_last; ++first) {
+            out = transcoder (*first, out);
+          }
+          continue;
+        }
+        if constexpr (std::is_same_v<ToEncoding, char8>) {
+          result += static_cast<std::size_t> (valid_last - first);
+        } else {
+          auto const counts = details::count_utf8 (first, valid_last);
+          // A four byte sequence is encoded as a UTF-16 surrogate pair.
+          result += std::is_same_v<ToEncoding, char16_t> ? counts.starts + counts.four_byte : counts.starts;
+        }
+        first = valid_last;
+        if (first == last) {
+          break;
+        }
+      }
+      out = transcoder (*first, out);
+      ++first;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    (void)transcoder.end_cp (out);
+    return result;
+  }
+}
+
+/// The line terminators recognized by a line_recorder.
+enum class line_endings {
+  lf,   ///< Each U+000A LINE FEED ends a line.
+  any,  ///< Each U+000D CARRIAGE RETURN, U+000A LINE FEED, or CR LF pair ends a line.
+};
+
+/// \brief Records the positions of the line terminators in a sequence of code units.
+///
+/// A line_recorder is passed the output of a transcoder in a series of blocks and writes the offset of the first code
+/// unit of each line terminator to an output iterator. Offsets are measured from the start of the first block. Blocks
+/// are scanned 16 bytes at a time using vector instructions, where available, so that the work is little more than
+/// that of reading output which is still in the cache. transcode_lines() calls a line_recorder as it transcodes.
+///
+/// \tparam OutputIterator  An output iterator to which the offsets (std::size_t) are written.
+template <typename OutputIterator> class line_recorder {
+public:
+  /// \param out  The output iterator to which the offsets of line terminators are written.
+  /// \param endings  The line terminators that are recognized.
+  explicit line_recorder (OutputIterator out, line_endings const endings = line_endings::lf)
+      : out_{std::move (out)}, endings_{endings} {}
+
+  /// Scans a block of code units for line terminators.
+  ///
+  /// \param block  The code units that follow those of the previous block.
+  template <ICUBABY_CONCEPT_UNICODE_CHAR_TYPE Encoding> void operator() (std::span<Encoding const> block) {
+    constexpr auto line_feed = std::uint_least32_t{0x0A};
+    constexpr auto carriage_return = std::uint_least32_t{0x0D};
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+    auto const* const first = block.data ();
+    auto const* const last = first + block.size ();
+    auto const* pos = first;
+    while (pos != last) {
+#if ICUBABY_HAVE_SSE2
+      // Skip 16 byte blocks that contain neither a LF nor (if necessary) a CR byte. The bytes are compared
+      // individually regardless of the code unit size: a match in one byte of a wider code unit only means that the
+      // block is checked one code unit at a time.
+      constexpr auto lanes = 16 / static_cast<std::ptrdiff_t> (sizeof (Encoding));
+      if (last - pos >= lanes) {
+        auto const bytes = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (pos));
+        auto matches = _mm_cmpeq_epi8 (bytes, _mm_set1_epi8 (static_cast<char> (line_feed)));
+        if (endings_ == line_endings::any) {
+          matches = _mm_or_si128 (matches, _mm_cmpeq_epi8 (bytes, _mm_set1_epi8 (static_cast<char> (carriage_return))));
+        }
+        if (_mm_movemask_epi8 (matches) == 0) {
+          pos += lanes;
+          after_cr_ = false;
+          continue;
+        }
+      }
+      auto const* const block_last = pos + std::min (last - pos, lanes);
+#else
+      auto const* const block_last = last;
+#endif  // ICUBABY_HAVE_SSE2
+      for (; pos != block_last; ++pos) {
+        auto const code_unit = static_cast<std::uint_least32_t> (*pos);
+        if (code_unit == carriage_return) {
+          if (endings_ == line_endings::any) {
+            *out_ = offset_ + static_cast<std::size_t> (pos - first);
+            ++out_;
+          }
+        } else if (code_unit == line_feed && !(after_cr_ && endings_ == line_endings::any)) {
+          *out_ = offset_ + static_cast<std::size_t> (pos - first);
+          ++out_;
+        }
+        after_cr_ = code_unit == carriage_return;
+      }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+    offset_ += block.size ();
+  }
+
+  /// \returns  The output iterator to which the offsets of line terminators are written.
+  [[nodiscard]] constexpr OutputIterator out () const { return out_; }
+  /// \returns  The number of code units that have been scanned.
+  [[nodiscard]] constexpr std::size_t offset () const noexcept { return offset_; }
+
+private:
+  /// The output iterator to which the offsets of line terminators are written.
+  OutputIterator out_;
+  /// The number of code units that have been scanned.
+  std::size_t offset_ = 0;
+  /// The line terminators that are recognized.
+  line_endings endings_;
+  /// True if the last code unit scanned was a carriage return.
+  bool after_cr_ = false;
+};
+
+/// \brief Transcodes a block of input and records the positions of the line terminators in the output.
+///
+/// The input is passed to the transcoder in slices so that the output of each slice is scanned by \p lines while it
+/// is still in the cache. The result is the same as that of calling transcoder.transcode(input, output). Any output
+/// produced by a subsequent call to the transcoder's end_cp() member should also be passed to \p lines.
+///
+/// \param transcoder  The transcoder which converts the input.
+/// \param input  A span of input code units.
+/// \param output  A span into which the output code units are written.
+/// \param lines  The line_recorder which is given the code units written to \p output.
+/// \returns  The number of code units consumed and produced. See transcoder<>::transcode().
+template <typename Transcoder, typename OutputIterator>
+ICUBABY_REQUIRES (is_transcoder<Transcoder>)
+transcode_result transcode_lines (Transcoder& transcoder, std::span<typename Transcoder::input_type const> input,
+                                  std::span<typename Transcoder::output_type> output,
+                                  line_recorder<OutputIterator>& lines) {
+  using output_type = typename Transcoder::output_type;
+  constexpr auto slice = std::size_t{4096};
+  transcode_result result;
+  while (result.consumed < input.size ()) {
+    auto const in = input.subspan (result.consumed, std::min (slice, input.size () - result.consumed));
+    auto const out = output.subspan (result.produced);
+    auto const res = transcoder.transcode (in, out);
+    lines (std::span<output_type const>{out.data (), res.produced});
+    result.consumed += res.consumed;
+    result.produced += res.produced;
+    if (res.consumed < in.size ()) {
+      break;
+    }
+  }
+  result.partial = transcoder.partial ();
+  return result;
+}
+
+namespace details {
+
+#if ICUBABY_HAVE_CONCEPTS
+/// True if Iterator references contiguous storage and may be passed to std::to_address().
+template <typename Iterator> inline constexpr bool is_contiguous_iterator = std::contiguous_iterator<Iterator>;
+#else
+/// True if Iterator is an iterator of std::basic_string<Value> or std::basic_string_view<Value>.
+template <typename Iterator, typename Value, typename = void> inline constexpr bool is_string_iterator = false;
+/// True if Iterator is an iterator of std::basic_string<Value> or std::basic_string_view<Value>.
+template <typename Iterator, typename Value>
+inline constexpr bool is_string_iterator<
+    Iterator, Value, std::enable_if_t<std::is_same_v<Value, char> || is_unicode_char_type_v<Value>>> =
+    std::is_same_v<Iterator, typename std::basic_string<Value>::iterator> ||
+    std::is_same_v<Iterator, typename std::basic_string<Value>::const_iterator> ||
+    std::is_same_v<Iterator, typename std::basic_string_view<Value>::const_iterator>;
+
+/// True if Iterator references contiguous storage and may be passed to std::to_address(). Without concepts, only
+/// pointers and the iterators of std::vector<>, std::basic_string<>, and std::basic_string_view<> are recognized.
+template <typename Iterator, typename Value = typename std::iterator_traits<Iterator>::value_type>
+inline constexpr bool is_contiguous_iterator =
+    std::is_pointer_v<Iterator> || std::is_same_v<Iterator, typename std::vector<Value>::iterator> ||
+    std::is_same_v<Iterator, typename std::vector<Value>::const_iterator> || is_string_iterator<Iterator, Value>;
+#endif  // ICUBABY_HAVE_CONCEPTS
+
+/// The type of the container to which a std::back_insert_iterator appends or void for other iterator types.
+template <typename OutputIterator> struct back_insert_container {
+  /// Void because OutputIterator is not a std::back_insert_iterator.
+  using type = void;
+};
+/// The type of the container to which a std::back_insert_iterator appends.
+template <typename Container> struct back_insert_container<std::back_insert_iterator<Container>> {
+  /// The type of the container.
+  using type = Container;
+};
+
+/// \brief Returns the container to which a std::back_insert_iterator appends.
+///
+/// The standard library stores the container in a protected member: this is the only function that reaches it.
+///
+/// \param iter  The iterator whose container is to be returned.
+/// \returns  The container to which \p iter appends.
+template <typename Container> Container& back_insert_target (std::back_insert_iterator<Container> const& iter) {
+  struct accessor : public std::back_insert_iterator<Container> {
+    explicit accessor (std::back_insert_iterator<Container> const& it) : std::back_insert_iterator<Container>{it} {}
+    [[nodiscard]] Container& get () const noexcept { return *this->container; }
+  };
+  return accessor{iter}.get ();
+}
+
+/// True if the container has a reserve() member function.
+template <typename Container, typename = void> inline constexpr bool has_reserve = false;
+/// True if the container has a reserve() member function.
+template <typename Container>
+inline constexpr bool
+    has_reserve<Container, std::void_t<decltype (std::declval<Container&> ().reserve (std::size_t{}))>> = true;
+
+/// True if the container has an insert() member function which appends a range given by a pair of pointers.
+template <typename Container, typename Value, typename = void> inline constexpr bool has_range_insert = false;
+/// True if the container has an insert() member function which appends a range given by a pair of pointers.
+template <typename Container, typename Value>
+inline constexpr bool has_range_insert<
+    Container, Value,
+    std::void_t<decltype (std::declval<Container&> ().insert (std::declval<Container&> ().end (),
+                                                              std::declval<Value const*> (),
+                                                              std::declval<Value const*> ()))>> = true;
+
+}  // end namespace details
+
+/// \brief Writes a sequence of code units to an icubaby::iterator.
+///
+/// The result is the same as that of std::copy(first, last, out) but where the input is a contiguous sequence of the
+/// transcoder's input type, it is converted in blocks using the transcoder's transcode() member function rather than
+/// one code unit at a time. This allows the transcoder's vectorized kernels to be used. If the underlying output
+/// iterator is a std::back_insert_iterator for a container with a reserve() member function (such as std::vector or
+/// std::basic_string), the container's capacity is reserved for the entire output before conversion starts. If the
+/// container can insert a range given by a pair of pointers, each block of output is appended with a single call.
+/// As with std::copy, the transcoder's end_cp() member function is not called.
+///
+/// In C++ 20, any std::contiguous_iterator is recognized as contiguous input. Where concepts are not available, only
+/// pointers and the iterators of std::vector, std::basic_string, and std::basic_string_view are.
+///
+/// \param first  The start of the input code units.
+/// \param last  The end of the input code units.
+/// \param out  The icubaby::iterator to which the code units are written.
+/// \returns  An icubaby::iterator which references the same transcoder as \p out and whose underlying output iterator
+///   is one past the last code unit written.
+template <typename InputIterator, typename Transcoder, typename OutputIterator>
+iterator<Transcoder, OutputIterator> copy (InputIterator first, InputIterator last,
+                                           iterator<Transcoder, OutputIterator> out) {
+  using input_type = typename Transcoder::input_type;
+  using output_type = typename Transcoder::output_type;
+  if constexpr (details::is_contiguous_iterator<InputIterator> &&
+                std::is_same_v<typename std::iterator_traits<InputIterator>::value_type, input_type>) {
+    using container_type = typename details::back_insert_container<OutputIterator>::type;
+    auto* const transcoder = out.transcoder ();
+    auto dest = out.base ();
+    auto input = std::span<input_type const>{std::to_address (first), static_cast<std::size_t> (last - first)};
+
+    if constexpr (details::has_reserve<container_type> && is_unicode_char_type_v<input_type>) {
+      auto& container = details::back_insert_target (dest);
+      container.reserve (container.size () + output_length<input_type, output_type> (input));
+    }
+    std::array<output_type, 1024> buffer;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+    while (!input.empty ()) {
+      auto const res = transcoder->transcode (input, std::span{buffer});
+      assert (res.consumed > 0 && "transcode() must make progress");
+      auto const* const produced = buffer.data ();
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      auto const* const produced_end = produced + res.produced;
+      if constexpr (details::has_range_insert<container_type, output_type>) {
+        auto& container = details::back_insert_target (dest);
+        container.insert (container.end (), produced, produced_end);
+      } else {
+        dest = std::copy (produced, produced_end, dest);
+      }
+      input = input.subspan (res.consumed);
+    }
+    return iterator<Transcoder, OutputIterator>{transcoder, dest};
+  } else {
+    return std::copy (first, last, out);
+  }
+}
+
+/// The reason that transcode_chunk() returned.
+enum class chunk_status {
+  input_exhausted,  ///< All of the input was consumed.
+  output_full,      ///< The output did not have room for the code units that the next input code unit would produce.
+  ill_formed,       ///< An ill-formed sequence was consumed. Unless the transcoder's error policy is skip or stop,
+                    ///< its output ends with the REPLACEMENT CHARACTER.
+};
+
+/// The result of a call to transcode_chunk().
+struct chunk_result {
+  /// The reason that transcode_chunk() returned.
+  chunk_status status = chunk_status::input_exhausted;
+  /// The number of input code units consumed.
+  std::size_t consumed = 0;
+  /// The number of code units written to the output.
+  std::size_t produced = 0;
+  /// True if the transcoder was left holding a partial code point which will be completed by the input passed to a
+  /// subsequent call.
+  bool partial = false;
+};
+
+/// \brief Converts as much of a chunk of input as fits in a fixed-size output buffer.
+///
+/// The input is converted using the transcoder's transcode() member function until the input is exhausted, the output
+/// is full, or ill-formed input is found. In each case, conversion may be resumed by a later call passing the
+/// unconsumed input and a new output buffer. A partial code point at the end of one chunk of input is held by the
+/// transcoder and completed by the next. Once all of the input has been supplied, the transcoder's end_cp() member
+/// function must be called as usual.
+///
+/// Each call stops after the first ill-formed sequence that it consumes, so every ill-formed sequence in a stream is
+/// reported in turn. The transcoder's well_formed() state continues to reflect all of the input that it has seen.
+///
+/// Input is passed to transcode() in slices of at most 256 code units. A slice that contains ill-formed input is
+/// converted again one code unit at a time to find the end of the ill-formed sequence: for this, the transcoder is
+/// copied at the start of each slice. A byte transcoder constructed with detect_encoding guesses the input encoding
+/// from the first slice that it is given unless that slice is ill-formed, in which case the guess is made from its
+/// first code unit.
+///
+/// A transcoder whose error policy is error_policy::stop is not restarted by this function. Once it has stopped, the
+/// input is discarded as it would be by transcode() and the status is chunk_status::input_exhausted.
+///
+/// \param transcoder  The transcoder which converts the input.
+/// \param input  A span of input code units.
+/// \param output  A span into which the output code units are written.
+/// \returns  The reason that conversion stopped together with the number of code units consumed and produced.
+template <typename Transcoder>
+ICUBABY_REQUIRES (is_transcoder<Transcoder>)
+chunk_result transcode_chunk (Transcoder& transcoder, std::span<typename Transcoder::input_type const> input,
+                              std::span<typename Transcoder::output_type> output)
+    noexcept (details::policy_of<Transcoder> != error_policy::exception) {
+  // Input is passed to transcode() in slices so that, if one contains ill-formed input, only that slice needs to be
+  // converted one code unit at a time to find the end of the ill-formed sequence.
+  constexpr auto slice = std::size_t{256};
+  // The "well formed" state of a transcoder with the stop policy decides whether it discards its input, so it must
+  // not be reset.
+  constexpr auto stop = details::policy_of<Transcoder> == error_policy::stop;
+  auto const well_formed = transcoder.well_formed ();
+  chunk_result result;
+  if constexpr (stop) {
+    if (!well_formed) {
+      auto const res = transcoder.transcode (input, output);
+      result.consumed = res.consumed;
+      result.produced = res.produced;
+      result.partial = res.partial;
+      return result;
+    }
+  } else {
+    transcoder.set_well_formed (true);
+  }
+  while (result.consumed < input.size ()) {
+    auto const in = input.subspan (result.consumed, std::min (slice, input.size () - result.consumed));
+    auto const before = transcoder;
+    auto const res = transcoder.transcode (in, output.subspan (result.produced));
+    if (!transcoder.well_formed ()) {
+      // Convert the slice again one code unit at a time, stopping at the unit that completes the ill-formed sequence.
+      // This rewrites the same output. The output passed to transcode() is bounded so that this cannot write beyond
+      // the end of the buffer.
+      transcoder = before;
+      for (auto index = std::size_t{0}; index < in.size (); ++index) {
+        auto const step = transcoder.transcode (in.subspan (index, 1), output.subspan (result.produced));
+        if (step.consumed == 0) {
+          result.status = chunk_status::output_full;
+          break;
+        }
+        ++result.consumed;
+        result.produced += step.produced;
+        if (!transcoder.well_formed ()) {
+          result.status = chunk_status::ill_formed;
+          break;
+        }
+      }
+      if (result.status != chunk_status::input_exhausted) {
+        break;
+      }
+      continue;
+    }
+    result.consumed += res.consumed;
+    result.produced += res.produced;
+    if (res.consumed < in.size ()) {
+      result.status = chunk_status::output_full;
+      break;
+    }
+  }
+  if constexpr (!stop) {
+    transcoder.set_well_formed (well_formed && result.status != chunk_status::ill_formed);
+  }
+  result.partial = transcoder.partial ();
+  return result;
+}
+
+/// \brief Transcodes a block of input and records the position of each ill-formed sequence that it contains.
+///
+/// The result is the same as that of calling transcoder.transcode(input, output). Input is passed to transcode() in
+/// slices of at most 256 code units. A slice that contains ill-formed input is converted again one code unit at a
+/// time to find where each error lies: well-formed input costs no more than a call to transcode(). Once all of the
+/// input has been supplied, call \p errors.end_cp() rather than the transcoder's own end_cp() member function so that
+/// input which ends with a partial code point is also recorded. As for transcode_chunk(), a byte transcoder
+/// constructed with detect_encoding guesses the input encoding from its first code unit if the first slice is
+/// ill-formed.
+///
+/// A transcoder whose error policy is error_policy::stop is not restarted after an error. As for transcode(), the
+/// function returns immediately after the first ill-formed sequence, which is recorded, and subsequent input is
+/// discarded without being recorded.
+///
+/// \param transcoder  The transcoder which converts the input.
+/// \param input  A span of input code units.
+/// \param output  A span into which the output code units are written.
+/// \param errors  The error_recorder to which ill-formed sequences are reported.
+/// \returns  The number of code units consumed and produced. See transcoder<>::transcode().
+template <typename Transcoder>
+ICUBABY_REQUIRES (is_transcoder<Transcoder>)
+transcode_result transcode_errors (Transcoder& transcoder, std::span<typename Transcoder::input_type const> input,
+                                   std::span<typename Transcoder::output_type> output,
+                                   error_recorder& errors)
+    noexcept (details::policy_of<Transcoder> != error_policy::exception) {
+  constexpr auto slice = std::size_t{256};
+  constexpr auto stop = details::policy_of<Transcoder> == error_policy::stop;
+  auto const well_formed = transcoder.well_formed ();
+  auto const initial_count = errors.count ();
+  transcode_result result;
+  if constexpr (stop) {
+    if (!well_formed) {
+      result = transcoder.transcode (input, output);
+      errors.advance (result.consumed);
+      return result;
+    }
+  } else {
+    transcoder.set_well_formed (true);
+  }
+  auto done = false;
+  while (!done && result.consumed < input.size ()) {
+    auto const in = input.subspan (result.consumed, std::min (slice, input.size () - result.consumed));
+    auto const before = transcoder;
+    auto const res = transcoder.transcode (in, output.subspan (result.produced));
+    if (transcoder.well_formed ()) {
+      result.consumed += res.consumed;
+      result.produced += res.produced;
+      done = res.consumed < in.size ();
+      continue;
+    }
+    // Convert the slice again one code unit at a time, resetting the transcoder's "well formed" state after each
+    // ill-formed sequence. This rewrites the same output.
+    transcoder = before;
+    for (auto index = std::size_t{0}; index < in.size (); ++index) {
+      auto const step = transcoder.transcode (in.subspan (index, 1), output.subspan (result.produced));
+      if (step.consumed == 0) {
+        done = true;
+        break;
+      }
+      if (!transcoder.well_formed ()) {
+        errors.record (result.consumed);
+        if constexpr (stop) {
+          done = true;
+        } else {
+          transcoder.set_well_formed (true);
+        }
+      }
+      ++result.consumed;
+      result.produced += step.produced;
+      if (done) {
+        break;
+      }
+    }
+  }
+  errors.advance (result.consumed);
+  if constexpr (!stop) {
+    transcoder.set_well_formed (well_formed && errors.count () == initial_count);
+  }
+  result.partial = transcoder.partial ();
+  return result;
+}
+#endif  // ICUBABY_HAVE_SPAN
+
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
 
-/// A shorter name for the UTF-32 to UTF-8 transcoder.
-using t32_8 = transcoder<char32_t, char8>;
-/// A shorter name for the UTF-32 to UTF-16 transcoder.
-using t32_16 = transcoder<char32_t, char16_t>;
-/// \brief A shorter name for the UTF-32 to UTF-32 transcoder.
-/// This, assuming well-formed input, represents no change.
-using t32_32 = transcoder<char32_t, char32_t>;
+#if ICUBABY_HAVE_SPAN
+namespace details {
 
-/// A shorter name for the UTF-8 "byte transcoder" which consumes bytes in unknown input encoding and produces UTF-8.
-using tx_8 = transcoder<std::byte, char8>;
-/// A shorter name for the UTF-16 "byte transcoder" which consumes bytes in unknown input encoding and produces UTF-16.
-using tx_16 = transcoder<std::byte, char16_t>;
-/// A shorter name for the UTF-32 "byte transcoder" which consumes bytes in unknown input encoding and produces UTF-32.
-using tx_32 = transcoder<std::byte, char32_t>;
+/// True if a view's elements can be passed directly to the transcode() member function of a transcoder whose input
+/// is FromEncoding: that is, the view is a contiguous range of FromEncoding with a sized sentinel.
+///
+/// \tparam FromEncoding  The input encoding.
+/// \tparam View  The type of the view.
+template <typename FromEncoding, typename View>
+inline constexpr bool is_bulk_input =
+    std::ranges::contiguous_range<View const> &&
+    std::sized_sentinel_for<std::ranges::sentinel_t<View const>, std::ranges::iterator_t<View const>> &&
+    std::is_same_v<std::ranges::range_value_t<View const>, FromEncoding>;
+
+/// \brief Converts contiguous input using a transcoder's transcode() member function.
+///
+/// Input is consumed until some output has been produced or the input is exhausted. Once the input is exhausted, the
+/// transcoder's end_cp() member function is called.
+///
+/// \param transcoder  The transcoder used to perform the conversion.
+/// \param first  The start of the input. On return, references the first code unit that was not consumed.
+/// \param last  The end of the input.
+/// \param out  The output buffer. There must be room for \p block_size code units followed by the output of end_cp().
+/// \param block_size  The maximum number of code units to be produced by transcode().
+/// \returns  The number of code units written to \p out.
+template <typename Transcoder, std::contiguous_iterator Iterator, std::sized_sentinel_for<Iterator> Sentinel>
+std::size_t transcode_contiguous (Transcoder& transcoder, Iterator& first, Sentinel const last,
+                                  typename Transcoder::output_type* const out, std::size_t const block_size) noexcept {
+  auto produced = std::size_t{0};
+  while (produced == 0 && first != last) {
+    auto const res = transcoder.transcode (std::span{std::to_address (first), static_cast<std::size_t> (last - first)},
+                                           std::span{out, block_size});
+    assert (res.consumed > 0 && "transcode() must make progress");
+    first += static_cast<std::iter_difference_t<Iterator>> (res.consumed);
+    produced = res.produced;
+  }
+  if (first == last) {
+    // We've consumed the entire input so tell the transcoder and get any final output.
+    auto* const tail = out + produced;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    produced += static_cast<std::size_t> (transcoder.end_cp (tail) - tail);
+  }
+  return produced;
+}
 
-#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+}  // end namespace details
+#endif  // ICUBABY_HAVE_SPAN
 
 /// \brief icubaby C++ 20 ranges support types.
 namespace ranges {
@@ -2166,6 +5795,23 @@ public:
   /// \returns True if the input processed was well formed.
   [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
 
+#if ICUBABY_HAVE_SPAN
+  /// \brief Returns the number of code units that the view will produce.
+  ///
+  /// Available when the underlying view is a contiguous range of Unicode code units with a sized sentinel. This
+  /// allows a container to reserve its storage once when the view is materialized. The value is computed by
+  /// output_length() on each call, which is a pass over the whole of the underlying view. It is therefore not named
+  /// size(): that would make the view a std::ranges::sized_range and adaptors such as std::views::take would call it.
+  ///
+  /// \returns The number of code units produced by converting the underlying view.
+  [[nodiscard]] std::size_t output_size () const noexcept
+    requires (icubaby::details::is_bulk_input<FromEncoding, View> && is_unicode_char_type_v<FromEncoding>)
+  {
+    return output_length<FromEncoding, ToEncoding> (
+        std::span<FromEncoding const>{std::ranges::data (base_), std::ranges::size (base_)});
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
 private:
   /// The underlying view from which input is drawn.
   ICUBABY_NO_UNIQUE_ADDRESS View base_ = View ();
@@ -2192,11 +5838,18 @@ template <> inline constexpr auto max_output_bytes<char16_t, char32_t> = std::si
 template <typename FromEncoding, typename ToEncoding, std::ranges::input_range View>
   requires std::ranges::view<View>
 class transcode_view<FromEncoding, ToEncoding, View>::iterator {
+  /// True if the iterator can be decremented. This requires that the underlying view is bidirectional and that its
+  /// code units can be examined to find the start of the preceding code point.
+  static constexpr bool bidirectional =
+      std::ranges::bidirectional_range<View const> && is_unicode_char_type_v<FromEncoding>;
+
 public:
-  /// Defines this class as fulfilling the requirements of a forward iterator.
-  using iterator_category = std::forward_iterator_tag;
-  /// Define this class as following the forward iterator concept.
-  using iterator_concept = std::forward_iterator_tag;
+  /// Dereferencing the iterator yields a value rather than a reference so it is a C++17 input iterator.
+  using iterator_category = std::input_iterator_tag;
+  /// Define this class as following the bidirectional iterator concept when the underlying view is bidirectional and
+  /// the forward iterator concept otherwise.
+  using iterator_concept =
+      std::conditional_t<bidirectional, std::bidirectional_iterator_tag, std::forward_iterator_tag>;
 
   /// The type produced by this iterator.
   using value_type = ToEncoding;
@@ -2219,8 +5872,9 @@ public:
   /// \brief Returns the underlying view
   constexpr std::ranges::iterator_t<View> base () && { return std::move (current_); }
 
-  constexpr value_type const& operator* () const { return state_.front (); }
-  constexpr std::ranges::iterator_t<View> operator->() const { return state_.front (); }
+  /// The code unit is returned by value because it is held by the iterator: a reference would not survive the
+  /// temporary iterator used by std::reverse_iterator.
+  constexpr value_type operator* () const { return state_.front (); }
 
   constexpr iterator& operator++ () {
     state_.advance ();
@@ -2237,18 +5891,57 @@ public:
     return result;
   }
 
+  /// \brief Moves to the previous code unit.
+  ///
+  /// Once the buffered output is exhausted, the code units preceding the current position in the underlying view
+  /// are searched for the start of the previous code point which is then decoded. For well-formed input, the code
+  /// units visited are the same as those produced by incrementing an iterator. The sequence of code units produced
+  /// for ill-formed input may differ because the transcoder's treatment of an ill-formed sequence depends on the
+  /// code units that precede it.
+  constexpr iterator& operator-- () requires bidirectional {
+    if (!state_.retreat ()) {
+      // We're at the start of the buffered output code units. Decode the preceding code point.
+      current_ = state_.fill_previous (parent_, current_);
+    }
+    return *this;
+  }
+  constexpr iterator operator-- (int) requires bidirectional {
+    auto result = *this;
+    --*this;
+    return result;
+  }
+
   friend constexpr bool operator== (iterator const& lhs, iterator const& rhs)
     requires std::equality_comparable<std::ranges::iterator_t<View>>
   {
-    return lhs.current_ == rhs.current_ && lhs.parent_ == rhs.parent_;
+    if (lhs.parent_ != rhs.parent_) {
+      return false;
+    }
+    if (lhs.current_ == rhs.current_) {
+      // Iterators referencing the same buffered block of output are distinguished by their position within it.
+      return lhs.state_.index () == rhs.state_.index ();
+    }
+    if constexpr (bidirectional) {
+      // An iterator that was incremented to a code unit may hold it within a block of output whereas one that was
+      // decremented to it holds a single code point. Compare the input positions from which they were produced.
+      if (!lhs.state_.empty () && !rhs.state_.empty ()) {
+        return lhs.state_.position (lhs.parent_, lhs.current_) == rhs.state_.position (rhs.parent_, rhs.current_);
+      }
+    }
+    return false;
   }
 
 private:
   /// \brief The state class is responsible for transforming the input values to output code units.
   ///
-  /// It maintains a code point's worth of output code units in its internal buffer. These may be accessed by the
-  /// owning iterator using the front() and advance() member functions. Once the buffer is empty, it is refilled using
-  /// the fill() function.
+  /// It maintains at least a code point's worth of output code units in its internal buffer. These may be accessed by
+  /// the owning iterator using the front() and advance() member functions. Once the buffer is empty, it is refilled
+  /// using the fill() function.
+  ///
+  /// When the underlying view is a contiguous range of FromEncoding code units with a sized sentinel, fill()
+  /// converts up to batch_size output code units at a time using the transcoder's transcode() member function. This
+  /// allows the transcoder's vectorized kernels to be used.
+  /// Otherwise, fill() produces a single code point at a time.
   class state {
   public:
     /// \brief Initializes the state and primes the internal buffer with an initial code-point read from the input.
@@ -2259,23 +5952,47 @@ private:
 
     /// Returns true if the output buffer is empty and false otherwise.
     [[nodiscard]] constexpr bool empty () const noexcept {
-      assert (first_ <= last_ && last_ <= out_.size () && "first_ and last_ must be valid indexes in the out_ array");
-      return first_ == last_;
+      assert (range_.first <= range_.last && range_.last <= out_.size () &&
+              "range_.first and range_.last must be valid indexes in the out_ array");
+      return range_.first == range_.last;
     }
 
     /// Returns the first element from the range of code units forming the current code point.
     [[nodiscard]] constexpr auto& front () const noexcept {
       assert (!this->empty () && "The out_ array must not be empty when front() is called");
-      return out_[first_];
+      return out_[range_.first];
     }
 
     /// Removes the first element from the range of code units forming the current code point.
     constexpr void advance () noexcept {
       assert (!this->empty () && "The out_ array must not be empty when advance() is called");
-      ++first_;
+      ++range_.first;
+    }
+
+    /// Moves to the previous element of the buffered output.
+    ///
+    /// \returns False if the start of the buffered output has been reached, true otherwise.
+    constexpr bool retreat () noexcept {
+      if (range_.first == 0U) {
+        return false;
+      }
+      --range_.first;
+      return true;
     }
 
-    /// \brief Consumes enough code-units from the base iterator to form a single code-point.
+    /// Returns the index of the next code unit to be produced within the buffered output.
+    [[nodiscard]] constexpr std::size_t index () const noexcept { return range_.first; }
+
+    /// \brief Finds the input position from which the current code unit was produced.
+    ///
+    /// \param parent  The view from which input values are consumed.
+    /// \param current  The position in the underlying view from which the buffered output was produced.
+    /// \returns  The position of the start of the code point whose output contains the current code unit and the
+    ///   index of the code unit within that output.
+    [[nodiscard]] constexpr std::pair<std::ranges::iterator_t<View const>, std::size_t> position (
+        transcode_view const* parent, std::ranges::iterator_t<View const> current) const;
+
+    /// \brief Consumes enough code-units from the base iterator to form at least a single code-point.
     ///
     /// The resulting code-units in the output encoding can be sequentially accessed using the front() and
     /// advance() methods.
@@ -2284,10 +6001,72 @@ private:
     /// \returns The updated base iterator.
     constexpr std::ranges::iterator_t<View const> fill (transcode_view const* parent);
 
+    /// \brief Decodes the code point which ends at a given position in the underlying view.
+    ///
+    /// On return, front() yields the last of the code point's output code units.
+    ///
+    /// \param parent  The view from which input values are consumed.
+    /// \param last  The position following the code point. Must not be the start of the underlying view.
+    /// \returns The position of the start of the code point.
+    constexpr std::ranges::iterator_t<View const> fill_previous (transcode_view const* parent,
+                                                                std::ranges::iterator_t<View const> const& last);
+
   private:
-    /// The type of the output buffer. This is sized so that it allows for the largest number of bytes that the
-    /// transcoder can produce.
-    using out_type = std::array<ToEncoding, max_output_bytes<FromEncoding, ToEncoding>>;
+    /// \brief Passes a code point's worth of input to a transcoder.
+    ///
+    /// Code units are consumed until output has been produced and the transcoder is not part way through a code
+    /// point or until the length of the longest code point in the input encoding has been consumed. If the input
+    /// is exhausted, the transcoder's end_cp() member function is called.
+    ///
+    /// \param decoder  The transcoder used to perform the conversion.
+    /// \param pos  The position of the first code unit to be consumed. On return, references the first code unit
+    ///   that was not consumed.
+    /// \param end  The end of the input.
+    /// \param out  The output iterator to which code units are written.
+    /// \param produced  True if output has already been produced for this code point.
+    /// \returns The output iterator.
+    template <typename OutputIterator>
+    static constexpr OutputIterator segment (transcoder<FromEncoding, ToEncoding>& decoder,
+                                             std::ranges::iterator_t<View const>& pos,
+                                             std::ranges::sentinel_t<View const> const& end, OutputIterator out,
+                                             bool produced) {
+      for (auto count = std::size_t{0}; pos != end && count < longest_sequence_v<FromEncoding> &&
+                                        (!produced || decoder.partial ());
+           ++count) {
+        auto const next = decoder (*pos, out);
+        produced = produced || next != out;
+        out = next;
+        ++pos;
+      }
+      if (pos == end) {
+        out = decoder.end_cp (out);
+      }
+      return out;
+    }
+
+#if ICUBABY_HAVE_SPAN
+    /// True if fill() can pass blocks of input directly to the transcoder's transcode() member function.
+    static constexpr bool bulk = icubaby::details::is_bulk_input<FromEncoding, View>;
+#else
+    /// True if fill() can pass blocks of input directly to the transcoder's transcode() member function.
+    static constexpr bool bulk = false;
+#endif  // ICUBABY_HAVE_SPAN
+    /// The maximum number of code units produced by a call to the transcoder's transcode() member function.
+    static constexpr auto batch_size = bulk ? std::size_t{256} : std::size_t{0};
+
+    /// The maximum number of code units produced by segment().
+    static constexpr auto segment_size = [] {
+      if constexpr (bidirectional) {
+        return (longest_sequence_v<FromEncoding> + 1U) * max_output_bytes<FromEncoding, ToEncoding>;
+      } else {
+        return max_output_bytes<FromEncoding, ToEncoding>;
+      }
+    }();
+
+    /// The type of the output buffer. This is sized so that it allows for a batch of output together with the largest
+    /// number of bytes that the transcoder can produce. A bidirectional iterator completes the final code point of
+    /// each batch so that its buffered output always starts at a code point boundary.
+    using out_type = std::array<ToEncoding, batch_size + segment_size>;
     /// Output buffer iterator type.
     using iterator = typename out_type::iterator;
 
@@ -2298,20 +6077,40 @@ private:
     /// The transcoder used to convert a series of code-units in the source encoding to the destination encoding.
     transcoder<FromEncoding, ToEncoding> transcoder_;
 
-    /// The number of bits allocated for the first_ and last_ members.
+    /// The number of bits allocated for the first and last members of packed_range.
     /// Must be enough to represent all valid indexes in out_type.
-    static constexpr auto valid_range_bits = 4U;
-    static_assert (out_type{}.size () < std::size_t{1} << valid_range_bits,
+    static constexpr auto valid_range_bits = bidirectional ? 5U : 4U;
+    /// The type of the first and last members of the valid range.
+    using index_type = std::conditional_t<bulk, std::uint_least16_t, std::uint_least8_t>;
+    static_assert (bulk || out_type{}.size () < std::size_t{1} << valid_range_bits,
                    "There are not sufficient bits to represent indexes in out_type");
-
-    /// \brief The index of the start of the valid range of code units in the state::out_ container.
-    ///
-    /// Together with the last_ field, determines the code-units to be produced when the view is dereferenced.
-    std::uint_least8_t first_ : valid_range_bits = 0;
-    /// \brief The index one beyond the end of the the valid range of code units in the state::out_ container.
+    static_assert (out_type{}.size () <= std::numeric_limits<index_type>::max (),
+                   "index_type cannot represent all indexes in out_type");
+
+    /// The valid range of code units in the out_ container packed into bit-fields. This is used when fill()
+    /// produces a single code point at a time: the buffer is small and the size of the iterator matters more.
+    struct packed_range {
+      /// The index of the start of the valid range of code units in the state::out_ container.
+      index_type first : valid_range_bits = 0;
+      /// The index one beyond the end of the the valid range of code units in the state::out_ container.
+      index_type last : valid_range_bits = 0;
+      /// True if the buffered output was produced from a single code point.
+      bool single : 1 = true;
+    };
+    /// The valid range of code units in the out_ container. This is used when fill() converts batches of input so
+    /// that incrementing and dereferencing an iterator do not have to mask and merge bit-fields.
+    struct plain_range {
+      /// The index of the start of the valid range of code units in the state::out_ container.
+      index_type first = 0;
+      /// The index one beyond the end of the the valid range of code units in the state::out_ container.
+      index_type last = 0;
+      /// True if the buffered output was produced from a single code point.
+      bool single = true;
+    };
+    /// \brief The valid range of code units in the state::out_ container.
     ///
-    /// Together with the last_ field, determines the code-units to be produced when the view is dereferenced.
-    std::uint_least8_t last_ : valid_range_bits = 0;
+    /// Its first and last members determine the code-units to be produced when the view is dereferenced.
+    std::conditional_t<bulk, plain_range, packed_range> range_{};
   };
   std::ranges::iterator_t<View const> current_{};
   transcode_view const* parent_ = nullptr;
@@ -2325,28 +6124,134 @@ constexpr std::ranges::iterator_t<View const> transcode_view<FromEncoding, ToEnc
   auto result = next_;
   assert (this->empty () && "out_ was not empty when fill called");
 
+#if ICUBABY_HAVE_SPAN
+  if constexpr (bulk) {
+    if (!std::is_constant_evaluated ()) {
+      auto const input_end = std::ranges::end (parent->base_);
+      auto produced = icubaby::details::transcode_contiguous (transcoder_, next_, input_end, out_.data (), batch_size);
+      if constexpr (bidirectional) {
+        if (next_ != input_end) {
+          // Complete the final code point so that the next block starts at a code point boundary.
+          auto* const tail = out_.data () + produced;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+          produced += static_cast<std::size_t> (segment (transcoder_, next_, input_end, tail, true) - tail);
+        }
+      }
+      assert (produced <= out_.size () && "out_ buffer overflow!");
+      if (!transcoder_.well_formed ()) {
+        parent->well_formed_ = false;
+      }
+      range_.first = index_type{0};
+      range_.last = static_cast<index_type> (produced);
+      range_.single = false;
+      return result;
+    }
+  }
+#endif  // ICUBABY_HAVE_SPAN
+
   auto const out_begin = out_.begin ();
   auto out_it = out_begin;
   auto const input_end = std::ranges::end (parent->base_);
-  // Loop until we've produced a code-point's worth of code-units in the out container, or we've run out of input.
-  while (out_it == out_begin && next_ != input_end) {
-    out_it = transcoder_ (*next_, out_it);
-    assert (out_it >= out_begin && out_it <= out_.end () && "out_ buffer overflow!");
-    ++next_;
-  }
-  if (next_ == input_end) {
-    // We've consumed the entire input so tell the transcoder and get any final output.
-    out_it = transcoder_.end_cp (out_it);
+  if constexpr (bidirectional) {
+    // Produce a complete code point so that the next fill starts at a code point boundary.
+    out_it = segment (transcoder_, next_, input_end, out_it, false);
+  } else {
+    // Loop until we've produced a code-point's worth of code-units in the out container, or we've run out of input.
+    while (out_it == out_begin && next_ != input_end) {
+      out_it = transcoder_ (*next_, out_it);
+      assert (out_it >= out_begin && out_it <= out_.end () && "out_ buffer overflow!");
+      ++next_;
+    }
+    if (next_ == input_end) {
+      // We've consumed the entire input so tell the transcoder and get any final output.
+      out_it = transcoder_.end_cp (out_it);
+    }
   }
   assert (out_it >= out_begin && out_it <= out_.end () && "out_ buffer overflow!");
   if (!transcoder_.well_formed ()) {
     parent->well_formed_ = false;
   }
-  first_ = std::uint_least8_t{0};
-  last_ = static_cast<std::uint_least8_t> (out_it - out_begin);
+  range_.first = index_type{0};
+  range_.last = static_cast<index_type> (out_it - out_begin);
+  range_.single = true;
   return result;
 }
 
+template <typename FromEncoding, typename ToEncoding, std::ranges::input_range View>
+  requires std::ranges::view<View>
+constexpr std::ranges::iterator_t<View const>
+transcode_view<FromEncoding, ToEncoding, View>::iterator::state::fill_previous (
+    transcode_view const* parent, std::ranges::iterator_t<View const> const& last) {
+  auto const input_begin = std::ranges::begin (parent->base_);
+  auto const input_end = std::ranges::end (parent->base_);
+  assert (last != input_begin && "fill_previous() called at the start of the input");
+
+  // Search backwards for the start of the code point that ends at 'last'. No code point is longer than
+  // longest_sequence_v<FromEncoding> code units.
+  auto start = last;
+  auto length = std::size_t{0};
+  do {
+    --start;
+    ++length;
+  } while (start != input_begin && length < longest_sequence_v<FromEncoding> &&
+           !icubaby::is_code_point_start (*start));
+
+  // Decode forward from the start. For ill-formed input, this may produce more than one code point in which case the
+  // last of them is used.
+  transcoder_ = transcoder<FromEncoding, ToEncoding>{};
+  auto out_it = out_.begin ();
+  auto pos = start;
+  auto remaining = length;
+  while (remaining > 0U) {
+    start = pos;
+    out_it = segment (transcoder_, pos, input_end, out_.begin (), false);
+    auto const consumed = static_cast<std::size_t> (std::ranges::distance (start, pos));
+    if (consumed > remaining) {
+      // The code units before 'last' are not a complete code point. Decode just the one which precedes it.
+      start = std::ranges::prev (last);
+      transcoder_ = transcoder<FromEncoding, ToEncoding>{};
+      out_it = transcoder_.end_cp (transcoder_ (*start, out_.begin ()));
+      break;
+    }
+    remaining -= consumed;
+  }
+  assert (out_it > out_.begin () && out_it <= out_.end () && "out_ buffer overflow!");
+  if (!transcoder_.well_formed ()) {
+    parent->well_formed_ = false;
+  }
+  // The next fill starts at the code point boundary 'last'.
+  transcoder_ = transcoder<FromEncoding, ToEncoding>{};
+  next_ = last;
+  range_.last = static_cast<index_type> (out_it - out_.begin ());
+  range_.first = static_cast<index_type> (range_.last - 1U);
+  range_.single = true;
+  return start;
+}
+
+template <typename FromEncoding, typename ToEncoding, std::ranges::input_range View>
+  requires std::ranges::view<View>
+constexpr std::pair<std::ranges::iterator_t<View const>, std::size_t>
+transcode_view<FromEncoding, ToEncoding, View>::iterator::state::position (
+    transcode_view const* parent, std::ranges::iterator_t<View const> current) const {
+  auto index = static_cast<std::size_t> (range_.first);
+  if (range_.single || index == 0U) {
+    return {current, index};
+  }
+  // Decode the input from which the buffer was filled one code point at a time until we reach the one which produced
+  // the current code unit.
+  auto const input_end = std::ranges::end (parent->base_);
+  auto decoder = transcoder<FromEncoding, ToEncoding>{};
+  std::array<ToEncoding, segment_size> scratch{};
+  for (;;) {
+    auto const start = current;
+    auto const produced =
+        static_cast<std::size_t> (segment (decoder, current, input_end, scratch.begin (), false) - scratch.begin ());
+    if (index < produced || current == input_end) {
+      return {start, index};
+    }
+    index -= produced;
+  }
+}
+
 /// \brief The sentinel type of transcode_view when the underlying view is not a common_range.
 template <typename FromEncoding, typename ToEncoding, std::ranges::input_range View>
   requires std::ranges::view<View>
@@ -2364,6 +6269,190 @@ private:
   std::ranges::sentinel_t<View> end_{};  ///< The underlying view's end sentinel
 };
 
+#if ICUBABY_HAVE_SPAN
+/// \brief A range adaptor for lazily converting between Unicode encodings in blocks.
+///
+/// A range adaptor that represents view of an underlying sequence consisting of Unicode code points in the encoding
+/// given by FromEncoding. Each element of the view is a non-empty span of the equivalent code units in the encoding
+/// given by ToEncoding. Concatenating the spans produces the same output as transcode_view.
+///
+/// A span references a buffer owned by the iterator from which it was obtained and is valid until that iterator is
+/// incremented or destroyed.
+///
+/// \tparam FromEncoding  The encoding used by the underlying sequence.
+/// \tparam ToEncoding  The encoding that will be produced by this range adaptor.
+/// \tparam View  The type of the underlying view.
+template <typename FromEncoding, typename ToEncoding, std::ranges::input_range View>
+  requires std::ranges::view<View>
+class transcode_chunks_view
+    : public std::ranges::view_interface<transcode_chunks_view<FromEncoding, ToEncoding, View>> {
+public:
+  class iterator;
+  class sentinel;
+
+  /// The maximum number of code units in each block of output.
+  static constexpr auto chunk_size = std::size_t{256};
+
+  /// \brief Default initializes the base view of a new transcode_chunks_view instance.
+  transcode_chunks_view () requires std::default_initializable<View> = default;
+  /// \brief Initializes the base view of a new transcode_chunks_view instance.
+  constexpr explicit transcode_chunks_view (View base) : base_ (std::move (base)) {}
+
+  /// \returns The base view.
+  constexpr View base () const& requires std::copy_constructible<View> { return base_; }
+  /// \returns Moves the base view out of this object.
+  constexpr View base () && { return std::move (base_); }
+
+  /// \brief Obtains the beginning iterator of a transcode_chunks_view.
+  constexpr auto begin () const { return iterator{*this, std::ranges::begin (base_)}; }
+
+  /// \brief Obtains the sentinel denoting the end of transcode_chunks_view.
+  constexpr auto end () const {
+    if constexpr (std::ranges::common_range<View>) {
+      return iterator{*this, std::ranges::end (base_)};
+    } else {
+      return sentinel{*this};
+    }
+  }
+
+  /// \returns True if the input processed was well formed.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
+
+private:
+  /// The underlying view from which input is drawn.
+  ICUBABY_NO_UNIQUE_ADDRESS View base_ = View ();
+  /// True if the input consumed is well formed, false otherwise.
+  mutable bool well_formed_ = true;
+};
+
+/// \brief The iterator type of transcode_chunks_view.
+template <typename FromEncoding, typename ToEncoding, std::ranges::input_range View>
+  requires std::ranges::view<View>
+class transcode_chunks_view<FromEncoding, ToEncoding, View>::iterator {
+public:
+  /// The iterator's reference type is not a true reference so it only meets the C++17 input iterator requirements.
+  using iterator_category = std::input_iterator_tag;
+  /// Define this class as following the forward iterator concept.
+  using iterator_concept = std::forward_iterator_tag;
+
+  /// The type produced by this iterator.
+  using value_type = std::span<ToEncoding const>;
+
+  /// A type that can be used to identify distance between iterators.
+  using difference_type = std::ranges::range_difference_t<View>;
+
+  iterator () requires std::default_initializable<std::ranges::iterator_t<View>> = default;
+  constexpr iterator (transcode_chunks_view const& parent, std::ranges::iterator_t<View const> const& current)
+      : current_{current}, next_{current}, parent_{&parent} {
+    // Prime the buffer so that dereferencing the iterator will yield the first block of output.
+    this->fill ();
+  }
+
+  /// \brief Returns the underlying view
+  constexpr std::ranges::iterator_t<View> const& base () const& noexcept { return current_; }
+  /// \brief Returns the underlying view
+  constexpr std::ranges::iterator_t<View> base () && { return std::move (current_); }
+
+  /// \returns  The current block of output code units.
+  constexpr value_type operator* () const noexcept { return value_type{out_.data (), size_}; }
+
+  constexpr iterator& operator++ () {
+    current_ = next_;
+    this->fill ();
+    return *this;
+  }
+  constexpr void operator++ (int) { ++*this; }
+  constexpr iterator operator++ (int) requires std::ranges::forward_range<View> {
+    auto result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend constexpr bool operator== (iterator const& lhs, iterator const& rhs)
+    requires std::equality_comparable<std::ranges::iterator_t<View>>
+  {
+    return lhs.current_ == rhs.current_ && lhs.parent_ == rhs.parent_;
+  }
+
+private:
+  /// The largest number of code units that the transcoder can produce from a single input code unit.
+  static constexpr auto max_output = max_output_bytes<FromEncoding, ToEncoding>;
+  static_assert (chunk_size > 2 * max_output);
+
+  /// \brief Consumes code units from the base iterator to produce the next block of output.
+  ///
+  /// When the underlying view is a contiguous range of FromEncoding code units with a sized sentinel, the
+  /// transcoder's transcode() member function is used. If no output remains, the iterator is moved to the end of the
+  /// input.
+  constexpr void fill ();
+
+  /// The position in the underlying view of the input from which the current block of output was produced.
+  std::ranges::iterator_t<View const> current_{};
+  /// An iterator referencing the next input code-unit to be consumed.
+  std::ranges::iterator_t<View const> next_{};
+  /// The view to which this iterator belongs.
+  transcode_chunks_view const* parent_ = nullptr;
+  /// The transcoder used to convert a series of code-units in the source encoding to the destination encoding.
+  transcoder<FromEncoding, ToEncoding> transcoder_;
+  /// The current block of output.
+  std::array<ToEncoding, chunk_size> out_{};
+  /// The number of code units in the current block of output.
+  std::size_t size_ = 0;
+};
+
+template <typename FromEncoding, typename ToEncoding, std::ranges::input_range View>
+  requires std::ranges::view<View>
+constexpr void transcode_chunks_view<FromEncoding, ToEncoding, View>::iterator::fill () {
+  auto const input_end = std::ranges::end (parent_->base_);
+  auto bulk = false;
+  if constexpr (icubaby::details::is_bulk_input<FromEncoding, View>) {
+    bulk = !std::is_constant_evaluated ();
+    if (bulk) {
+      // Leave room for the output of end_cp().
+      size_ = icubaby::details::transcode_contiguous (transcoder_, next_, input_end, out_.data (),
+                                                      chunk_size - max_output);
+    }
+  }
+  if (!bulk) {
+    // Leave room for the output of the last input code unit and then for end_cp().
+    auto out = out_.begin ();
+    while (next_ != input_end && static_cast<std::size_t> (out - out_.begin ()) <= chunk_size - 2 * max_output) {
+      out = transcoder_ (*next_, out);
+      ++next_;
+    }
+    if (next_ == input_end) {
+      out = transcoder_.end_cp (out);
+    }
+    size_ = static_cast<std::size_t> (out - out_.begin ());
+  }
+  assert (size_ <= out_.size () && "out_ buffer overflow!");
+  if (!transcoder_.well_formed ()) {
+    parent_->well_formed_ = false;
+  }
+  if (size_ == 0) {
+    // All of the input was consumed without producing output (it may have been a byte order mark).
+    current_ = next_;
+  }
+}
+
+/// \brief The sentinel type of transcode_chunks_view when the underlying view is not a common_range.
+template <typename FromEncoding, typename ToEncoding, std::ranges::input_range View>
+  requires std::ranges::view<View>
+class transcode_chunks_view<FromEncoding, ToEncoding, View>::sentinel {
+public:
+  sentinel () = default;
+  /// Derives the value of this sentinel instance from the end of the associated view.
+  constexpr explicit sentinel (transcode_chunks_view const& parent) : end_{std::ranges::end (parent.base_)} {}
+  /// \returns The underlying view's end sentinel
+  constexpr std::ranges::sentinel_t<View> base () const { return end_; }
+  /// \brief Compares an iterator and sentinel for equality.
+  friend constexpr bool operator== (iterator const& lhs, sentinel const& rhs) { return lhs.base () == rhs.end_; }
+
+private:
+  std::ranges::sentinel_t<View> end_{};  ///< The underlying view's end sentinel
+};
+#endif  // ICUBABY_HAVE_SPAN
+
 namespace views {
 
 /// \tparam FromEncoding  The encoding used by the underlying sequence.
@@ -2388,11 +6477,58 @@ constexpr auto operator| (Range&& range, transcode_range_adaptor<FromEncoding, T
 template <typename FromEncoding, typename ToEncoding>
 inline constexpr auto transcode = transcode_range_adaptor<FromEncoding, ToEncoding>{};
 
+#if ICUBABY_HAVE_SPAN
+/// \tparam FromEncoding  The encoding used by the underlying sequence.
+/// \tparam ToEncoding  The encoding that will be produced by this adaptor.
+template <typename FromEncoding, typename ToEncoding> class transcode_chunks_range_adaptor {
+public:
+  template <std::ranges::viewable_range Range> constexpr auto operator() (Range&& range) const {
+    return transcode_chunks_view<FromEncoding, ToEncoding, std::ranges::views::all_t<Range>>{
+        std::forward<Range> (range)};
+  }
+};
+
+/// \tparam FromEncoding  The encoding used by the underlying sequence.
+/// \tparam ToEncoding  The encoding that will be produced.
+/// \tparam Range  The type of the range that will be consumed.
+template <typename FromEncoding, typename ToEncoding, std::ranges::viewable_range Range>
+constexpr auto operator| (Range&& range, transcode_chunks_range_adaptor<FromEncoding, ToEncoding> const& adaptor) {
+  return adaptor (std::forward<Range> (range));
+}
+
+/// \tparam FromEncoding  The encoding used by the underlying sequence.
+/// \tparam ToEncoding  The encoding that will be produced.
+template <typename FromEncoding, typename ToEncoding>
+inline constexpr auto transcode_chunks = transcode_chunks_range_adaptor<FromEncoding, ToEncoding>{};
+#endif  // ICUBABY_HAVE_SPAN
+
 }  // end namespace views
 
 }  // end namespace ranges
 
 namespace views = ranges::views;
+
+/// \brief Writes the output of a transcode_view to an output iterator.
+///
+/// The result is the same as that of std::ranges::copy(view, out).out. If the view provides output_size() and \p out
+/// is a std::back_insert_iterator for a container with a reserve() member function (such as std::vector or
+/// std::basic_string), the container's capacity is reserved for the entire output before conversion starts.
+///
+/// \param view  The view whose output is to be written.
+/// \param out  The beginning of the destination range.
+/// \returns  An output iterator one past the last code unit written.
+template <typename FromEncoding, typename ToEncoding, typename View, std::weakly_incrementable OutputIterator>
+  requires std::indirectly_copyable<
+      std::ranges::iterator_t<ranges::transcode_view<FromEncoding, ToEncoding, View> const>, OutputIterator>
+OutputIterator copy (ranges::transcode_view<FromEncoding, ToEncoding, View> const& view, OutputIterator out) {
+  if constexpr (requires { view.output_size (); }) {
+    if constexpr (details::has_reserve<typename details::back_insert_container<OutputIterator>::type>) {
+      auto& container = details::back_insert_target (out);
+      container.reserve (container.size () + view.output_size ());
+    }
+  }
+  return std::ranges::copy (view, std::move (out)).out;
+}
 #endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
 
 }  // end namespace icubaby
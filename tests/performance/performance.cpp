@@ -27,6 +27,7 @@
 // LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 //===----------------------------------------------------------------------===//
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
@@ -142,6 +143,188 @@ template <typename FromEncoding, typename ToEncoding> ICUBABY_NOINLINE void go (
             << std::flush;
 }
 
+#if ICUBABY_HAVE_SPAN
+/// The kinds of text used to measure the bulk transcode() API.
+enum class text_kind { ascii, cjk };
+
+/// Creates the input for a bulk conversion measurement.
+///
+/// \param kind  The kind of text to create: either almost entirely ASCII or almost entirely CJK ideographs.
+/// \returns  The input text as a sequence of code points.
+std::vector<char32_t> make_bulk_text (text_kind const kind) {
+  constexpr auto input_size = std::size_t{1} << 22U;
+  std::vector<char32_t> result;
+  result.reserve (input_size);
+  for (auto index = std::size_t{0}; index < input_size; ++index) {
+    auto const ascii = static_cast<char32_t> ('a' + index % 26U);
+    auto const cjk = static_cast<char32_t> (0x4E00 + (index * 7U) % 0x5000U);
+    // Insert an occasional character of the other kind.
+    auto const other = index % 64U == 63U;
+    result.push_back ((kind == text_kind::ascii) != other ? ascii : cjk);
+  }
+  return result;
+}
+
+/// Measures the throughput of the bulk transcode() API.
+template <typename FromEncoding, typename ToEncoding>
+ICUBABY_NOINLINE void go_bulk (std::uint_least16_t const iterations, text_kind const kind) {
+  std::cout << name<FromEncoding>::value << " -> " << name<ToEncoding>::value << " (bulk, "
+            << (kind == text_kind::ascii ? "ASCII" : "CJK") << "): " << std::flush;
+
+  std::vector<FromEncoding> input;
+  auto inserter = std::back_inserter (input);
+  for (auto const code_point : make_bulk_text (kind)) {
+    inserter = convert_code_point<FromEncoding> (code_point, inserter);
+  }
+  std::vector<ToEncoding> output (input.size () * icubaby::longest_sequence<ToEncoding> ());
+
+  icubaby::transcoder<FromEncoding, ToEncoding> transcoder;
+  auto const start_time = std::chrono::steady_clock::now ();
+  for (auto iteration = std::uint_least16_t{0}; iteration < iterations; ++iteration) {
+    auto const res = transcoder.transcode (input, output);
+    (void)res;
+    assert (res.consumed == input.size ());
+  }
+  auto const elapsed = std::chrono::steady_clock::now () - start_time;
+  std::cout << static_cast<double> (std::chrono::duration_cast<std::chrono::milliseconds> (elapsed).count ()) /
+                   static_cast<double> (iterations)
+            << " ms\n"
+            << std::flush;
+}
+
+/// Measures the throughput of the byte transcoder's bulk transcode() API with UTF-16 input (including a byte order
+/// mark).
+template <typename ToEncoding>
+ICUBABY_NOINLINE void go_bulk_bytes (std::uint_least16_t const iterations, bool const little_endian) {
+  std::cout << "bytes (UTF-16 " << (little_endian ? "LE" : "BE") << ") -> " << name<ToEncoding>::value
+            << " (bulk, CJK): " << std::flush;
+
+  std::vector<std::byte> input;
+  auto const append = [&input, little_endian] (char16_t const code_unit) {
+    auto const high = static_cast<std::byte> (code_unit >> 8U);
+    auto const low = static_cast<std::byte> (code_unit & 0xFFU);
+    input.push_back (little_endian ? low : high);
+    input.push_back (little_endian ? high : low);
+  };
+  append (char16_t{0xFEFF});
+  // The byte order mark is followed by an ASCII character so that the low byte of the first code unit is not zero: the
+  // sequence FF FE 00 is the start of a UTF-32 LE byte order mark.
+  append (char16_t{'a'});
+  for (auto const code_point : make_bulk_text (text_kind::cjk)) {
+    std::vector<char16_t> code_units;
+    (void)convert_code_point<char16_t> (code_point, std::back_inserter (code_units));
+    std::for_each (std::begin (code_units), std::end (code_units), append);
+  }
+  std::vector<ToEncoding> output (input.size () * icubaby::longest_sequence<ToEncoding> ());
+
+  auto const start_time = std::chrono::steady_clock::now ();
+  for (auto iteration = std::uint_least16_t{0}; iteration < iterations; ++iteration) {
+    icubaby::transcoder<std::byte, ToEncoding> transcoder;
+    auto const res = transcoder.transcode (input, output);
+    (void)res;
+    assert (res.consumed == input.size ());
+  }
+  auto const elapsed = std::chrono::steady_clock::now () - start_time;
+  std::cout << static_cast<double> (std::chrono::duration_cast<std::chrono::milliseconds> (elapsed).count ()) /
+                   static_cast<double> (iterations)
+            << " ms\n"
+            << std::flush;
+}
+
+/// Measures the throughput of the UTF-8 validator.
+ICUBABY_NOINLINE void go_validate (std::uint_least16_t const iterations) {
+  std::cout << "UTF-8 validate: " << std::flush;
+  auto const all = make_all_code_points<char8> ();
+  auto const start_time = std::chrono::steady_clock::now ();
+  for (auto iteration = std::uint_least16_t{0}; iteration < iterations; ++iteration) {
+    auto const ok = icubaby::validate<char8> (all.code_units);
+    (void)ok;
+    assert (ok);
+  }
+  auto const elapsed = std::chrono::steady_clock::now () - start_time;
+  std::cout << static_cast<double> (std::chrono::duration_cast<std::chrono::milliseconds> (elapsed).count ()) /
+                   static_cast<double> (iterations)
+            << " ms\n"
+            << std::flush;
+}
+
+/// Measures the throughput of output_length() for text of the given kind.
+template <typename FromEncoding, typename ToEncoding>
+ICUBABY_NOINLINE void go_output_length (std::uint_least16_t const iterations, text_kind const kind) {
+  std::cout << name<FromEncoding>::value << " -> " << name<ToEncoding>::value << " (output_length, "
+            << (kind == text_kind::ascii ? "ASCII" : "CJK") << "): " << std::flush;
+
+  std::vector<FromEncoding> input;
+  auto inserter = std::back_inserter (input);
+  for (auto const code_point : make_bulk_text (kind)) {
+    inserter = convert_code_point<FromEncoding> (code_point, inserter);
+  }
+  auto const start_time = std::chrono::steady_clock::now ();
+  for (auto iteration = std::uint_least16_t{0}; iteration < iterations; ++iteration) {
+    auto const length = icubaby::output_length<FromEncoding, ToEncoding> (input);
+    (void)length;
+    assert (length > 0U);
+  }
+  auto const elapsed = std::chrono::steady_clock::now () - start_time;
+  std::cout << static_cast<double> (std::chrono::duration_cast<std::chrono::milliseconds> (elapsed).count ()) /
+                   static_cast<double> (iterations)
+            << " ms\n"
+            << std::flush;
+}
+
+/// Measures the throughput of length() for text of the given kind.
+template <typename Encoding>
+ICUBABY_NOINLINE void go_length (std::uint_least16_t const iterations, text_kind const kind) {
+  std::cout << name<Encoding>::value << " length (" << (kind == text_kind::ascii ? "ASCII" : "CJK")
+            << "): " << std::flush;
+
+  std::vector<Encoding> input;
+  auto inserter = std::back_inserter (input);
+  for (auto const code_point : make_bulk_text (kind)) {
+    inserter = convert_code_point<Encoding> (code_point, inserter);
+  }
+  auto const start_time = std::chrono::steady_clock::now ();
+  for (auto iteration = std::uint_least16_t{0}; iteration < iterations; ++iteration) {
+    auto const length = icubaby::length (std::begin (input), std::end (input));
+    (void)length;
+    assert (length > 0);
+  }
+  auto const elapsed = std::chrono::steady_clock::now () - start_time;
+  std::cout << static_cast<double> (std::chrono::duration_cast<std::chrono::milliseconds> (elapsed).count ()) /
+                   static_cast<double> (iterations)
+            << " ms\n"
+            << std::flush;
+}
+
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+/// Measures the throughput of iterating over views::transcode for text of the given kind.
+template <typename FromEncoding, typename ToEncoding>
+ICUBABY_NOINLINE void go_view (std::uint_least16_t const iterations, text_kind const kind) {
+  std::cout << name<FromEncoding>::value << " -> " << name<ToEncoding>::value << " (view, "
+            << (kind == text_kind::ascii ? "ASCII" : "CJK") << "): " << std::flush;
+
+  std::vector<FromEncoding> input;
+  auto inserter = std::back_inserter (input);
+  for (auto const code_point : make_bulk_text (kind)) {
+    inserter = convert_code_point<FromEncoding> (code_point, inserter);
+  }
+  std::vector<ToEncoding> output (input.size () * icubaby::longest_sequence<ToEncoding> ());
+
+  auto const start_time = std::chrono::steady_clock::now ();
+  for (auto iteration = std::uint_least16_t{0}; iteration < iterations; ++iteration) {
+    auto const res = std::ranges::copy (input | icubaby::views::transcode<FromEncoding, ToEncoding>, output.begin ());
+    (void)res;
+    assert (res.out != output.begin ());
+  }
+  auto const elapsed = std::chrono::steady_clock::now () - start_time;
+  std::cout << static_cast<double> (std::chrono::duration_cast<std::chrono::milliseconds> (elapsed).count ()) /
+                   static_cast<double> (iterations)
+            << " ms\n"
+            << std::flush;
+}
+#endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+#endif  // ICUBABY_HAVE_SPAN
+
 std::uint_least16_t iteration_count (std::string_view const str) {
   auto pos = std::size_t{0};
   auto const iterations = std::stoul (std::string{str}, &pos);
@@ -178,6 +361,26 @@ int main (int const argc, char const *argv[]) {
     go<char32_t, char8> (iterations);
     go<char32_t, char16_t> (iterations);
     go<char32_t, char32_t> (iterations);
+#if ICUBABY_HAVE_SPAN
+    go_bulk<char8, char32_t> (iterations, text_kind::ascii);
+    go_bulk<char8, char16_t> (iterations, text_kind::ascii);
+    go_bulk<char8, char16_t> (iterations, text_kind::cjk);
+    go_bulk<char16_t, char8> (iterations, text_kind::ascii);
+    go_bulk<char16_t, char8> (iterations, text_kind::cjk);
+    go_bulk_bytes<char8> (iterations, true);
+    go_bulk_bytes<char8> (iterations, false);
+    go_bulk_bytes<char32_t> (iterations, true);
+    go_bulk_bytes<char32_t> (iterations, false);
+    go_validate (iterations);
+    go_output_length<char8, char16_t> (iterations, text_kind::cjk);
+    go_output_length<char16_t, char8> (iterations, text_kind::cjk);
+    go_length<char8> (iterations, text_kind::cjk);
+    go_length<char16_t> (iterations, text_kind::cjk);
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+    go_view<char8, char16_t> (iterations, text_kind::ascii);
+    go_view<char8, char16_t> (iterations, text_kind::cjk);
+#endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+#endif  // ICUBABY_HAVE_SPAN
   } catch (std::exception const &ex) {
     std::cerr << "Error: " << ex.what () << '\n';
     exit_code = EXIT_FAILURE;
@@ -27,8 +27,11 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <ostream>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #if ICUBABY_HAVE_RANGES
@@ -376,6 +379,180 @@ TEST (ByteTranscoder, Utf32FirstByteOfLittleEndianBOM) {
   EXPECT_THAT (output, ElementsAre (icubaby::replacement_char, 'A', 'b', 'c'));
 }
 
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, KnownEncodingStartsImmediately) {
+  std::vector<char32_t> output;
+  auto dest = std::back_inserter (output);
+
+  icubaby::transcoder<std::byte, char32_t> transcoder{icubaby::encoding::utf16le};
+  EXPECT_EQ (transcoder.selected_encoding (), icubaby::encoding::utf16le);
+  // A little-endian UTF-16 code unit whose bytes would otherwise be mistaken for the start of a UTF-32 LE BOM.
+  dest = transcoder (std::byte{0xFF}, dest);
+  EXPECT_TRUE (transcoder.partial ());
+  dest = transcoder (std::byte{0x41}, dest);
+  EXPECT_FALSE (transcoder.partial ());
+  EXPECT_THAT (output, ElementsAre (char32_t{0x41FF}));
+  dest = transcoder (std::byte{'b'}, dest);
+  dest = transcoder (std::byte{0x00}, dest);
+  EXPECT_THAT (output, ElementsAre (char32_t{0x41FF}, char32_t{'b'}));
+  (void)transcoder.end_cp (dest);
+  EXPECT_TRUE (transcoder.well_formed ());
+}
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, KnownEncodingStripsBOM) {
+  auto const convert = [] (icubaby::encoding const enc, bool const strip_bom, std::vector<std::byte> const& input) {
+    icubaby::transcoder<std::byte, char32_t> transcoder{enc, strip_bom};
+    std::vector<char32_t> output;
+    auto dest = std::back_inserter (output);
+    for (auto const value : input) {
+      dest = transcoder (value, dest);
+    }
+    (void)transcoder.end_cp (dest);
+    if (enc != icubaby::encoding::unknown) {
+      EXPECT_EQ (transcoder.selected_encoding (), enc);
+    }
+    return output;
+  };
+  std::vector const utf8{std::byte{0xEF}, std::byte{0xBB}, std::byte{0xBF}, std::byte{'A'}};
+  EXPECT_THAT (convert (icubaby::encoding::utf8, true, utf8), ElementsAre (char32_t{'A'}));
+  EXPECT_THAT (convert (icubaby::encoding::utf8, false, utf8), ElementsAre (icubaby::byte_order_mark, char32_t{'A'}));
+  std::vector const utf16be{std::byte{0xFE}, std::byte{0xFF}, std::byte{0x00}, std::byte{'A'}};
+  EXPECT_THAT (convert (icubaby::encoding::utf16be, true, utf16be), ElementsAre (char32_t{'A'}));
+  std::vector const utf32be{std::byte{0x00}, std::byte{0x00}, std::byte{0xFE}, std::byte{0xFF},
+                            std::byte{0x00}, std::byte{0x00}, std::byte{0x00}, std::byte{'A'}};
+  EXPECT_THAT (convert (icubaby::encoding::utf32be, true, utf32be), ElementsAre (char32_t{'A'}));
+  EXPECT_THAT (convert (icubaby::encoding::utf32be, false, utf32be),
+               ElementsAre (icubaby::byte_order_mark, char32_t{'A'}));
+  std::vector const utf32le{std::byte{0xFF}, std::byte{0xFE}, std::byte{0x00}, std::byte{0x00},
+                            std::byte{'A'},  std::byte{0x00}, std::byte{0x00}, std::byte{0x00}};
+  EXPECT_THAT (convert (icubaby::encoding::utf32le, true, utf32le), ElementsAre (char32_t{'A'}));
+  // A BOM for a different encoding is not stripped.
+  EXPECT_THAT (convert (icubaby::encoding::utf16le, true, utf16be), ElementsAre (char32_t{0xFFFE}, char32_t{0x4100}));
+  // An incomplete BOM is decoded as ordinary input.
+  EXPECT_THAT (convert (icubaby::encoding::utf8, true, {std::byte{0xEF}, std::byte{0xBB}}),
+               ElementsAre (icubaby::replacement_char));
+  EXPECT_THAT (convert (icubaby::encoding::utf8, true, {std::byte{0xEF}, std::byte{0xBB}, std::byte{0xBE}}),
+               ElementsAre (char32_t{0xFEFE}));
+  EXPECT_THAT (convert (icubaby::encoding::unknown, true, utf16be), ElementsAre (char32_t{'A'}));
+}
+#if ICUBABY_HAVE_SPAN
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, KnownEncodingTranscode) {
+  std::vector<std::byte> input{std::byte{0xFE}, std::byte{0xFF}};
+  for (auto index = 0U; index < 1000U; ++index) {
+    input.push_back (std::byte{0x30});
+    input.push_back (static_cast<std::byte> (0x40U + index % 64U));
+  }
+  for (auto const strip_bom : {true, false}) {
+    icubaby::transcoder<std::byte, char32_t> transcoder{icubaby::encoding::utf16be, strip_bom};
+    std::vector<char32_t> output (input.size ());
+    auto const res = transcoder.transcode (input, output);
+    EXPECT_EQ (res.consumed, input.size ());
+    EXPECT_FALSE (res.partial);
+    output.resize (res.produced);
+    std::vector<char32_t> expected;
+    if (!strip_bom) {
+      expected.push_back (icubaby::byte_order_mark);
+    }
+    for (auto index = 0U; index < 1000U; ++index) {
+      expected.push_back (static_cast<char32_t> (0x3040U + index % 64U));
+    }
+    EXPECT_THAT (output, testing::ContainerEq (expected));
+  }
+}
+#endif  // ICUBABY_HAVE_SPAN
+
+namespace {
+
+template <typename CharType>
+std::vector<std::byte> to_bytes (std::basic_string_view<CharType> const str, bool const little_endian,
+                                 unsigned const repeat) {
+  std::vector<std::byte> result;
+  for (auto count = 0U; count < repeat; ++count) {
+    for (auto const code_unit : str) {
+      for (auto index = 0U; index < sizeof (CharType); ++index) {
+        auto const shift = 8U * (little_endian ? index : sizeof (CharType) - 1U - index);
+        result.push_back (static_cast<std::byte> ((static_cast<std::uint_least32_t> (code_unit) >> shift) & 0xFFU));
+      }
+    }
+  }
+  return result;
+}
+
+icubaby::encoding guess (std::vector<std::byte> const& input) {
+  return icubaby::guess_encoding (input.data (), input.data () + input.size ());
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, GuessEncoding) {
+  using icubaby::encoding;
+  EXPECT_EQ (guess ({}), encoding::unknown);
+  // A byte order mark decides the encoding.
+  EXPECT_EQ (guess ({std::byte{0xFF}, std::byte{0xFE}, std::byte{0x00}, std::byte{0x41}}), encoding::utf16le);
+  EXPECT_EQ (guess ({std::byte{0xFF}, std::byte{0xFE}, std::byte{0x00}, std::byte{0x00}}), encoding::utf32le);
+  EXPECT_EQ (guess ({std::byte{0xFE}, std::byte{0xFF}, std::byte{0x41}, std::byte{0x00}}), encoding::utf16be);
+  EXPECT_EQ (guess ({std::byte{0xEF}, std::byte{0xBB}, std::byte{0xBF}, std::byte{0x00}}), encoding::utf8);
+
+  // Both short inputs and those long enough to use the vector code.
+  for (auto const repeat : {1U, 50U}) {
+    EXPECT_EQ (guess (to_bytes (std::string_view{"Hello, w\xC3\xB6rld! "}, true, repeat)), encoding::utf8);
+    EXPECT_EQ (guess (to_bytes (std::u16string_view{u"Hello, w\u00F6rld! "}, true, repeat)), encoding::utf16le);
+    EXPECT_EQ (guess (to_bytes (std::u16string_view{u"Hello, w\u00F6rld! "}, false, repeat)), encoding::utf16be);
+    EXPECT_EQ (guess (to_bytes (std::u32string_view{U"Hello, w\u00F6rld! "}, true, repeat)), encoding::utf32le);
+    EXPECT_EQ (guess (to_bytes (std::u32string_view{U"Hello, w\u00F6rld! "}, false, repeat)), encoding::utf32be);
+    // UTF-16 without zero bytes is recognized because it is not well-formed UTF-8.
+    EXPECT_EQ (guess (to_bytes (std::u16string_view{u"\u65E5\u672C\u8A9E\U0001F600"}, true, repeat)),
+               encoding::utf16le);
+  }
+  // The input may end part way through a code point.
+  EXPECT_EQ (guess ({std::byte{'a'}, std::byte{0xE6}, std::byte{0x97}}), encoding::utf8);
+  EXPECT_EQ (
+      guess ({std::byte{'a'}, std::byte{0x00}, std::byte{'b'}, std::byte{0x00}, std::byte{0x3D}, std::byte{0xD8}}),
+      encoding::utf16le);
+  // A mismatched surrogate rules out UTF-16 so the default is used.
+  EXPECT_EQ (guess ({std::byte{0x00}, std::byte{0xDC}, std::byte{0xDC}, std::byte{0x00}, std::byte{0xFF}}),
+             encoding::utf8);
+}
+#if ICUBABY_HAVE_SPAN
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, DetectEncodingTranscode) {
+  using icubaby::encoding;
+  std::u32string_view const text = U"Hello, w\u00F6rld! ";
+  std::u32string expected;
+  for (auto count = 0U; count < 20U; ++count) {
+    expected += text;
+  }
+  auto const check = [&expected] (std::vector<std::byte> const& input, encoding const enc) {
+    icubaby::transcoder<std::byte, char32_t> transcoder{icubaby::detect_encoding};
+    std::vector<char32_t> output (input.size ());
+    auto const res = transcoder.transcode (input, output);
+    EXPECT_EQ (res.consumed, input.size ());
+    output.resize (res.produced);
+    EXPECT_EQ (transcoder.selected_encoding (), enc);
+    EXPECT_THAT (output, testing::ElementsAreArray (expected));
+  };
+  check (to_bytes (std::string_view{"Hello, w\xC3\xB6rld! "}, true, 20U), encoding::utf8);
+  check (to_bytes (std::u16string_view{u"Hello, w\u00F6rld! "}, true, 20U), encoding::utf16le);
+  check (to_bytes (std::u16string_view{u"Hello, w\u00F6rld! "}, false, 20U), encoding::utf16be);
+  check (to_bytes (std::u32string_view{U"Hello, w\u00F6rld! "}, true, 20U), encoding::utf32le);
+  check (to_bytes (std::u32string_view{U"Hello, w\u00F6rld! "}, false, 20U), encoding::utf32be);
+
+  // A byte order mark is removed.
+  auto input = to_bytes (std::u16string_view{u"\uFEFF"}, true, 1U);
+  auto const body = to_bytes (std::u16string_view{u"Hello, w\u00F6rld! "}, true, 20U);
+  input.insert (input.end (), body.begin (), body.end ());
+  check (input, encoding::utf16le);
+
+  // With a prefix of 0, no detection is performed and the input is treated as UTF-8.
+  icubaby::transcoder<std::byte, char32_t> transcoder{icubaby::detect_encoding, 0};
+  std::vector<char32_t> output (body.size ());
+  (void)transcoder.transcode (body, output);
+  EXPECT_EQ (transcoder.selected_encoding (), encoding::utf8);
+}
+#endif  // ICUBABY_HAVE_SPAN
+
 #if ICUBABY_HAVE_RANGES
 // NOLINTNEXTLINE
 TEST (ByteTranscoder, RangesNoBOM) {
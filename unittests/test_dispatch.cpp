@@ -0,0 +1,146 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// icubaby itself.
+#include "icubaby/dispatch.hpp"
+#include "icubaby/icubaby.hpp"
+
+// standard library
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Google Test/Mock
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+// Local includes
+#include "test_input.hpp"
+
+static_assert (ICUBABY_DISPATCH, "The dispatch tests must be built with ICUBABY_DISPATCH enabled");
+
+#if ICUBABY_HAVE_SPAN
+
+using icubaby::char8;
+using icubaby::dispatch::level;
+using testing::ContainerEq;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+constexpr std::array const all_levels{level::scalar, level::sse42, level::avx2, level::avx512};
+
+// Restores the active level when it goes out of scope.
+class level_restorer {
+public:
+  level_restorer () noexcept = default;
+  level_restorer (level_restorer const&) = delete;
+  level_restorer (level_restorer&&) noexcept = delete;
+  ~level_restorer () noexcept { (void)icubaby::dispatch::select_level (old_); }
+  level_restorer& operator= (level_restorer const&) = delete;
+  level_restorer& operator= (level_restorer&&) noexcept = delete;
+
+private:
+  level old_ = icubaby::dispatch::active_level ();
+};
+
+template <typename Transcoder, typename Input>
+std::tuple<std::vector<typename Transcoder::output_type>, bool> convert_bulk (Input const& input) {
+  std::vector<typename Transcoder::output_type> output (input.size () * 3U);
+  Transcoder transcoder;
+  auto const res = transcoder.transcode (std::span{input}, std::span{output});
+  EXPECT_EQ (res.consumed, input.size ());
+  output.resize (res.produced);
+  (void)transcoder.end_cp (std::back_inserter (output));
+  return std::make_tuple (std::move (output), transcoder.well_formed ());
+}
+
+template <typename Transcoder, typename Input> void check_level (Input const& input) {
+  auto const [expected, expected_well_formed] = convert_per_unit<Transcoder> (input);
+  auto const [actual, actual_well_formed] = convert_bulk<Transcoder> (input);
+  EXPECT_EQ (actual_well_formed, expected_well_formed);
+  EXPECT_THAT (actual, ContainerEq (expected));
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (Dispatch, EnvironmentOverride) {
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  auto const* const env = std::getenv ("ICUBABY_DISPATCH_LEVEL");
+  auto expected = icubaby::dispatch::best_level ();
+  for (auto const lvl : all_levels) {
+    if (env != nullptr && icubaby::dispatch::level_name (lvl) == env && lvl < expected) {
+      expected = lvl;
+    }
+  }
+  EXPECT_EQ (icubaby::dispatch::active_level (), expected);
+}
+
+// NOLINTNEXTLINE
+TEST (Dispatch, LevelNames) {
+  EXPECT_EQ (icubaby::dispatch::level_name (level::scalar), "scalar");
+  EXPECT_EQ (icubaby::dispatch::level_name (level::sse42), "sse42");
+  EXPECT_EQ (icubaby::dispatch::level_name (level::avx2), "avx2");
+  EXPECT_EQ (icubaby::dispatch::level_name (level::avx512), "avx512");
+}
+
+// NOLINTNEXTLINE
+TEST (Dispatch, SelectLevel) {
+  level_restorer const restore;
+  auto const best = icubaby::dispatch::best_level ();
+  for (auto const lvl : all_levels) {
+    EXPECT_EQ (icubaby::dispatch::select_level (lvl), lvl <= best) << icubaby::dispatch::level_name (lvl);
+    EXPECT_EQ (icubaby::dispatch::active_level (), lvl <= best ? lvl : best);
+    (void)icubaby::dispatch::select_level (best);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Dispatch, EveryLevelMatchesPerUnit) {
+  level_restorer const restore;
+  auto const good_utf8 = make_random_input<char8> (true);
+  auto const utf8 = make_random_input<char8> (false);
+  auto const utf16 = make_random_input<char16_t> (false);
+  for (auto const lvl : all_levels) {
+    if (!icubaby::dispatch::select_level (lvl)) {
+      continue;
+    }
+    SCOPED_TRACE (icubaby::dispatch::level_name (lvl));
+    check_level<icubaby::transcoder<char8, char32_t>> (utf8);
+    check_level<icubaby::transcoder<char8, char16_t>> (utf8);
+    check_level<icubaby::transcoder<char16_t, char8>> (utf16);
+    check_level<icubaby::transcoder<char8, char16_t>> (good_utf8);
+    EXPECT_TRUE (icubaby::validate (std::span{good_utf8}));
+    EXPECT_FALSE (icubaby::validate (std::span{utf8}));
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+#endif  // ICUBABY_HAVE_SPAN
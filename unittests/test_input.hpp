@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef ICUBABY_TEST_INPUT_HPP
+#define ICUBABY_TEST_INPUT_HPP (1)
+
+// Input sequences and reference conversions shared by the transcoder tests.
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "icubaby/icubaby.hpp"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+// Encodes a single code point.
+template <typename Encoding> std::vector<Encoding> encode (char32_t const code_point) {
+  std::vector<Encoding> result;
+  icubaby::transcoder<char32_t, Encoding> transcoder;
+  (void)transcoder.end_cp (transcoder (code_point, std::back_inserter (result)));
+  return result;
+}
+
+// Ill-formed sequences in each of the input encodings.
+template <typename Encoding> std::vector<std::vector<Encoding>> bad_sequences ();
+template <> inline std::vector<std::vector<icubaby::char8>> bad_sequences<icubaby::char8> () {
+  auto cu = [] (unsigned value) { return static_cast<icubaby::char8> (value); };
+  return {{cu (0x80)}, {cu (0xC3), cu (0x28)}, {cu (0xF0), cu (0x9F)}, {cu (0xED), cu (0xA0), cu (0x80)}, {cu (0xFF)}};
+}
+template <> inline std::vector<std::vector<char16_t>> bad_sequences<char16_t> () {
+  return {{char16_t{0xDC00}}, {char16_t{0xD800}, char16_t{'A'}}, {char16_t{0xD800}, char16_t{0xD801}}};
+}
+template <> inline std::vector<std::vector<char32_t>> bad_sequences<char32_t> () {
+  return {{char32_t{0xD800}}, {char32_t{0x110000}}, {char32_t{0xFFFFFFFF}}};
+}
+
+// Builds a long pseudo-random input sequence. Runs of code points are drawn from the ASCII, two byte, three byte
+// (including CJK), and four byte UTF-8 ranges so that vectorized code paths see a realistic mix of blocks. If
+// 'well_formed' is false, ill-formed sequences are occasionally inserted.
+template <typename Encoding> std::vector<Encoding> make_random_input (bool const well_formed) {
+  std::vector<Encoding> result;
+  auto const bad = bad_sequences<Encoding> ();
+  auto seed = std::uint_least32_t{12345};
+  auto const random = [&seed] (std::uint_least32_t const limit) {
+    seed = seed * 1103515245U + 12345U;  // A simple linear congruential generator.
+    return (seed >> 8U) % limit;
+  };
+  constexpr std::array<std::array<char32_t, 2>, 5> const ranges{{
+      {{0x20, 0x7E}},       // ASCII
+      {{0x80, 0x7FF}},      // Two byte UTF-8
+      {{0x4E00, 0x9FFF}},   // CJK Unified Ideographs
+      {{0xE000, 0xFFFF}},   // Three byte UTF-8 beyond the surrogates
+      {{0x10000, 0x10FFFF}} // Four byte UTF-8
+  }};
+  while (result.size () < 20000U) {
+    if (!well_formed && random (16) == 0) {
+      auto const& seq = bad[random (static_cast<std::uint_least32_t> (bad.size ()))];
+      result.insert (result.end (), seq.begin (), seq.end ());
+    }
+    // Four byte sequences are rarer than the others.
+    auto const& range = ranges[random (4) == 0 ? random (5) : random (4)];
+    for (auto run = random (40) + 1; run > 0; --run) {
+      auto const code_point = static_cast<char32_t> (range[0] + random (range[1] - range[0] + 1));
+      auto const encoded = encode<Encoding> (code_point);
+      result.insert (result.end (), encoded.begin (), encoded.end ());
+    }
+  }
+  return result;
+}
+
+// Converts the input using one call to the transcoder's function-call operator for each code unit.
+template <typename Transcoder, typename InputContainer>
+std::tuple<std::vector<typename Transcoder::output_type>, bool> convert_per_unit (InputContainer const& input) {
+  std::vector<typename Transcoder::output_type> output;
+  Transcoder transcoder;
+  auto out = std::back_inserter (output);
+  for (auto const code_unit : input) {
+    out = transcoder (code_unit, out);
+  }
+  (void)transcoder.end_cp (out);
+  return std::make_tuple (std::move (output), transcoder.well_formed ());
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+#endif  // ICUBABY_TEST_INPUT_HPP
@@ -0,0 +1,944 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// standard library
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Google Test/Mock
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+// Local includes
+#include "test_input.hpp"
+#include "typed_test.hpp"
+
+#if ICUBABY_HAVE_SPAN
+
+using testing::ContainerEq;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+// A selection of code points which between them need every length of encoding in UTF-8 and UTF-16.
+constexpr std::array const sample_code_points{
+    char32_t{'H'},    char32_t{'e'},     char32_t{'l'},     char32_t{'l'},    char32_t{'o'},    char32_t{0x00A2},
+    char32_t{0x0939}, char32_t{0x3053},  char32_t{0x3093},  char32_t{0xFFFF}, char32_t{0x10348}, char32_t{0x1F4A9},
+    char32_t{'\n'},   char32_t{0x0080},  char32_t{0x07FF},  char32_t{0x0800}, char32_t{0x10000}, char32_t{0x10FFFF},
+};
+
+// Builds an input sequence in which well-formed code points are interleaved with ill-formed sequences.
+template <typename Encoding> std::vector<Encoding> make_input (bool const well_formed) {
+  std::vector<Encoding> result;
+  auto const bad = bad_sequences<Encoding> ();
+  auto bad_index = std::size_t{0};
+  for (auto repeat = 0; repeat < 8; ++repeat) {
+    for (auto const code_point : sample_code_points) {
+      auto const encoded = encode<Encoding> (code_point);
+      result.insert (result.end (), encoded.begin (), encoded.end ());
+    }
+    if (!well_formed) {
+      auto const& seq = bad[bad_index++ % bad.size ()];
+      result.insert (result.end (), seq.begin (), seq.end ());
+    }
+  }
+  return result;
+}
+
+// Converts the input using repeated calls to the transcoder's bulk transcode() member function. Each call is given
+// an output buffer whose size is given by the 'capacity' argument.
+template <typename Transcoder, typename InputContainer>
+std::tuple<std::vector<typename Transcoder::output_type>, bool> convert_bulk (InputContainer const& input,
+                                                                              std::size_t const capacity) {
+  using output_type = typename Transcoder::output_type;
+  std::vector<output_type> output;
+  std::vector<output_type> buffer (capacity);
+  Transcoder transcoder;
+  auto first = input.data ();
+  auto const last = input.data () + input.size ();
+  while (first != last) {
+    auto const res = transcoder.transcode (std::span{first, last}, std::span{buffer});
+    EXPECT_LE (res.produced, capacity);
+    EXPECT_EQ (res.partial, transcoder.partial ());
+    if (res.consumed == 0) {
+      ADD_FAILURE () << "transcode() made no progress";
+      break;
+    }
+    output.insert (output.end (), buffer.begin (), buffer.begin () + static_cast<std::ptrdiff_t> (res.produced));
+    first += res.consumed;
+  }
+  (void)transcoder.end_cp (std::back_inserter (output));
+  return std::make_tuple (std::move (output), transcoder.well_formed ());
+}
+
+// Computes the output expected from a transcoder whose error policy is skip (or, if 'stop' is true, stop) by
+// converting the input one code unit at a time with the default policy and removing the replacement characters.
+template <typename Transcoder, typename InputContainer>
+std::vector<typename Transcoder::output_type> convert_without_replacements (InputContainer const& input,
+                                                                           bool const stop) {
+  using output_type = typename Transcoder::output_type;
+  auto const replacement = encode<output_type> (icubaby::replacement_char);
+  std::vector<output_type> output;
+  Transcoder transcoder;
+  for (auto const code_unit : input) {
+    std::vector<output_type> step;
+    (void)transcoder (code_unit, std::back_inserter (step));
+    if (!transcoder.well_formed ()) {
+      if (stop) {
+        return output;
+      }
+      // The replacement character comes first in the output from the code unit which revealed the error.
+      EXPECT_TRUE (std::equal (replacement.begin (), replacement.end (), step.begin ()));
+      step.erase (step.begin (), step.begin () + static_cast<std::ptrdiff_t> (replacement.size ()));
+      transcoder.set_well_formed (true);
+    }
+    output.insert (output.end (), step.begin (), step.end ());
+  }
+  std::vector<output_type> tail;
+  (void)transcoder.end_cp (std::back_inserter (tail));
+  if (transcoder.well_formed ()) {
+    output.insert (output.end (), tail.begin (), tail.end ());
+  }
+  return output;
+}
+
+// Inserts line terminators (LF, CR, and CR LF) into the input at irregular intervals.
+template <typename Encoding> std::vector<Encoding> add_line_endings (std::vector<Encoding> const& input) {
+  std::vector<Encoding> result;
+  auto index = std::size_t{0};
+  for (auto const code_unit : input) {
+    if (index % 37U == 0U) {
+      result.push_back (Encoding{'\n'});
+    } else if (index % 53U == 0U) {
+      result.push_back (Encoding{'\r'});
+    } else if (index % 71U == 0U) {
+      result.push_back (Encoding{'\r'});
+      result.push_back (Encoding{'\n'});
+    }
+    result.push_back (code_unit);
+    ++index;
+  }
+  return result;
+}
+
+// Finds the offsets of the line terminators in a sequence of code units one code unit at a time.
+template <typename Encoding>
+std::vector<std::size_t> find_line_endings (std::vector<Encoding> const& text, icubaby::line_endings const endings) {
+  std::vector<std::size_t> result;
+  for (auto index = std::size_t{0}; index < text.size (); ++index) {
+    auto const code_unit = static_cast<std::uint_least32_t> (text[index]);
+    auto const after_cr = index > 0 && static_cast<std::uint_least32_t> (text[index - 1]) == '\r';
+    if (endings == icubaby::line_endings::any ? code_unit == '\r' || (code_unit == '\n' && !after_cr)
+                                              : code_unit == '\n') {
+      result.push_back (index);
+    }
+  }
+  return result;
+}
+
+// Converts the input using transcode_lines() and checks that the recorded line endings match the output.
+template <typename Transcoder, typename InputContainer>
+void check_transcode_lines (InputContainer const& input, icubaby::line_endings const endings) {
+  using output_type = typename Transcoder::output_type;
+  auto const [expected, expected_well_formed] = convert_per_unit<Transcoder> (input);
+  (void)expected_well_formed;
+  std::vector<output_type> output (expected.size ());
+  std::vector<std::size_t> lines;
+  icubaby::line_recorder recorder{std::back_inserter (lines), endings};
+  Transcoder transcoder;
+  auto const res = icubaby::transcode_lines (transcoder, std::span{input}, std::span{output}, recorder);
+  EXPECT_EQ (res.consumed, input.size ());
+  // Pass the output of end_cp() to the recorder as well.
+  auto const tail_first = output.begin () + static_cast<std::ptrdiff_t> (res.produced);
+  auto const tail_last = transcoder.end_cp (tail_first);
+  recorder (std::span<output_type const>{tail_first, tail_last});
+  EXPECT_THAT (output, ContainerEq (expected));
+  EXPECT_EQ (recorder.offset (), expected.size ());
+  EXPECT_THAT (lines, ContainerEq (find_line_endings (expected, endings)));
+}
+
+template <typename T> class Transcode : public testing::Test {};
+
+template <typename From, typename To> struct encoding_pair {
+  using from = From;
+  using to = To;
+};
+
+class TranscodeNames {
+public:
+  template <typename T> static std::string GetName (int index) {
+    return name<typename T::from> () + "_" + name<typename T::to> () + std::to_string (index);
+  }
+
+private:
+  template <typename T> static std::string name () {
+    if constexpr (std::is_same_v<T, std::byte>) {
+      return "byte";
+    } else {
+      return OutputTypeNames::GetName<T> (0);
+    }
+  }
+};
+
+using EncodingPairs =
+    testing::Types<encoding_pair<icubaby::char8, icubaby::char8>, encoding_pair<icubaby::char8, char16_t>,
+                   encoding_pair<icubaby::char8, char32_t>, encoding_pair<char16_t, icubaby::char8>,
+                   encoding_pair<char16_t, char16_t>, encoding_pair<char16_t, char32_t>,
+                   encoding_pair<char32_t, icubaby::char8>, encoding_pair<char32_t, char16_t>,
+                   encoding_pair<char32_t, char32_t>>;
+
+}  // end anonymous namespace
+
+TYPED_TEST_SUITE (Transcode, EncodingPairs, TranscodeNames);
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, WellFormedMatchesPerUnit) {
+  using transcoder_type = icubaby::transcoder<typename TypeParam::from, typename TypeParam::to>;
+  auto const input = make_input<typename TypeParam::from> (true);
+  auto const [expected, expected_well_formed] = convert_per_unit<transcoder_type> (input);
+  EXPECT_TRUE (expected_well_formed);
+  for (auto const capacity : {std::size_t{6}, std::size_t{7}, std::size_t{13}, std::size_t{64}, std::size_t{4096}}) {
+    auto const [actual, actual_well_formed] = convert_bulk<transcoder_type> (input, capacity);
+    EXPECT_EQ (actual_well_formed, expected_well_formed) << "capacity=" << capacity;
+    EXPECT_THAT (actual, ContainerEq (expected)) << "capacity=" << capacity;
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, IllFormedMatchesPerUnit) {
+  using transcoder_type = icubaby::transcoder<typename TypeParam::from, typename TypeParam::to>;
+  auto const input = make_input<typename TypeParam::from> (false);
+  auto const [expected, expected_well_formed] = convert_per_unit<transcoder_type> (input);
+  EXPECT_FALSE (expected_well_formed);
+  for (auto const capacity : {std::size_t{6}, std::size_t{7}, std::size_t{13}, std::size_t{64}, std::size_t{4096}}) {
+    auto const [actual, actual_well_formed] = convert_bulk<transcoder_type> (input, capacity);
+    EXPECT_EQ (actual_well_formed, expected_well_formed) << "capacity=" << capacity;
+    EXPECT_THAT (actual, ContainerEq (expected)) << "capacity=" << capacity;
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, RandomMatchesPerUnit) {
+  using transcoder_type = icubaby::transcoder<typename TypeParam::from, typename TypeParam::to>;
+  for (auto const well_formed : {true, false}) {
+    auto const input = make_random_input<typename TypeParam::from> (well_formed);
+    auto const [expected, expected_well_formed] = convert_per_unit<transcoder_type> (input);
+    EXPECT_EQ (expected_well_formed, well_formed);
+    for (auto const capacity : {std::size_t{7}, std::size_t{31}, std::size_t{65536}}) {
+      auto const [actual, actual_well_formed] = convert_bulk<transcoder_type> (input, capacity);
+      EXPECT_EQ (actual_well_formed, expected_well_formed) << "capacity=" << capacity;
+      EXPECT_THAT (actual, ContainerEq (expected)) << "capacity=" << capacity;
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, OutputTooSmall) {
+  using transcoder_type = icubaby::transcoder<typename TypeParam::from, typename TypeParam::to>;
+  using output_type = typename TypeParam::to;
+  // U+1F4A9 PILE OF POO needs more than one code unit in both UTF-8 and UTF-16.
+  auto const input = encode<typename TypeParam::from> (char32_t{0x1F4A9});
+  auto const expected = encode<output_type> (char32_t{0x1F4A9});
+  if (expected.size () < 2U) {
+    GTEST_SKIP () << "The output encoding uses a single code unit";
+  }
+
+  std::vector<output_type> output (expected.size () - 1U);
+  transcoder_type transcoder;
+  auto const res = transcoder.transcode (std::span{input}, std::span{output});
+  // Every code unit but the last will have been consumed: that would produce output for which there is no room.
+  EXPECT_EQ (res.consumed, input.size () - 1U);
+  EXPECT_EQ (res.produced, 0U);
+  EXPECT_EQ (res.partial, input.size () > 1U);
+
+  // Try again with an output buffer that is exactly large enough.
+  output.resize (expected.size ());
+  auto const res2 = transcoder.transcode (std::span{input}.subspan (res.consumed), std::span{output});
+  EXPECT_EQ (res2.consumed, 1U);
+  EXPECT_EQ (res2.produced, expected.size ());
+  EXPECT_FALSE (res2.partial);
+  EXPECT_THAT (output, ContainerEq (expected));
+  EXPECT_TRUE (transcoder.well_formed ());
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, PartialCodePointCarriedOver) {
+  using transcoder_type = icubaby::transcoder<typename TypeParam::from, typename TypeParam::to>;
+  using output_type = typename TypeParam::to;
+  auto const input = encode<typename TypeParam::from> (char32_t{0x10348});
+  auto const expected = encode<output_type> (char32_t{0x10348});
+
+  std::vector<output_type> output;
+  std::array<output_type, 8> buffer{};
+  transcoder_type transcoder;
+  // Pass the input one code unit at a time.
+  for (auto const& code_unit : input) {
+    auto const res = transcoder.transcode (std::span{&code_unit, 1U}, std::span{buffer});
+    EXPECT_EQ (res.consumed, 1U);
+    output.insert (output.end (), buffer.begin (), buffer.begin () + static_cast<std::ptrdiff_t> (res.produced));
+    EXPECT_EQ (res.partial, output.empty ());
+  }
+  (void)transcoder.end_cp (std::back_inserter (output));
+  EXPECT_THAT (output, ContainerEq (expected));
+  EXPECT_TRUE (transcoder.well_formed ());
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, EmptyInput) {
+  icubaby::transcoder<typename TypeParam::from, typename TypeParam::to> transcoder;
+  std::array<typename TypeParam::to, 4> output{};
+  auto const res = transcoder.transcode ({}, std::span{output});
+  EXPECT_EQ (res.consumed, 0U);
+  EXPECT_EQ (res.produced, 0U);
+  EXPECT_FALSE (res.partial);
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, OutputLength) {
+  using from = typename TypeParam::from;
+  using to = typename TypeParam::to;
+  using transcoder_type = icubaby::transcoder<from, to>;
+  EXPECT_EQ ((icubaby::output_length<from, to> ({})), 0U);
+  for (auto const well_formed : {true, false}) {
+    for (auto const& input : {make_input<from> (well_formed), make_random_input<from> (well_formed)}) {
+      auto const expected = std::get<0> (convert_per_unit<transcoder_type> (input)).size ();
+      EXPECT_EQ ((icubaby::output_length<from, to> (std::span{input})), expected) << "well_formed=" << well_formed;
+      // Drop the final code unit so that the input may end with a partial code point.
+      auto const truncated = std::span{input}.first (input.size () - 1U);
+      EXPECT_EQ ((icubaby::output_length<from, to> (truncated)),
+                 std::get<0> (convert_per_unit<transcoder_type> (truncated)).size ())
+          << "well_formed=" << well_formed;
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, TranscodeLines) {
+  using from = typename TypeParam::from;
+  using transcoder_type = icubaby::transcoder<from, typename TypeParam::to>;
+  for (auto const well_formed : {true, false}) {
+    auto const input = add_line_endings (make_random_input<from> (well_formed));
+    check_transcode_lines<transcoder_type> (input, icubaby::line_endings::lf);
+    check_transcode_lines<transcoder_type> (input, icubaby::line_endings::any);
+  }
+}
+
+namespace {
+
+// A minimal container with reserve() and push_back() whose insert() member does not take a pair of iterators.
+template <typename T> struct reserve_only_container {
+  using value_type = T;
+  using const_reference = T const&;
+  using iterator = typename std::vector<T>::iterator;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  void reserve (std::size_t const size) {
+    ++reserve_calls;
+    values.reserve (size);
+  }
+  [[nodiscard]] std::size_t size () const noexcept { return values.size (); }
+  iterator end () noexcept { return values.end (); }
+  void push_back (T const& value) { values.push_back (value); }
+  iterator insert (const_iterator pos, std::size_t const count, T const& value) {
+    return values.insert (pos, count, value);
+  }
+
+  std::vector<T> values;
+  unsigned reserve_calls = 0;
+};
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, Copy) {
+  using from = typename TypeParam::from;
+  using to = typename TypeParam::to;
+  using transcoder_type = icubaby::transcoder<from, to>;
+  for (auto const well_formed : {true, false}) {
+    auto const input = make_random_input<from> (well_formed);
+    auto const expected = std::get<0> (convert_per_unit<transcoder_type> (input));
+    {
+      // Append to a vector.
+      std::vector<to> output;
+      transcoder_type transcoder;
+      auto const out = icubaby::copy (input.begin (), input.end (),
+                                      icubaby::iterator{&transcoder, std::back_inserter (output)});
+      (void)transcoder.end_cp (out);
+      EXPECT_THAT (output, ContainerEq (expected)) << "well_formed=" << well_formed;
+    }
+    {
+      // Write through a pointer in two calls so that a code point may be split between them.
+      std::vector<to> output (expected.size ());
+      transcoder_type transcoder;
+      auto const* const middle = input.data () + input.size () / 2U;
+      auto out = icubaby::copy (input.data (), middle, icubaby::iterator{&transcoder, output.data ()});
+      out = icubaby::copy (middle, input.data () + input.size (), out);
+      EXPECT_EQ (transcoder.end_cp (out).base (), output.data () + output.size ());
+      EXPECT_THAT (output, ContainerEq (expected)) << "well_formed=" << well_formed;
+    }
+    {
+      // A container with reserve() but whose only insert() member does not accept a pair of pointers.
+      reserve_only_container<to> output;
+      transcoder_type transcoder;
+      (void)transcoder.end_cp (icubaby::copy (input.begin (), input.end (),
+                                              icubaby::iterator{&transcoder, std::back_inserter (output)}));
+      EXPECT_THAT (output.values, ContainerEq (expected)) << "well_formed=" << well_formed;
+      EXPECT_EQ (output.reserve_calls, 1U);
+    }
+    {
+      // Input that is not contiguous is passed to the transcoder one code unit at a time.
+      std::list<from> const list (input.begin (), input.end ());
+      std::vector<to> output;
+      transcoder_type transcoder;
+      (void)transcoder.end_cp (
+          icubaby::copy (list.begin (), list.end (), icubaby::iterator{&transcoder, std::back_inserter (output)}));
+      EXPECT_THAT (output, ContainerEq (expected)) << "well_formed=" << well_formed;
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, Chunk) {
+  using from = typename TypeParam::from;
+  using to = typename TypeParam::to;
+  using transcoder_type = icubaby::transcoder<from, to>;
+  for (auto const well_formed : {true, false}) {
+    auto const input = make_random_input<from> (well_formed);
+    auto const [expected, expected_well_formed] = convert_per_unit<transcoder_type> (input);
+
+    // Count the ill-formed sequences by resetting the transcoder's "well formed" state after each one.
+    auto expected_errors = 0U;
+    {
+      std::vector<to> sink;
+      transcoder_type transcoder;
+      for (auto const code_unit : input) {
+        (void)transcoder (code_unit, std::back_inserter (sink));
+        if (!transcoder.well_formed ()) {
+          ++expected_errors;
+          transcoder.set_well_formed (true);
+        }
+      }
+    }
+    EXPECT_EQ (expected_errors > 0U, !well_formed);
+
+    // Pass the input in chunks whose boundaries split code points, converting each into a small output buffer.
+    std::vector<to> output;
+    std::array<to, 50> buffer{};
+    transcoder_type transcoder;
+    auto errors = 0U;
+    auto remaining = std::span{input};
+    while (!remaining.empty ()) {
+      auto chunk = remaining.first (std::min (remaining.size (), std::size_t{37}));
+      remaining = remaining.subspan (chunk.size ());
+      while (!chunk.empty ()) {
+        auto const res = icubaby::transcode_chunk (transcoder, chunk, std::span{buffer});
+        EXPECT_EQ (res.partial, transcoder.partial ());
+        switch (res.status) {
+        case icubaby::chunk_status::input_exhausted: EXPECT_EQ (res.consumed, chunk.size ()); break;
+        case icubaby::chunk_status::output_full: EXPECT_LT (res.consumed, chunk.size ()); break;
+        case icubaby::chunk_status::ill_formed: ++errors; break;
+        }
+        output.insert (output.end (), buffer.begin (), buffer.begin () + static_cast<std::ptrdiff_t> (res.produced));
+        chunk = chunk.subspan (res.consumed);
+      }
+    }
+    (void)transcoder.end_cp (std::back_inserter (output));
+    EXPECT_EQ (errors, expected_errors);
+    EXPECT_EQ (transcoder.well_formed (), expected_well_formed);
+    EXPECT_THAT (output, ContainerEq (expected));
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, Errors) {
+  using from = typename TypeParam::from;
+  using to = typename TypeParam::to;
+  using transcoder_type = icubaby::transcoder<from, to>;
+  for (auto const well_formed : {true, false}) {
+    auto const input = make_random_input<from> (well_formed);
+    auto const [expected, expected_well_formed] = convert_per_unit<transcoder_type> (input);
+
+    // Find the offset of each ill-formed sequence by resetting the transcoder's "well formed" state after each one.
+    std::vector<std::size_t> expected_offsets;
+    {
+      std::vector<to> sink;
+      transcoder_type transcoder;
+      for (auto index = std::size_t{0}; index < input.size (); ++index) {
+        (void)transcoder (input[index], std::back_inserter (sink));
+        if (!transcoder.well_formed ()) {
+          expected_offsets.push_back (index);
+          transcoder.set_well_formed (true);
+        }
+      }
+    }
+    EXPECT_EQ (expected_offsets.empty (), well_formed);
+
+    // Convert the input in blocks whose boundaries split code points. Only the first few offsets are kept.
+    std::array<std::size_t, 4> offsets{};
+    icubaby::error_recorder errors{std::span{offsets}};
+    std::vector<to> output (expected.size ());
+    transcoder_type transcoder;
+    auto produced = std::size_t{0};
+    for (auto remaining = std::span{input}; !remaining.empty ();) {
+      auto const block = remaining.first (std::min (remaining.size (), std::size_t{301}));
+      auto const res = icubaby::transcode_errors (transcoder, block, std::span{output}.subspan (produced), errors);
+      EXPECT_EQ (res.consumed, block.size ());
+      EXPECT_EQ (res.partial, transcoder.partial ());
+      produced += res.produced;
+      remaining = remaining.subspan (block.size ());
+    }
+    EXPECT_EQ (errors.end_cp (transcoder, output.begin () + static_cast<std::ptrdiff_t> (produced)), output.end ());
+    EXPECT_EQ (transcoder.well_formed (), expected_well_formed);
+    EXPECT_THAT (output, ContainerEq (expected));
+    EXPECT_EQ (errors.offset (), input.size ());
+    EXPECT_EQ (errors.count (), expected_offsets.size ());
+    EXPECT_EQ (errors.first_error (),
+               expected_offsets.empty () ? icubaby::error_recorder::npos : expected_offsets.front ());
+    auto const kept = std::min (expected_offsets.size (), offsets.size ());
+    EXPECT_THAT (std::vector (errors.offsets ().begin (), errors.offsets ().end ()),
+                 ContainerEq (std::vector (expected_offsets.begin (),
+                                           expected_offsets.begin () + static_cast<std::ptrdiff_t> (kept))));
+  }
+}
+
+// Converts the input with transcode_chunk() in chunks whose boundaries split code points, returning the output, the
+// number of calls that reported ill-formed input, and the transcoder's final "well formed" state.
+template <typename Transcoder, typename InputContainer>
+std::tuple<std::vector<typename Transcoder::output_type>, std::size_t, bool> convert_chunks (
+    InputContainer const& input) {
+  std::vector<typename Transcoder::output_type> output;
+  std::array<typename Transcoder::output_type, 50> buffer{};
+  Transcoder transcoder;
+  auto errors = std::size_t{0};
+  for (auto remaining = std::span{input}; !remaining.empty ();) {
+    auto const res = icubaby::transcode_chunk (
+        transcoder, remaining.first (std::min (remaining.size (), std::size_t{37})), std::span{buffer});
+    if (res.status == icubaby::chunk_status::ill_formed) {
+      ++errors;
+    }
+    output.insert (output.end (), buffer.begin (), buffer.begin () + static_cast<std::ptrdiff_t> (res.produced));
+    remaining = remaining.subspan (res.consumed);
+  }
+  (void)transcoder.end_cp (std::back_inserter (output));
+  return std::make_tuple (std::move (output), errors, transcoder.well_formed ());
+}
+
+// NOLINTNEXTLINE
+TEST (Transcode, ErrorsTruncatedInput) {
+  // U+1F4A9 PILE OF POO missing its final byte.
+  std::array const input{static_cast<icubaby::char8> ('a'), static_cast<icubaby::char8> (0xF0),
+                         static_cast<icubaby::char8> (0x9F), static_cast<icubaby::char8> (0x92)};
+  std::vector<char32_t> output (input.size ());
+  icubaby::error_recorder errors;
+  icubaby::t8_32 transcoder;
+  auto const res = icubaby::transcode_errors (transcoder, std::span{input}, std::span{output}, errors);
+  EXPECT_EQ (res.consumed, input.size ());
+  EXPECT_TRUE (res.partial);
+  EXPECT_TRUE (transcoder.well_formed ());
+  EXPECT_EQ (errors.count (), 0U);
+  auto const end = errors.end_cp (transcoder, output.begin () + static_cast<std::ptrdiff_t> (res.produced));
+  EXPECT_THAT (std::vector (output.begin (), end), ContainerEq (std::vector<char32_t>{'a', icubaby::replacement_char}));
+  EXPECT_FALSE (transcoder.well_formed ());
+  EXPECT_EQ (errors.count (), 1U);
+  EXPECT_EQ (errors.first_error (), input.size ());
+  EXPECT_TRUE (errors.offsets ().empty ());
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, ErrorPolicy) {
+  using from = typename TypeParam::from;
+  using to = typename TypeParam::to;
+  using replace_type = icubaby::transcoder<from, to>;
+  using skip_type = icubaby::transcoder<from, to, icubaby::error_policy::skip>;
+  using stop_type = icubaby::transcoder<from, to, icubaby::error_policy::stop>;
+  using exception_type = icubaby::transcoder<from, to, icubaby::error_policy::exception>;
+  static_assert (replace_type::policy == icubaby::error_policy::replace);
+  static_assert (noexcept (std::declval<replace_type&> ().transcode ({}, {})));
+  static_assert (!noexcept (std::declval<exception_type&> ().transcode ({}, {})));
+
+  for (auto const well_formed : {true, false}) {
+    auto const input = make_random_input<from> (well_formed);
+    auto const [replaced, replaced_well_formed] = convert_per_unit<replace_type> (input);
+    EXPECT_EQ (replaced_well_formed, well_formed);
+
+    // Skip: the output is that of the default policy without the replacement characters.
+    auto const [skipped, skipped_well_formed] = convert_per_unit<skip_type> (input);
+    EXPECT_EQ (skipped_well_formed, well_formed);
+    EXPECT_THAT (skipped, ContainerEq (convert_without_replacements<replace_type> (input, false)));
+    EXPECT_THAT (std::get<0> (convert_bulk<skip_type> (input, 50)), ContainerEq (skipped));
+
+    // Stop: the output ends before the first error and transcode() returns immediately after it.
+    auto const stopped = convert_without_replacements<replace_type> (input, true);
+    EXPECT_THAT (std::get<0> (convert_per_unit<stop_type> (input)), ContainerEq (stopped));
+    std::vector<to> output (replaced.size ());
+    stop_type transcoder;
+    auto const res = transcoder.transcode (std::span{input}, std::span{output});
+    EXPECT_EQ (transcoder.well_formed (), well_formed);
+    EXPECT_EQ (res.consumed < input.size (), !well_formed);
+    EXPECT_TRUE (std::equal (stopped.begin (), stopped.end (), output.begin (),
+                             output.begin () + static_cast<std::ptrdiff_t> (res.produced)));
+    // Once stopped, the remaining input is consumed without producing any output.
+    auto const rest = transcoder.transcode (std::span{input}.subspan (res.consumed), std::span{output});
+    EXPECT_EQ (rest.consumed, input.size () - res.consumed);
+    EXPECT_EQ (rest.produced, well_formed ? replaced.size () - res.produced : 0U);
+
+    // Exception: ill-formed input throws.
+    if (well_formed) {
+      EXPECT_THAT (std::get<0> (convert_bulk<exception_type> (input, 50)), ContainerEq (replaced));
+    } else {
+      EXPECT_THROW ((void)convert_bulk<exception_type> (input, 50), std::range_error);
+      EXPECT_THROW ((void)convert_per_unit<exception_type> (input), std::range_error);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (Transcode, ErrorPolicyChunksAndErrors) {
+  using from = typename TypeParam::from;
+  using to = typename TypeParam::to;
+  using replace_type = icubaby::transcoder<from, to>;
+  using skip_type = icubaby::transcoder<from, to, icubaby::error_policy::skip>;
+  using stop_type = icubaby::transcoder<from, to, icubaby::error_policy::stop>;
+  for (auto const well_formed : {true, false}) {
+    auto const input = make_random_input<from> (well_formed);
+
+    // Find the offset of each ill-formed sequence by resetting the transcoder's "well formed" state after each one.
+    std::vector<std::size_t> expected_offsets;
+    {
+      std::vector<to> sink;
+      replace_type transcoder;
+      for (auto index = std::size_t{0}; index < input.size (); ++index) {
+        (void)transcoder (input[index], std::back_inserter (sink));
+        if (!transcoder.well_formed ()) {
+          expected_offsets.push_back (index);
+          transcoder.set_well_formed (true);
+        }
+      }
+    }
+    auto const skipped = convert_without_replacements<replace_type> (input, false);
+    auto const stopped = convert_without_replacements<replace_type> (input, true);
+
+    // transcode_chunk() reports each error to a skip transcoder but only the first to a stop transcoder.
+    auto const [skip_chunks, skip_chunk_errors, skip_chunks_well_formed] = convert_chunks<skip_type> (input);
+    EXPECT_THAT (skip_chunks, ContainerEq (skipped));
+    EXPECT_EQ (skip_chunk_errors, expected_offsets.size ());
+    EXPECT_EQ (skip_chunks_well_formed, well_formed);
+    auto const [stop_chunks, stop_chunk_errors, stop_chunks_well_formed] = convert_chunks<stop_type> (input);
+    EXPECT_THAT (stop_chunks, ContainerEq (stopped));
+    EXPECT_EQ (stop_chunk_errors, std::min (expected_offsets.size (), std::size_t{1}));
+    EXPECT_EQ (stop_chunks_well_formed, well_formed);
+
+    // transcode_errors() records every error for a skip transcoder. A stop transcoder returns after the first.
+    {
+      std::vector<to> output (input.size () * 4U);
+      icubaby::error_recorder errors;
+      skip_type transcoder;
+      auto const res = icubaby::transcode_errors (transcoder, std::span{input}, std::span{output}, errors);
+      EXPECT_EQ (res.consumed, input.size ());
+      output.erase (errors.end_cp (transcoder, output.begin () + static_cast<std::ptrdiff_t> (res.produced)),
+                    output.end ());
+      EXPECT_THAT (output, ContainerEq (skipped));
+      EXPECT_EQ (errors.count (), expected_offsets.size ());
+      EXPECT_EQ (transcoder.well_formed (), well_formed);
+    }
+    {
+      std::vector<to> output (input.size () * 4U);
+      icubaby::error_recorder errors;
+      stop_type transcoder;
+      auto const res = icubaby::transcode_errors (transcoder, std::span{input}, std::span{output}, errors);
+      EXPECT_EQ (res.consumed, well_formed ? input.size () : expected_offsets.front () + 1U);
+      EXPECT_EQ (transcoder.well_formed (), well_formed);
+      // Once stopped, the remaining input is discarded and no further errors are recorded.
+      auto const rest = icubaby::transcode_errors (transcoder, std::span{input}.subspan (res.consumed),
+                                                   std::span{output}.subspan (res.produced), errors);
+      EXPECT_EQ (rest.consumed, input.size () - res.consumed);
+      EXPECT_EQ (rest.produced, 0U);
+      output.erase (errors.end_cp (transcoder, output.begin () + static_cast<std::ptrdiff_t> (res.produced)),
+                    output.end ());
+      EXPECT_THAT (output, ContainerEq (stopped));
+      EXPECT_EQ (errors.count (), std::min (expected_offsets.size (), std::size_t{1}));
+      EXPECT_EQ (errors.first_error (),
+                 expected_offsets.empty () ? icubaby::error_recorder::npos : expected_offsets.front ());
+      EXPECT_EQ (transcoder.well_formed (), well_formed);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Transcode, ErrorPolicyStopIsNotRestarted) {
+  using transcoder_type = icubaby::transcoder<icubaby::char8, char32_t, icubaby::error_policy::stop>;
+  auto const cu = [] (unsigned value) { return static_cast<icubaby::char8> (value); };
+  std::array const input{cu ('A'), cu ('B'), cu (0xFF), cu ('C'), cu ('D'), cu (0xFF), cu ('E'), cu ('F')};
+  std::vector<char32_t> const expected{'A', 'B'};
+  {
+    std::vector<char32_t> output (input.size ());
+    icubaby::error_recorder errors;
+    transcoder_type transcoder;
+    auto const res = icubaby::transcode_errors (transcoder, std::span{input}, std::span{output}, errors);
+    EXPECT_EQ (res.consumed, 3U);
+    EXPECT_EQ (res.produced, 2U);
+    EXPECT_FALSE (transcoder.well_formed ());
+    EXPECT_EQ (errors.count (), 1U);
+    EXPECT_EQ (errors.first_error (), 2U);
+    output.resize (res.produced);
+    EXPECT_THAT (output, ContainerEq (expected));
+  }
+  {
+    std::array<char32_t, 8> output{};
+    transcoder_type transcoder;
+    auto const first = icubaby::transcode_chunk (transcoder, std::span{input}, std::span{output});
+    EXPECT_EQ (first.status, icubaby::chunk_status::ill_formed);
+    EXPECT_EQ (first.consumed, 3U);
+    EXPECT_EQ (first.produced, 2U);
+    auto const second = icubaby::transcode_chunk (transcoder, std::span{input}.subspan (first.consumed),
+                                                  std::span{output}.subspan (first.produced));
+    EXPECT_EQ (second.status, icubaby::chunk_status::input_exhausted);
+    EXPECT_EQ (second.consumed, input.size () - first.consumed);
+    EXPECT_EQ (second.produced, 0U);
+    EXPECT_FALSE (transcoder.well_formed ());
+  }
+}
+
+namespace {
+
+// A transcoder written outside the library, which has no error policy member.
+struct user_transcoder {
+  using input_type = icubaby::char8;
+  using output_type = char32_t;
+  [[nodiscard]] static constexpr bool well_formed () noexcept { return true; }
+  [[nodiscard]] static constexpr bool partial () noexcept { return false; }
+};
+
+}  // end anonymous namespace
+
+#if ICUBABY_HAVE_CONCEPTS
+static_assert (icubaby::is_transcoder<user_transcoder>);
+#endif  // ICUBABY_HAVE_CONCEPTS
+static_assert (icubaby::details::policy_of<user_transcoder> == icubaby::error_policy::replace);
+static_assert (icubaby::details::policy_of<icubaby::transcoder<char16_t, char32_t, icubaby::error_policy::stop>> ==
+               icubaby::error_policy::stop);
+
+// NOLINTNEXTLINE
+TEST (Transcode, Utf8AsciiRuns) {
+  using transcoder_type = icubaby::transcoder<icubaby::char8, char32_t>;
+  auto const cu = [] (unsigned value) { return static_cast<icubaby::char8> (value); };
+  // Runs of ASCII code units of every length up to a few multiples of the largest vector width, each followed by a
+  // different non-ASCII sequence.
+  std::vector<std::vector<icubaby::char8>> const separators{
+      encode<icubaby::char8> (char32_t{0x00A2}), encode<icubaby::char8> (char32_t{0x1F4A9}), {cu (0xFF)}, {cu (0xE0)}};
+  std::vector<icubaby::char8> input;
+  for (auto length = std::size_t{0}; length < 100U; ++length) {
+    for (auto index = std::size_t{0}; index < length; ++index) {
+      input.push_back (cu ('a' + index % 26U));
+    }
+    auto const& sep = separators[length % separators.size ()];
+    input.insert (input.end (), sep.begin (), sep.end ());
+  }
+  auto const [expected, expected_well_formed] = convert_per_unit<transcoder_type> (input);
+  for (auto const capacity : {std::size_t{1}, std::size_t{15}, std::size_t{33}, std::size_t{4096}}) {
+    auto const [actual, actual_well_formed] = convert_bulk<transcoder_type> (input, capacity);
+    EXPECT_EQ (actual_well_formed, expected_well_formed) << "capacity=" << capacity;
+    EXPECT_THAT (actual, ContainerEq (expected)) << "capacity=" << capacity;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Transcode, Utf16SurrogatesInBmpRuns) {
+  using transcoder_type = icubaby::transcoder<char16_t, icubaby::char8>;
+  // Runs of one, two, and three byte code points with a surrogate pair, an unpaired high surrogate, or an unpaired
+  // low surrogate placed at every offset within a vector block.
+  std::vector<std::vector<char16_t>> const surrogates{
+      {char16_t{0xD83D}, char16_t{0xDCA9}}, {char16_t{0xD800}}, {char16_t{0xDFFF}}};
+  std::array<char16_t, 4> const bmp{{char16_t{'a'}, char16_t{0x00A2}, char16_t{0x0800}, char16_t{0xFFFD}}};
+  std::vector<char16_t> input;
+  for (auto offset = std::size_t{0}; offset < 40U; ++offset) {
+    for (auto index = std::size_t{0}; index < offset; ++index) {
+      input.push_back (bmp[(offset + index) % bmp.size ()]);
+    }
+    auto const& sep = surrogates[offset % surrogates.size ()];
+    input.insert (input.end (), sep.begin (), sep.end ());
+  }
+  auto const [expected, expected_well_formed] = convert_per_unit<transcoder_type> (input);
+  for (auto const capacity : {std::size_t{6}, std::size_t{31}, std::size_t{33}, std::size_t{4096}}) {
+    auto const [actual, actual_well_formed] = convert_bulk<transcoder_type> (input, capacity);
+    EXPECT_EQ (actual_well_formed, expected_well_formed) << "capacity=" << capacity;
+    EXPECT_THAT (actual, ContainerEq (expected)) << "capacity=" << capacity;
+  }
+}
+
+namespace {
+
+template <typename T> class TranscodeBytes : public testing::Test {};
+
+}  // end anonymous namespace
+
+TYPED_TEST_SUITE (TranscodeBytes, OutputTypes, OutputTypeNames);
+
+// NOLINTNEXTLINE
+TYPED_TEST (TranscodeBytes, MatchesPerUnit) {
+  using transcoder_type = icubaby::transcoder<std::byte, TypeParam>;
+  // UTF-16 BE with a byte order mark.
+  std::vector<std::byte> input{std::byte{0xFE}, std::byte{0xFF}};
+  for (auto const code_unit : make_input<char16_t> (false)) {
+    input.push_back (static_cast<std::byte> (static_cast<unsigned> (code_unit) >> 8U));
+    input.push_back (static_cast<std::byte> (static_cast<unsigned> (code_unit) & 0xFFU));
+  }
+  auto const [expected, expected_well_formed] = convert_per_unit<transcoder_type> (input);
+  EXPECT_FALSE (expected_well_formed);
+  for (auto const capacity : {std::size_t{16}, std::size_t{17}, std::size_t{64}, std::size_t{4096}}) {
+    auto const [actual, actual_well_formed] = convert_bulk<transcoder_type> (input, capacity);
+    EXPECT_EQ (actual_well_formed, expected_well_formed) << "capacity=" << capacity;
+    EXPECT_THAT (actual, ContainerEq (expected)) << "capacity=" << capacity;
+  }
+}
+
+namespace {
+
+// Serializes code units as bytes in the given byte order, optionally preceded by a byte order mark.
+template <typename Encoding>
+std::vector<std::byte> to_bytes (std::vector<Encoding> const& code_units, bool const little_endian, bool const bom) {
+  std::vector<std::byte> result;
+  auto const append = [&result, little_endian] (std::uint_least32_t const value) {
+    for (auto index = std::size_t{0}; index < sizeof (Encoding); ++index) {
+      auto const shift = 8U * (little_endian ? index : sizeof (Encoding) - 1U - index);
+      result.push_back (static_cast<std::byte> ((value >> shift) & 0xFFU));
+    }
+  };
+  if (bom) {
+    for (auto const code_unit : encode<Encoding> (icubaby::byte_order_mark)) {
+      append (static_cast<std::uint_least32_t> (code_unit));
+    }
+  }
+  for (auto const code_unit : code_units) {
+    append (static_cast<std::uint_least32_t> (code_unit));
+  }
+  return result;
+}
+
+// Converts the input by passing it to the transcoder's transcode() member function in chunks of 'chunk' bytes.
+template <typename Transcoder>
+std::vector<typename Transcoder::output_type> convert_chunks (std::vector<std::byte> const& input,
+                                                              std::size_t const chunk) {
+  std::vector<typename Transcoder::output_type> output (input.size () * 4U + 16U);
+  Transcoder transcoder;
+  auto produced = std::size_t{0};
+  for (auto pos = std::size_t{0}; pos < input.size (); pos += chunk) {
+    auto const in = std::span{input}.subspan (pos, std::min (chunk, input.size () - pos));
+    auto const res = transcoder.transcode (in, std::span{output}.subspan (produced));
+    EXPECT_EQ (res.consumed, in.size ());
+    produced += res.produced;
+  }
+  auto const end = transcoder.end_cp (output.begin () + static_cast<std::ptrdiff_t> (produced));
+  output.erase (end, output.end ());
+  return output;
+}
+
+template <typename Transcoder> void check_byte_input (std::vector<std::byte> const& input) {
+  auto const [expected, expected_well_formed] = convert_per_unit<Transcoder> (input);
+  for (auto const capacity : {std::size_t{16}, std::size_t{17}, std::size_t{4096}}) {
+    auto const [actual, actual_well_formed] = convert_bulk<Transcoder> (input, capacity);
+    EXPECT_EQ (actual_well_formed, expected_well_formed) << "capacity=" << capacity;
+    EXPECT_THAT (actual, ContainerEq (expected)) << "capacity=" << capacity;
+  }
+  for (auto const chunk : {std::size_t{1}, std::size_t{7}, std::size_t{1000}}) {
+    EXPECT_THAT (convert_chunks<Transcoder> (input, chunk), ContainerEq (expected)) << "chunk=" << chunk;
+  }
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TYPED_TEST (TranscodeBytes, EveryEncodingMatchesPerUnit) {
+  using transcoder_type = icubaby::transcoder<std::byte, TypeParam>;
+  for (auto const well_formed : {true, false}) {
+    auto const utf8 = make_random_input<icubaby::char8> (well_formed);
+    auto const utf16 = make_random_input<char16_t> (well_formed);
+    auto const utf32 = make_random_input<char32_t> (well_formed);
+    check_byte_input<transcoder_type> (to_bytes (utf8, false, false));
+    check_byte_input<transcoder_type> (to_bytes (utf8, false, true));
+    for (auto const little_endian : {false, true}) {
+      check_byte_input<transcoder_type> (to_bytes (utf16, little_endian, true));
+      check_byte_input<transcoder_type> (to_bytes (utf32, little_endian, true));
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (TranscodeBytes, ErrorPolicy) {
+  using skip_type = icubaby::transcoder<std::byte, TypeParam, icubaby::error_policy::skip>;
+  using stop_type = icubaby::transcoder<std::byte, TypeParam, icubaby::error_policy::stop>;
+  auto const utf16 = make_random_input<char16_t> (false);
+  for (auto const little_endian : {false, true}) {
+    auto const input = to_bytes (utf16, little_endian, true);
+    check_byte_input<skip_type> (input);
+    // The policy is passed on to the transcoder for the detected input encoding.
+    EXPECT_THAT (std::get<0> (convert_per_unit<skip_type> (input)),
+                 ContainerEq (std::get<0> (
+                     convert_per_unit<icubaby::transcoder<char16_t, TypeParam, icubaby::error_policy::skip>> (utf16))));
+
+    std::vector<TypeParam> output (input.size () * 2U);
+    stop_type transcoder;
+    auto const res = transcoder.transcode (std::span{input}, std::span{output});
+    EXPECT_FALSE (transcoder.well_formed ());
+    EXPECT_LT (res.consumed, input.size ());
+    // transcode_chunk() does not restart the stopped transcoder.
+    auto const rest =
+        icubaby::transcode_chunk (transcoder, std::span{input}.subspan (res.consumed), std::span{output});
+    EXPECT_EQ (rest.consumed, input.size () - res.consumed);
+    EXPECT_EQ (rest.produced, 0U);
+    EXPECT_FALSE (transcoder.well_formed ());
+    output.resize (res.produced);
+    EXPECT_THAT (output, ContainerEq (std::get<0> (
+                             convert_per_unit<icubaby::transcoder<char16_t, TypeParam, icubaby::error_policy::stop>> (
+                                 utf16))));
+  }
+}
+
+// NOLINTNEXTLINE
+TYPED_TEST (TranscodeBytes, TranscodeLines) {
+  using transcoder_type = icubaby::transcoder<std::byte, TypeParam>;
+  // UTF-16 LE with a byte order mark.
+  std::vector<std::byte> input{std::byte{0xFF}, std::byte{0xFE}};
+  for (auto const code_unit : add_line_endings (make_random_input<char16_t> (true))) {
+    input.push_back (static_cast<std::byte> (static_cast<unsigned> (code_unit) & 0xFFU));
+    input.push_back (static_cast<std::byte> (static_cast<unsigned> (code_unit) >> 8U));
+  }
+  check_transcode_lines<transcoder_type> (input, icubaby::line_endings::lf);
+  check_transcode_lines<transcoder_type> (input, icubaby::line_endings::any);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+#endif  // ICUBABY_HAVE_SPAN
@@ -283,6 +283,44 @@ TYPED_TEST (Utf16, LonelyHighSurrogate) {
   EXPECT_THAT (output, ElementsAreArray (encoded_char_v<code_point::replacement_char, TypeParam>));
 }
 
+// NOLINTNEXTLINE
+TEST (Utf16To8, MatchesTriangulator) {
+  // The UTF-16 to UTF-8 transcoder converts directly between the two encodings. Check that its behavior exactly matches
+  // conversion via UTF-32 for every single code unit and for sequences of code units drawn from a set which covers the
+  // boundaries of each UTF-8 encoding length and of the surrogate ranges.
+  constexpr std::array const interesting{
+      char16_t{0x0000}, char16_t{0x007F}, char16_t{0x0080}, char16_t{0x07FF}, char16_t{0x0800}, char16_t{0xD7FF},
+      char16_t{0xD800}, char16_t{0xDBFF}, char16_t{0xDC00}, char16_t{0xDFFF}, char16_t{0xE000}, char16_t{0xFFFF},
+  };
+  auto const check = [] (std::vector<char16_t> const& input) {
+    icubaby::t16_8 direct;
+    icubaby::details::triangulator<char16_t, icubaby::char8> indirect;
+    std::vector<icubaby::char8> direct_out;
+    std::vector<icubaby::char8> indirect_out;
+    for (auto const cu : input) {
+      (void)direct (cu, std::back_inserter (direct_out));
+      (void)indirect (cu, std::back_inserter (indirect_out));
+      ASSERT_EQ (direct.partial (), indirect.partial ());
+      ASSERT_EQ (direct.well_formed (), indirect.well_formed ());
+    }
+    (void)direct.end_cp (std::back_inserter (direct_out));
+    (void)indirect.end_cp (std::back_inserter (indirect_out));
+    EXPECT_EQ (direct.well_formed (), indirect.well_formed ());
+    EXPECT_EQ (direct_out, indirect_out);
+  };
+  for (auto cu = 0U; cu <= 0xFFFFU; ++cu) {
+    check ({static_cast<char16_t> (cu)});
+    check ({char16_t{0xD83D}, static_cast<char16_t> (cu)});
+  }
+  for (auto const cu0 : interesting) {
+    for (auto const cu1 : interesting) {
+      for (auto const cu2 : interesting) {
+        check ({cu0, cu1, cu2});
+      }
+    }
+  }
+}
+
 #if ICUBABY_FUZZTEST
 
 template <typename OutputEncoding>
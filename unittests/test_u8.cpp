@@ -26,6 +26,7 @@
 // standard library
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <iterator>
@@ -610,6 +611,149 @@ TYPED_TEST (Utf8, RangesCompose) {
   expected_out = append<code_point::digit_three, TypeParam> (expected_out);
   EXPECT_THAT (output, ContainerEq (expected));
 }
+// NOLINTNEXTLINE
+TYPED_TEST (Utf8, RangesLongInput) {
+  auto& output = this->output_;
+
+  // Enough input to need many blocks of output from a contiguous range, including an ill-formed sequence.
+  std::vector<icubaby::char8> src;
+  auto src_out = std::back_inserter (src);
+  for (auto index = 0U; index < 100U; ++index) {
+    src_out = append<code_point::hiragana_letter_ko, icubaby::char8> (src_out);
+    src_out = append<code_point::digit_one, icubaby::char8> (src_out);
+    src_out = append<code_point::cjk_unified_ideograph_754c, icubaby::char8> (src_out);
+    src_out = append<code_point::line_feed, icubaby::char8> (src_out);
+  }
+  src.push_back (static_cast<icubaby::char8> (0xC3));
+  for (auto index = 0U; index < 100U; ++index) {
+    src_out = append<code_point::digit_two, icubaby::char8> (src_out);
+  }
+
+  auto const range = src | icubaby::views::transcode<char8_t, TypeParam>;
+  (void)std::ranges::copy (range, std::back_inserter (output));
+  EXPECT_FALSE (range.well_formed ());
+
+  std::vector<TypeParam> expected;
+  icubaby::transcoder<icubaby::char8, TypeParam> transcoder;
+  auto expected_out = std::back_inserter (expected);
+  for (auto const code_unit : src) {
+    expected_out = transcoder (code_unit, expected_out);
+  }
+  (void)transcoder.end_cp (expected_out);
+  EXPECT_THAT (output, ContainerEq (expected));
+
+  // Iterators referencing different positions within the same block of output must not compare equal.
+  EXPECT_EQ (static_cast<std::size_t> (std::ranges::distance (range)), expected.size ());
+  EXPECT_NE (std::ranges::next (range.begin ()), range.begin ());
+}
+// NOLINTNEXTLINE
+TYPED_TEST (Utf8, RangesReverse) {
+  std::vector<icubaby::char8> src;
+  auto src_out = std::back_inserter (src);
+  for (auto index = 0U; index < 200U; ++index) {
+    src_out = append<code_point::hiragana_letter_ko, icubaby::char8> (src_out);
+    src_out = append<code_point::digit_one, icubaby::char8> (src_out);
+    src_out = append<code_point::gothic_letter_hwair, icubaby::char8> (src_out);
+  }
+
+  auto const check = [] (auto const& range) {
+    static_assert (std::ranges::bidirectional_range<decltype (range)>);
+    std::vector<TypeParam> expected;
+    (void)std::ranges::copy (range, std::back_inserter (expected));
+    std::ranges::reverse (expected);
+
+    std::vector<TypeParam> output;
+    (void)std::ranges::copy (range | std::views::reverse, std::back_inserter (output));
+    EXPECT_THAT (output, ContainerEq (expected));
+
+    // An iterator reached by decrementing compares equal to one reached by incrementing.
+    auto const last = std::ranges::prev (range.end ());
+    EXPECT_EQ (last, std::ranges::next (range.begin (), static_cast<std::ptrdiff_t> (expected.size () - 1U)));
+    EXPECT_EQ (*last, expected.front ());
+    EXPECT_EQ (std::ranges::next (last), range.end ());
+  };
+  // A contiguous range is converted in blocks when incrementing.
+  check (src | icubaby::views::transcode<char8_t, TypeParam>);
+  // Other ranges are converted one code point at a time.
+  check (src | std::views::transform ([] (icubaby::char8 const code_unit) { return code_unit; }) |
+         icubaby::views::transcode<char8_t, TypeParam>);
+}
+#if ICUBABY_HAVE_SPAN
+// NOLINTNEXTLINE
+TYPED_TEST (Utf8, RangesOutputSize) {
+  std::vector<icubaby::char8> src;
+  auto src_out = std::back_inserter (src);
+  for (auto index = 0U; index < 100U; ++index) {
+    src_out = append<code_point::hiragana_letter_ko, icubaby::char8> (src_out);
+    src_out = append<code_point::digit_one, icubaby::char8> (src_out);
+    src_out = append<code_point::gothic_letter_hwair, icubaby::char8> (src_out);
+  }
+  src.push_back (static_cast<icubaby::char8> (0xC3));
+
+  auto const range = src | icubaby::views::transcode<char8_t, TypeParam>;
+  // output_size() visits all of the input so it must not make the view a sized_range.
+  static_assert (!std::ranges::sized_range<decltype (range)>);
+  std::vector<TypeParam> expected;
+  (void)std::ranges::copy (range, std::back_inserter (expected));
+  EXPECT_EQ (range.output_size (), expected.size ());
+
+  std::vector<TypeParam> out;
+  (void)icubaby::copy (range, std::back_inserter (out));
+  EXPECT_THAT (out, ContainerEq (expected));
+  EXPECT_EQ (out.capacity (), expected.size ());
+
+  auto const empty = std::vector<icubaby::char8>{} | icubaby::views::transcode<char8_t, TypeParam>;
+  EXPECT_EQ (empty.output_size (), 0U);
+
+  // A view whose input is not contiguous has no output_size() but can still be copied.
+  auto const transformed = src | std::views::transform ([] (icubaby::char8 const code_unit) { return code_unit; }) |
+                           icubaby::views::transcode<char8_t, TypeParam>;
+  static_assert (!requires { transformed.output_size (); });
+  std::vector<TypeParam> out2;
+  (void)icubaby::copy (transformed, std::back_inserter (out2));
+  EXPECT_THAT (out2, ContainerEq (expected));
+}
+#endif  // ICUBABY_HAVE_SPAN
+#if ICUBABY_HAVE_SPAN
+// NOLINTNEXTLINE
+TYPED_TEST (Utf8, RangesChunks) {
+  std::vector<icubaby::char8> src;
+  auto src_out = std::back_inserter (src);
+  for (auto index = 0U; index < 200U; ++index) {
+    src_out = append<code_point::hiragana_letter_ko, icubaby::char8> (src_out);
+    src_out = append<code_point::digit_one, icubaby::char8> (src_out);
+    src_out = append<code_point::gothic_letter_hwair, icubaby::char8> (src_out);
+  }
+  // End with an incomplete code point.
+  src.push_back (static_cast<icubaby::char8> (0xC3));
+
+  std::vector<TypeParam> expected;
+  (void)std::ranges::copy (src | icubaby::views::transcode<char8_t, TypeParam>, std::back_inserter (expected));
+
+  auto const check = [&expected] (auto const& chunks) {
+    using chunks_type = std::remove_cvref_t<decltype (chunks)>;
+    std::vector<TypeParam> output;
+    auto count = 0U;
+    for (auto const chunk : chunks) {
+      EXPECT_FALSE (chunk.empty ());
+      EXPECT_LE (chunk.size (), chunks_type::chunk_size);
+      output.insert (output.end (), chunk.begin (), chunk.end ());
+      ++count;
+    }
+    EXPECT_GT (count, 1U);
+    EXPECT_FALSE (chunks.well_formed ());
+    EXPECT_THAT (output, ContainerEq (expected));
+  };
+  // A contiguous range is converted using the transcoder's transcode() member function.
+  check (src | icubaby::views::transcode_chunks<char8_t, TypeParam>);
+  // Other ranges are converted one code unit at a time.
+  check (src | std::views::transform ([] (icubaby::char8 const code_unit) { return code_unit; }) |
+         icubaby::views::transcode_chunks<char8_t, TypeParam>);
+
+  auto const empty = std::vector<icubaby::char8>{} | icubaby::views::transcode_chunks<char8_t, TypeParam>;
+  EXPECT_EQ (empty.begin (), empty.end ());
+}
+#endif  // ICUBABY_HAVE_SPAN
 
 #endif  // __cpp_lib_ranges
 
@@ -629,6 +773,48 @@ TEST (Utf8To32, RangesBadInput) {
 }
 #endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
 
+// NOLINTNEXTLINE
+TEST (Utf8To16, MatchesTriangulator) {
+  // The UTF-8 to UTF-16 transcoder converts directly between the two encodings. Check that its behavior exactly matches
+  // conversion via UTF-32 for every sequence of one or two bytes and for sequences of three and four bytes drawn from a
+  // set which covers each row of the well-formed UTF-8 byte sequence table.
+  constexpr std::array const interesting{0x00, 0x41, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1,
+                                         0xC2, 0xDF, 0xE0, 0xE1, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF4, 0xF5, 0xFF};
+  auto const check = [] (std::vector<icubaby::char8> const& input) {
+    icubaby::t8_16 direct;
+    icubaby::details::triangulator<icubaby::char8, char16_t> indirect;
+    std::vector<char16_t> direct_out;
+    std::vector<char16_t> indirect_out;
+    for (auto const cu : input) {
+      (void)direct (cu, std::back_inserter (direct_out));
+      (void)indirect (cu, std::back_inserter (indirect_out));
+      ASSERT_EQ (direct.partial (), indirect.partial ());
+      ASSERT_EQ (direct.well_formed (), indirect.well_formed ());
+    }
+    (void)direct.end_cp (std::back_inserter (direct_out));
+    (void)indirect.end_cp (std::back_inserter (indirect_out));
+    EXPECT_EQ (direct.well_formed (), indirect.well_formed ());
+    EXPECT_THAT (direct_out, ContainerEq (indirect_out));
+  };
+  auto const cu = [] (unsigned const value) { return static_cast<icubaby::char8> (value); };
+  for (auto last = 0U; last < 256U; ++last) {
+    check ({cu (last)});
+    for (auto const b0 : interesting) {
+      check ({cu (b0), cu (last)});
+    }
+  }
+  for (auto const b0 : interesting) {
+    for (auto const b1 : interesting) {
+      for (auto const b2 : interesting) {
+        check ({cu (b0), cu (b1), cu (b2)});
+        for (auto const b3 : interesting) {
+          check ({cu (b0), cu (b1), cu (b2), cu (b3)});
+        }
+      }
+    }
+  }
+}
+
 #if ICUBABY_FUZZTEST
 
 template <typename OutputEncoding>
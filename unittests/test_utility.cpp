@@ -20,10 +20,12 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <iterator>
 #include <limits>
+#include <list>
 #include <vector>
 
 // icubaby itself.
@@ -192,6 +194,27 @@ TYPED_TEST (Hiragana, Length) {
   EXPECT_EQ (9U, icubaby::length (std::begin (this->code_units), std::end (this->code_units)));
 }
 // NOLINTNEXTLINE
+TYPED_TEST (Hiragana, LengthLongerThanVectorBlocks) {
+  // Build an input that is long enough to exercise the vector loops and their accumulator flushes, mixing ASCII with
+  // multi-unit code points so that the blocks do not align with code point boundaries.
+  std::vector<TypeParam> input;
+  for (auto ctr = 0; ctr < 3000; ++ctr) {
+    input.push_back (static_cast<TypeParam> ('a' + ctr % 26));
+    input.insert (std::end (input), std::begin (this->code_units), std::end (this->code_units));
+  }
+  auto const expected = 3000 * (1 + 9);
+  EXPECT_EQ (expected, icubaby::length (std::begin (input), std::end (input)));
+  // A std::list is not contiguous so takes the code unit by code unit path.
+  std::list<TypeParam> const list (std::begin (input), std::end (input));
+  EXPECT_EQ (expected, icubaby::length (std::begin (list), std::end (list)));
+  // Every prefix length up to a few vector blocks must agree with the generic count.
+  for (auto size = std::size_t{0}; size < 100; ++size) {
+    auto const last = std::next (std::begin (input), static_cast<std::ptrdiff_t> (size));
+    auto const is_start = [] (TypeParam const code_unit) { return icubaby::is_code_point_start (code_unit); };
+    EXPECT_EQ (std::count_if (std::begin (input), last, is_start), icubaby::length (std::begin (input), last));
+  }
+}
+// NOLINTNEXTLINE
 TYPED_TEST (Hiragana, Index) {
   auto begin = std::begin (this->code_units);
   auto end = std::end (this->code_units);
@@ -254,6 +277,215 @@ TYPED_TEST (CjkUnifiedIdeographCodePoints, Index) {
   EXPECT_EQ (end, icubaby::index (begin, end, size_t{4}));
 }
 
+namespace {
+
+template <typename T> class CodePointIndex : public testing::Test {
+protected:
+  CodePointIndex () {
+    // A mixture of one, two, three, and four code unit UTF-8 sequences so that blocks of code units do not align with
+    // code point boundaries.
+    for (auto ctr = 0U; ctr < 1000U; ++ctr) {
+      auto pos = std::back_inserter (text_);
+      pos = append<code_point::dollar_sign, T> (pos);
+      if (ctr % 3U == 0U) {
+        pos = append<code_point::cent_sign, T> (pos);
+      }
+      if (ctr % 5U == 0U) {
+        pos = append<code_point::hiragana_letter_go, T> (pos);
+      }
+      if (ctr % 7U == 0U) {
+        (void)append<code_point::linear_b_syllable_b008_a, T> (pos);
+      }
+    }
+  }
+
+  // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+  std::vector<T> text_;
+};
+
+}  // end anonymous namespace
+
+TYPED_TEST_SUITE (CodePointIndex, OutputTypes, OutputTypeNames);
+// NOLINTNEXTLINE
+TYPED_TEST (CodePointIndex, MatchesIndex) {
+  auto const& text = this->text_;
+  for (auto const interval : {std::size_t{1}, std::size_t{7}, std::size_t{64}, std::size_t{1000}}) {
+    icubaby::code_point_index<TypeParam, std::vector<std::size_t>> cpi{interval};
+    // Add the text in chunks of varying sizes to check that the index is built incrementally.
+    auto first = std::begin (text);
+    for (auto chunk = std::ptrdiff_t{1}; first != std::end (text); chunk = chunk * 3 % 199 + 1) {
+      auto const last = std::next (first, std::min (chunk, std::distance (first, std::end (text))));
+      cpi.append (text.data () + std::distance (std::begin (text), first),
+                  text.data () + std::distance (std::begin (text), last));
+      first = last;
+    }
+    auto const length = icubaby::length (std::begin (text), std::end (text));
+    EXPECT_EQ (cpi.code_units (), text.size ());
+    EXPECT_EQ (cpi.code_points (), static_cast<std::size_t> (length));
+    EXPECT_EQ (cpi.checkpoints ().size (), (cpi.code_points () + interval - 1) / interval);
+    for (auto pos = std::size_t{0}; pos <= cpi.code_points () + 1; ++pos) {
+      EXPECT_EQ (icubaby::index (std::begin (text), std::end (text), pos),
+                 cpi.index (std::begin (text), std::end (text), pos))
+          << "pos=" << pos << " interval=" << interval;
+    }
+  }
+}
+// NOLINTNEXTLINE
+TYPED_TEST (CodePointIndex, ManyCheckpointsInOneAppend) {
+  // ASCII text followed by copies of the mixed text so that a single append() skips many blocks between checkpoints.
+  std::vector<TypeParam> text (10000, TypeParam{'a'});
+  for (auto copy = 0; copy < 10; ++copy) {
+    text.insert (text.end (), this->text_.begin (), this->text_.end ());
+  }
+  for (auto const interval : {std::size_t{1}, std::size_t{7}, std::size_t{64}, std::size_t{100}, std::size_t{1000}}) {
+    icubaby::code_point_index<TypeParam, std::vector<std::size_t>> expected{interval};
+    for (auto const code_unit : text) {
+      expected (code_unit);
+    }
+    icubaby::code_point_index<TypeParam, std::vector<std::size_t>> cpi{interval};
+    cpi.append (text.data (), text.data () + text.size ());
+    EXPECT_EQ (expected.code_units (), cpi.code_units ()) << "interval=" << interval;
+    EXPECT_EQ (expected.code_points (), cpi.code_points ()) << "interval=" << interval;
+    EXPECT_EQ (expected.checkpoints (), cpi.checkpoints ()) << "interval=" << interval;
+  }
+}
+// NOLINTNEXTLINE
+TYPED_TEST (CodePointIndex, MutablePointers) {
+  auto const& text = this->text_;
+  icubaby::code_point_index<TypeParam, std::vector<std::size_t>> expected{16};
+  expected.append (std::begin (text), std::end (text));
+
+  // Append through pointers to non-const code units.
+  std::vector<TypeParam> mutable_text = text;
+  icubaby::code_point_index<TypeParam, std::vector<std::size_t>> cpi{16};
+  cpi.append (mutable_text.data (), mutable_text.data () + mutable_text.size ());
+  EXPECT_EQ (expected.code_units (), cpi.code_units ());
+  EXPECT_EQ (expected.code_points (), cpi.code_points ());
+  EXPECT_EQ (expected.checkpoints (), cpi.checkpoints ());
+}
+// NOLINTNEXTLINE
+TYPED_TEST (CodePointIndex, Substr) {
+  auto const& text = this->text_;
+  icubaby::code_point_index<TypeParam, std::vector<std::size_t>> cpi{16};
+  cpi.append (std::begin (text), std::end (text));
+  for (auto const pos : {std::size_t{0}, std::size_t{5}, std::size_t{100}, cpi.code_points () - 1}) {
+    for (auto const count : {std::size_t{0}, std::size_t{1}, std::size_t{15}, std::size_t{16}, std::size_t{500}}) {
+      auto const [begin, end] = cpi.substr (std::begin (text), std::end (text), pos, count);
+      auto const expected_begin = icubaby::index (std::begin (text), std::end (text), pos);
+      EXPECT_EQ (expected_begin, begin);
+      EXPECT_EQ (icubaby::index (expected_begin, std::end (text), count), end);
+    }
+  }
+  auto const [begin, end] = cpi.substr (std::begin (text), std::end (text), cpi.code_points (), 1);
+  EXPECT_EQ (std::end (text), begin);
+  EXPECT_EQ (std::end (text), end);
+
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+  icubaby::code_point_index<TypeParam, std::vector<std::size_t>> cpi2{16};
+  cpi2.append (text);
+  EXPECT_EQ (cpi.checkpoints (), cpi2.checkpoints ());
+  EXPECT_EQ (cpi.index (std::begin (text), std::end (text), 100), cpi2.index (text, 100));
+  auto const sub = cpi2.substr (text, 100, 20);
+  EXPECT_EQ (20, icubaby::length (sub));
+#endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+  cpi.clear ();
+  EXPECT_EQ (0U, cpi.code_units ());
+  EXPECT_EQ (0U, cpi.code_points ());
+  EXPECT_TRUE (cpi.checkpoints ().empty ());
+}
+
+namespace {
+
+template <typename T> class OffsetIndex : public testing::Test {
+protected:
+  OffsetIndex () {
+    boundaries_.emplace_back ();
+    for (auto ctr = 0U; ctr < 500U; ++ctr) {
+      this->add<code_point::dollar_sign> ();
+      if (ctr % 3U == 0U) {
+        this->add<code_point::cent_sign> ();
+      }
+      if (ctr % 5U == 0U) {
+        this->add<code_point::hiragana_letter_go> ();
+      }
+      if (ctr % 7U == 0U) {
+        this->add<code_point::linear_b_syllable_b008_a> ();
+      }
+    }
+  }
+
+  // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+  std::vector<T> text_;
+  /// The offsets of each code point boundary in text_.
+  std::vector<icubaby::offsets> boundaries_;
+  // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+private:
+  template <code_point C> void add () {
+    (void)append<C, T> (std::back_inserter (text_));
+    auto next = boundaries_.back ();
+    next.utf8 += encoded_char<C, icubaby::char8>::value.size ();
+    next.utf16 += encoded_char<C, char16_t>::value.size ();
+    next.utf32 += encoded_char<C, char32_t>::value.size ();
+    boundaries_.push_back (next);
+  }
+};
+
+template <typename From, typename T>
+void check_offsets (icubaby::offset_index<T, std::vector<icubaby::offsets>> const& oi, std::vector<T> const& text,
+                    std::vector<icubaby::offsets> const& boundaries) {
+  for (auto it = std::begin (boundaries); it != std::end (boundaries); ++it) {
+    auto const offset = it->template get<From> ();
+    EXPECT_EQ (*it, oi.template locate<From> (std::begin (text), std::end (text), offset)) << "offset=" << offset;
+    // An offset within a code point is rounded down to its start.
+    if (auto const next = std::next (it); next != std::end (boundaries) && next->template get<From> () > offset + 1) {
+      EXPECT_EQ (*it, oi.template locate<From> (std::begin (text), std::end (text), offset + 1))
+          << "offset=" << offset + 1;
+    }
+  }
+  auto const end = boundaries.back ().template get<From> ();
+  EXPECT_EQ (boundaries.back (), oi.template locate<From> (std::begin (text), std::end (text), end + 100));
+}
+
+}  // end anonymous namespace
+
+TYPED_TEST_SUITE (OffsetIndex, OutputTypes, OutputTypeNames);
+// NOLINTNEXTLINE
+TYPED_TEST (OffsetIndex, Locate) {
+  auto const& text = this->text_;
+  for (auto const interval : {std::size_t{1}, std::size_t{5}, std::size_t{64}, std::size_t{100000}}) {
+    icubaby::offset_index<TypeParam, std::vector<icubaby::offsets>> oi{interval};
+    // Add the text in two parts to check that the index is built incrementally.
+    auto const mid = std::next (std::begin (text), static_cast<std::ptrdiff_t> (text.size () / 2));
+    oi.append (std::begin (text), mid);
+    oi.append (mid, std::end (text));
+    EXPECT_EQ (this->boundaries_.back (), oi.size ());
+
+    check_offsets<icubaby::char8> (oi, text, this->boundaries_);
+    check_offsets<char16_t> (oi, text, this->boundaries_);
+    check_offsets<char32_t> (oi, text, this->boundaries_);
+  }
+}
+// NOLINTNEXTLINE
+TYPED_TEST (OffsetIndex, Convert) {
+  auto const& text = this->text_;
+  icubaby::offset_index<TypeParam, std::vector<icubaby::offsets>> oi{32};
+  oi.append (std::begin (text), std::end (text));
+  auto const& b = this->boundaries_.at (321);
+  EXPECT_EQ (b.utf16, (oi.template convert<icubaby::char8, char16_t> (std::begin (text), std::end (text), b.utf8)));
+  EXPECT_EQ (b.utf8, (oi.template convert<char16_t, icubaby::char8> (std::begin (text), std::end (text), b.utf16)));
+  EXPECT_EQ (b.utf32, (oi.template convert<icubaby::char8, char32_t> (std::begin (text), std::end (text), b.utf8)));
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+  EXPECT_EQ (b.utf8, (oi.template convert<char32_t, icubaby::char8> (text, b.utf32)));
+  EXPECT_EQ (b, oi.template locate<char16_t> (text, b.utf16));
+#endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+  oi.clear ();
+  EXPECT_EQ (icubaby::offsets{}, oi.size ());
+  EXPECT_TRUE (oi.checkpoints ().empty ());
+}
+
 #if ICUBABY_FUZZTEST && ICUBABY_HAVE_RANGES
 
 template <typename InputEncoding> static void LengthRangeAndIteratorSentinel (std::vector<InputEncoding> const& input) {
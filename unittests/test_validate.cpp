@@ -0,0 +1,273 @@
+// MIT License
+//
+// Copyright (c) 2022-2024 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// standard library
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+// Google Test
+#include <gtest/gtest.h>
+
+#if ICUBABY_HAVE_SPAN
+
+using icubaby::char8;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+template <typename Encoding> bool reference_well_formed (std::vector<Encoding> const& input) {
+  icubaby::transcoder<Encoding, char32_t> transcoder;
+  std::vector<char32_t> output;
+  auto out = std::back_inserter (output);
+  for (auto const code_unit : input) {
+    out = transcoder (code_unit, out);
+  }
+  (void)transcoder.end_cp (out);
+  return transcoder.well_formed ();
+}
+
+// Bytes which between them cover every row of the UTF-8 well-formed byte sequence table.
+constexpr std::array const interesting_bytes{0x00, 0x41, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1,
+                                             0xC2, 0xDF, 0xE0, 0xE1, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF4, 0xF5, 0xFF};
+
+// Builds a buffer of ASCII characters with the given sequence placed at the specified offset.
+std::vector<char8> embed (std::vector<std::uint8_t> const& seq, std::size_t const offset, std::size_t const size) {
+  std::vector<char8> result (size, static_cast<char8> ('a'));
+  std::transform (seq.begin (), seq.end (), result.begin () + static_cast<std::ptrdiff_t> (offset),
+                  [] (std::uint8_t const b) { return static_cast<char8> (b); });
+  return result;
+}
+
+// Checks that both the one-shot and the streaming validators agree with the transcoder.
+void check (std::vector<char8> const& input) {
+  auto const expected = reference_well_formed (input);
+  EXPECT_EQ (icubaby::validate<char8> (input), expected);
+
+  // Supply the same input one code unit at a time.
+  icubaby::validator<char8> v;
+  for (auto const cu : input) {
+    (void)v (cu);
+  }
+  EXPECT_EQ (v.end_cp (), expected);
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (Validate, Empty) {
+  EXPECT_TRUE (icubaby::validate<char8> ({}));
+  EXPECT_TRUE (icubaby::validate<char16_t> ({}));
+  EXPECT_TRUE (icubaby::validate<char32_t> ({}));
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf8TwoBytes) {
+  // Every pair of bytes at positions which start, end, and straddle vector block boundaries.
+  for (auto const offset : {std::size_t{15}, std::size_t{31}, std::size_t{46}}) {
+    for (auto b0 = 0U; b0 < 256U; ++b0) {
+      for (auto b1 = 0U; b1 < 256U; ++b1) {
+        check (embed ({static_cast<std::uint8_t> (b0), static_cast<std::uint8_t> (b1)}, offset, 48));
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf8ThreeBytes) {
+  for (auto const offset : {std::size_t{14}, std::size_t{15}, std::size_t{30}, std::size_t{45}}) {
+    for (auto const b0 : interesting_bytes) {
+      for (auto const b1 : interesting_bytes) {
+        for (auto const b2 : interesting_bytes) {
+          check (embed ({static_cast<std::uint8_t> (b0), static_cast<std::uint8_t> (b1), static_cast<std::uint8_t> (b2)},
+                        offset, 48));
+        }
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf8FourBytes) {
+  for (auto const offset : {std::size_t{14}, std::size_t{29}}) {
+    for (auto const b0 : interesting_bytes) {
+      for (auto const b1 : interesting_bytes) {
+        for (auto const b2 : interesting_bytes) {
+          for (auto const b3 : interesting_bytes) {
+            check (embed ({static_cast<std::uint8_t> (b0), static_cast<std::uint8_t> (b1),
+                           static_cast<std::uint8_t> (b2), static_cast<std::uint8_t> (b3)},
+                          offset, 48));
+          }
+        }
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf8Chunked) {
+  // A long run of multi-byte characters split into chunks of every size. Each split can fall in the middle of a code
+  // point.
+  std::vector<char8> input;
+  icubaby::t32_8 encoder;
+  auto out = std::back_inserter (input);
+  for (auto const code_point : {char32_t{'A'}, char32_t{0x00A2}, char32_t{0x0939}, char32_t{0x1F4A9}, char32_t{'z'}}) {
+    for (auto repeat = 0; repeat < 20; ++repeat) {
+      out = encoder (code_point, out);
+    }
+  }
+  auto const check_chunks = [&input] (std::size_t const chunk_size, bool const expected) {
+    icubaby::validator<char8> v;
+    for (auto pos = std::size_t{0}; pos < input.size (); pos += chunk_size) {
+      (void)v (std::span{input}.subspan (pos, std::min (chunk_size, input.size () - pos)));
+    }
+    EXPECT_EQ (v.end_cp (), expected) << "chunk_size=" << chunk_size;
+  };
+  for (auto chunk_size = std::size_t{1}; chunk_size <= 70; ++chunk_size) {
+    check_chunks (chunk_size, true);
+  }
+
+  // Truncate the final code point.
+  input.push_back (static_cast<char8> (0xF0));
+  for (auto chunk_size = std::size_t{1}; chunk_size <= 70; ++chunk_size) {
+    check_chunks (chunk_size, false);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf8PartialState) {
+  icubaby::validator<char8> v;
+  std::array const first{static_cast<char8> ('a'), static_cast<char8> (0xE2), static_cast<char8> (0x82)};
+  EXPECT_TRUE (v (std::span{first}));
+  EXPECT_TRUE (v.partial ());
+  std::array const second{static_cast<char8> (0xAC)};
+  EXPECT_TRUE (v (std::span{second}));
+  EXPECT_FALSE (v.partial ());
+  EXPECT_TRUE (v.end_cp ());
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf16) {
+  EXPECT_TRUE (icubaby::validate<char16_t> (std::u16string_view{u"Hello \U0001F4A9"}));
+  std::vector<char16_t> input{char16_t{'A'}, char16_t{0xD800}};
+  EXPECT_EQ (icubaby::validate<char16_t> (input), reference_well_formed (input));
+  EXPECT_FALSE (icubaby::validate<char16_t> (input));
+  input.push_back (char16_t{0xDC00});
+  EXPECT_TRUE (icubaby::validate<char16_t> (input));
+  input.push_back (char16_t{0xDC00});
+  EXPECT_FALSE (icubaby::validate<char16_t> (input));
+
+  icubaby::validator<char16_t> v;
+  EXPECT_TRUE (v (char16_t{0xD83D}));
+  EXPECT_TRUE (v.partial ());
+  EXPECT_TRUE (v (char16_t{0xDCA9}));
+  EXPECT_FALSE (v.partial ());
+  EXPECT_TRUE (v.end_cp ());
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf32) {
+  EXPECT_TRUE (icubaby::validate<char32_t> (std::u32string_view{U"Hello \U0001F4A9"}));
+  EXPECT_FALSE (icubaby::validate<char32_t> (std::u32string_view{U"\xD800"}));
+  std::vector<char32_t> const too_large{char32_t{'A'}, char32_t{0x110000}};
+  EXPECT_FALSE (icubaby::validate<char32_t> (too_large));
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf8Errors) {
+  // Ill-formed sequences are placed either side of slice boundaries.
+  auto input = embed ({0xE2, 0x82, 0xAC}, 0, 600);
+  std::vector<std::size_t> expected;
+  for (auto const offset : {std::size_t{10}, std::size_t{255}, std::size_t{256}, std::size_t{511}}) {
+    input[offset] = static_cast<char8> (0xFF);
+    expected.push_back (offset);
+  }
+  input[520] = static_cast<char8> (0xC3);  // A lead byte followed by 'a' is detected at the 'a'.
+  expected.push_back (521);
+  input.back () = static_cast<char8> (0xE2);  // A partial code point at the end of the input.
+  expected.push_back (input.size ());
+
+  std::array<std::size_t, 8> offsets{};
+  icubaby::error_recorder errors{std::span{offsets}};
+  EXPECT_FALSE (icubaby::validate<char8> (input, errors));
+  EXPECT_EQ (errors.count (), expected.size ());
+  EXPECT_EQ (errors.first_error (), 10U);
+  EXPECT_TRUE (std::equal (expected.begin (), expected.end (), errors.offsets ().begin (), errors.offsets ().end ()));
+  EXPECT_EQ (errors.offset (), input.size ());
+
+  // The number of errors matches the number of replacement characters produced by a transcoder.
+  icubaby::transcoder<char8, char32_t> transcoder;
+  std::vector<char32_t> output;
+  auto out = std::back_inserter (output);
+  for (auto const code_unit : input) {
+    out = transcoder (code_unit, out);
+  }
+  (void)transcoder.end_cp (out);
+  EXPECT_EQ (static_cast<std::size_t> (std::count (output.begin (), output.end (), icubaby::replacement_char)),
+             errors.count ());
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, ErrorsWellFormed) {
+  icubaby::error_recorder errors;
+  EXPECT_TRUE (icubaby::validate<char16_t> (std::u16string_view{u"Hello \U0001F4A9"}, errors));
+  EXPECT_EQ (errors.count (), 0U);
+  EXPECT_EQ (errors.first_error (), icubaby::error_recorder::npos);
+  EXPECT_TRUE (errors.offsets ().empty ());
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf16Errors) {
+  // A lone low surrogate; a high surrogate followed by a second high surrogate which begins a well-formed pair; a
+  // high surrogate followed by 'A'; a high surrogate at the end of the input.
+  std::vector<char16_t> const input{char16_t{0xDC00}, char16_t{0xD800}, char16_t{0xD83D}, char16_t{0xDCA9},
+                                    char16_t{0xD800}, char16_t{'A'},    char16_t{0xD800}};
+  std::array<std::size_t, 2> offsets{};
+  icubaby::error_recorder errors{std::span{offsets}};
+  EXPECT_FALSE (icubaby::validate<char16_t> (input, errors));
+  EXPECT_EQ (errors.count (), 4U);
+  EXPECT_EQ (errors.first_error (), 0U);
+  ASSERT_EQ (errors.offsets ().size (), 2U);
+  EXPECT_EQ (errors.offsets ()[0], 0U);
+  EXPECT_EQ (errors.offsets ()[1], 2U);
+}
+
+// NOLINTNEXTLINE
+TEST (Validate, Utf32Errors) {
+  std::vector<char32_t> const input{char32_t{'A'}, char32_t{0xD800}, char32_t{'B'}, char32_t{0x110000}};
+  icubaby::error_recorder errors;
+  EXPECT_FALSE (icubaby::validate<char32_t> (input, errors));
+  EXPECT_EQ (errors.count (), 2U);
+  EXPECT_EQ (errors.first_error (), 1U);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+#endif  // ICUBABY_HAVE_SPAN